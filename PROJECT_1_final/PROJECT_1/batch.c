@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>     // For sysconf
+#include <pthread.h>
+#include <time.h>
+
+#include "config.h"
+#include "engine.h"
+#include "batch.h"
+
+// Matches handed to a worker at a time
+#define BATCH_CHUNK 64
+
+typedef struct {
+    pthread_mutex_t lock;
+    int next_match;              // Next match nobody has claimed yet
+    int num_matches;
+    unsigned int base_seed;
+    BatchResult *results;
+} BatchJob;
+
+// Spread consecutive match ids over the seed space
+unsigned int batch_match_seed(unsigned int base_seed, uint32_t match_id) {
+    unsigned int x = base_seed ^ (match_id * 2654435761u);
+    x ^= x >> 16;
+    x *= 0x45d9f3bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Claim the next chunk of matches; returns how many were claimed
+static int claim_chunk(BatchJob *job, int *first) {
+    pthread_mutex_lock(&job->lock);
+    *first = job->next_match;
+    int count = job->num_matches - job->next_match;
+    if (count > BATCH_CHUNK)
+        count = BATCH_CHUNK;
+    job->next_match += count;
+    pthread_mutex_unlock(&job->lock);
+    return count;
+}
+
+// Worker thread: play claimed matches until none are left
+static void *batch_worker(void *arg) {
+    BatchJob *job = arg;
+    Match m;
+
+    if (engine_init_match(&m, &config, 0, 0) != 0)
+        return (void*)1;
+
+    int first, count;
+    while ((count = claim_chunk(job, &first)) > 0) {
+        for (int i = first; i < first + count; i++) {
+            unsigned int seed = batch_match_seed(job->base_seed, (uint32_t)i);
+            engine_reset_match(&m, seed, (int)(seed % 20));
+            int winner = engine_run_match(&m);
+
+            BatchResult *r = &job->results[i];
+            r->match_id = (uint32_t)i;
+            r->winner   = (int16_t)winner;
+            r->rounds   = (uint16_t)(m.team_round_wins[0] + m.team_round_wins[1]);
+            r->duration = (float)m.ticks / (float)TICKS_PER_SECOND;
+        }
+    }
+
+    engine_free_match(&m);
+    return NULL;
+}
+
+// Write the header and all records to out_path
+static int write_results(const char *out_path, const BatchJob *job) {
+    FILE *f = fopen(out_path, "wb");
+    if (!f) {
+        perror("Error opening batch result file");
+        return -1;
+    }
+
+    BatchFileHeader hdr;
+    memcpy(hdr.magic, BATCH_MAGIC, sizeof(hdr.magic));
+    hdr.version   = BATCH_VERSION;
+    hdr.count     = (uint32_t)job->num_matches;
+    hdr.base_seed = job->base_seed;
+
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+             fwrite(job->results, sizeof(BatchResult), job->num_matches, f) == (size_t)job->num_matches;
+    if (fclose(f) != 0)
+        ok = 0;
+    if (!ok) {
+        perror("Error writing batch result file");
+        return -1;
+    }
+    return 0;
+}
+
+int run_batch(int num_matches, const char *out_path, unsigned int base_seed) {
+    BatchJob job;
+    job.next_match  = 0;
+    job.num_matches = num_matches;
+    job.base_seed   = base_seed;
+    job.results     = calloc(num_matches > 0 ? num_matches : 1, sizeof(BatchResult));
+    if (!job.results) {
+        perror("calloc failed");
+        return -1;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+
+    // One worker per online CPU
+    long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_workers < 1)
+        num_workers = 1;
+    pthread_t workers[num_workers];
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int started = 0;
+    for (long i = 0; i < num_workers; i++) {
+        if (pthread_create(&workers[i], NULL, batch_worker, &job) != 0)
+            break;
+        started++;
+    }
+    if (started == 0) {
+        // Fall back to running everything on this thread
+        batch_worker(&job);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < started; i++) {
+        void *ret;
+        pthread_join(workers[i], &ret);
+        if (ret != NULL)
+            failed = 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pthread_mutex_destroy(&job.lock);
+
+    if (failed || job.next_match < num_matches) {
+        fprintf(stderr, "Batch workers failed to allocate their matches\n");
+        free(job.results);
+        return -1;
+    }
+
+    // Summary of the batch
+    int wins[NUM_TEAMS] = {0, 0};
+    int ties = 0;
+    for (int i = 0; i < num_matches; i++) {
+        if (job.results[i].winner < 0)
+            ties++;
+        else
+            wins[job.results[i].winner]++;
+    }
+    double secs = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("=== BATCH COMPLETE ===\n");
+    printf("Matches: %d on %d thread(s) in %.3f s (%.0f matches/min)\n",
+           num_matches, started > 0 ? started : 1, secs,
+           secs > 0 ? num_matches * 60.0 / secs : 0.0);
+    printf("Team 1 wins: %d, Team 2 wins: %d, Ties: %d\n", wins[0], wins[1], ties);
+
+    int rc = write_results(out_path, &job);
+    if (rc == 0)
+        printf("Results written to %s\n", out_path);
+    free(job.results);
+    return rc;
+}
@@ -0,0 +1,40 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+
+// ----------------------------------------------------------
+// Headless batch runner
+//  Plays many matches with the engine on a pool of threads
+//  (one per online CPU) and writes one record per match.
+//
+// Result file layout (little-endian, packed):
+//   BatchFileHeader                       16 bytes
+//   BatchResult[count]                    12 bytes each, by match_id
+// ----------------------------------------------------------
+
+#define BATCH_MAGIC   "TOWB"
+#define BATCH_VERSION 1
+
+typedef struct {
+    char     magic[4];       // "TOWB"
+    uint32_t version;        // BATCH_VERSION
+    uint32_t count;          // Number of BatchResult records
+    uint32_t base_seed;      // Match i was seeded from base_seed and i
+} BatchFileHeader;
+
+typedef struct {
+    uint32_t match_id;
+    int16_t  winner;         // 0 or 1, -1 for a tie
+    uint16_t rounds;         // Rounds completed
+    float    duration;       // Game seconds until the match was decided
+} BatchResult;
+
+// Seed used for match number match_id of a batch
+unsigned int batch_match_seed(unsigned int base_seed, uint32_t match_id);
+
+// Run num_matches matches and write the results to out_path.
+// Returns 0 on success, -1 on error.
+int run_batch(int num_matches, const char *out_path, unsigned int base_seed);
+
+#endif /* BATCH_H */
@@ -61,4 +61,11 @@ void initialize_config(const char *config_file) {
         }
     }
     fclose(file);
+
+    // Reject values the game cannot be played with
+    if (config.players_per_team < 1 || config.range < 1 ||
+        config.fall_recovery_max < config.fall_recovery_min) {
+        fprintf(stderr, "Invalid configuration in %s\n", config_file);
+        exit(EXIT_FAILURE);
+    }
 }
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>     // For the shared block
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "energy_reports.h"
+#include "game_clock.h"   // monotonic_ns
+
+#define ALIGN_UP(n) (((n) + ROSTER_ALIGN - 1) & ~(size_t)(ROSTER_ALIGN - 1))
+
+// Shared (not process-private) futex calls: the words live in a
+// MAP_SHARED block used by forked processes
+static int futex_wait(uint32_t *word, uint32_t expected) {
+    return (int)syscall(SYS_futex, word, FUTEX_WAIT, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(uint32_t *word, int count) {
+    syscall(SYS_futex, word, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+static Mailbox *ring_at(EnergyReports *er, int producer) {
+    return (Mailbox *)((char *)er + er->ring_offset) + producer;
+}
+
+static float *chunk_sums(EnergyReports *er) {
+    return (float *)((char *)er + er->sums_offset);
+}
+
+EnergyReports *energy_reports_create(int num_teams, int players_per_team, int chunk,
+                                     int num_producers) {
+    int chunks_per_team = (players_per_team + chunk - 1) / chunk;
+    int num_chunks = num_teams * chunks_per_team;
+    if (num_producers < 1 || num_producers > num_chunks) {
+        fprintf(stderr, "energy reports: %d producers for %d chunks\n", num_producers, num_chunks);
+        return NULL;
+    }
+
+    size_t ring_offset = ALIGN_UP(sizeof(EnergyReports));
+    size_t sums_offset = ALIGN_UP(ring_offset + (size_t)num_producers * sizeof(Mailbox));
+    size_t map_size    = sums_offset + (size_t)num_chunks * sizeof(float);
+
+    int done_fd = eventfd(0, EFD_NONBLOCK);
+    if (done_fd < 0) {
+        perror("eventfd");
+        return NULL;
+    }
+    void *map_ptr = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (map_ptr == MAP_FAILED) {
+        perror("mmap failed");
+        close(done_fd);
+        return NULL;
+    }
+
+    // Anonymous mappings come back zeroed: empty rings, nothing posted
+    EnergyReports *er = map_ptr;
+    er->num_producers    = num_producers;
+    er->num_teams        = num_teams;
+    er->players_per_team = players_per_team;
+    er->chunk            = chunk;
+    er->chunks_per_team  = chunks_per_team;
+    er->num_chunks       = num_chunks;
+    er->ring_offset      = ring_offset;
+    er->sums_offset      = sums_offset;
+    er->map_size         = map_size;
+    er->done_fd          = done_fd;
+    return er;
+}
+
+void energy_reports_destroy(EnergyReports *er) {
+    if (er) {
+        close(er->done_fd);
+        munmap(er, er->map_size);
+    }
+}
+
+void energy_reports_range(const EnergyReports *er, int producer, int *first, int *last) {
+    *first = (int)((long)er->num_chunks * producer / er->num_producers);
+    *last  = (int)((long)er->num_chunks * (producer + 1) / er->num_producers);
+}
+
+// Chunks are team-major like the players, so a run of chunks is a run of players
+void energy_reports_players(const EnergyReports *er, int first, int last,
+                            int *first_player, int *last_player) {
+    int ppt = er->players_per_team;
+    int t0 = first / er->chunks_per_team, k0 = first % er->chunks_per_team;
+    int t1 = (last - 1) / er->chunks_per_team, k1 = (last - 1) % er->chunks_per_team;
+    int end = (k1 + 1) * er->chunk;
+    *first_player = t0 * ppt + k0 * er->chunk;
+    *last_player  = t1 * ppt + (end < ppt ? end : ppt);
+}
+
+// --------------------------------------------------------------------
+// Producer side
+// --------------------------------------------------------------------
+uint32_t energy_reports_bell(const EnergyReports *er) {
+    return __atomic_load_n(&er->bell, __ATOMIC_ACQUIRE);
+}
+
+// A tick newer than *done has been posted; *done moves on to it
+int energy_reports_pending(const EnergyReports *er, uint32_t *done) {
+    uint32_t gen = __atomic_load_n(&er->generation, __ATOMIC_ACQUIRE);
+    if (gen == *done)
+        return 0;
+    *done = gen;
+    return 1;
+}
+
+// Returns at once if the bell moved since it was read; signals just
+// cut the sleep short
+void energy_reports_sleep(EnergyReports *er, uint32_t bell) {
+    futex_wait(&er->bell, bell);
+}
+
+void energy_reports_produce(EnergyReports *er, Roster *r, const TickKernel *kernel,
+                            int producer, uint32_t gen) {
+    float *sums = chunk_sums(er);
+    int first, last;
+    energy_reports_range(er, producer, &first, &last);
+
+    for (int c = first; c < last; c++) {
+        int t = c / er->chunks_per_team;
+        int p = (c % er->chunks_per_team) * er->chunk;
+        int n = er->players_per_team - p < er->chunk ? er->players_per_team - p : er->chunk;
+        int off = ROSTER_INDEX(r, t, p);
+        sums[c] = kernel->run(r->energy + off, r->effort + off, r->decay_rate + off,
+                              r->position + off, r->state + off, n);
+    }
+
+    // The report publishes the sums; the last producer in wakes the referee
+    MailboxMsg msg = { ENERGY_MSG_REPORT, (int32_t)gen };
+    mailbox_push(ring_at(er, producer), msg);   // One per tick, drained every tick
+    if (__atomic_sub_fetch(&er->outstanding, 1, __ATOMIC_ACQ_REL) == 0) {
+        uint64_t one = 1;
+        if (write(er->done_fd, &one, sizeof(one)) != (ssize_t)sizeof(one))
+            perror("energy reports: eventfd write");
+    }
+}
+
+int energy_reports_next_result(EnergyReports *er, uint32_t *seen, MatchResult *out,
+                               uint64_t *missed) {
+    for (;;) {
+        uint32_t gen = __atomic_load_n(&er->result_generation, __ATOMIC_ACQUIRE);
+        if (gen == *seen)
+            return 0;
+        // The slot of result g is rewritten while g + RESULT_SLOTS is being
+        // announced, so only the last RESULT_SLOTS - 1 are safe to read
+        if (gen - *seen > RESULT_SLOTS - 1) {
+            if (missed)
+                *missed += gen - *seen - (RESULT_SLOTS - 1);
+            *seen = gen - (RESULT_SLOTS - 1);
+        }
+
+        uint32_t next = *seen + 1;
+        *out = er->results[next % RESULT_SLOTS];
+
+        // Still safe after the copy, or it may be torn: look again
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&er->result_generation, __ATOMIC_RELAXED) - *seen > RESULT_SLOTS - 1)
+            continue;
+        *seen = next;
+
+        int64_t latency = monotonic_ns() - out->announced_ns;
+        int64_t worst = __atomic_load_n(&er->max_result_latency_ns, __ATOMIC_RELAXED);
+        while (latency > worst &&
+               !__atomic_compare_exchange_n(&er->max_result_latency_ns, &worst, latency, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            // worst was reloaded; try again while this one is still larger
+        }
+        return 1;
+    }
+}
+
+// --------------------------------------------------------------------
+// Referee side
+// --------------------------------------------------------------------
+void energy_reports_announce(EnergyReports *er, int kind, int winning_team) {
+    uint32_t next = er->result_generation + 1;
+    MatchResult *slot = &er->results[next % RESULT_SLOTS];
+    slot->kind = kind;
+    slot->winning_team = winning_team;
+    slot->announced_ns = monotonic_ns();
+    __atomic_store_n(&er->result_generation, next, __ATOMIC_RELEASE);
+    energy_reports_ring(er);
+}
+
+void energy_reports_ring(EnergyReports *er) {
+    __atomic_add_fetch(&er->bell, 1, __ATOMIC_RELEASE);
+    futex_wake(&er->bell, INT_MAX);
+}
+
+void energy_reports_post(EnergyReports *er) {
+    __atomic_store_n(&er->outstanding, (uint32_t)er->num_producers, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&er->generation, 1, __ATOMIC_RELEASE);
+    energy_reports_ring(er);
+}
+
+int energy_reports_done(const EnergyReports *er) {
+    return __atomic_load_n(&er->outstanding, __ATOMIC_ACQUIRE) == 0;
+}
+
+// The count can hit 0 just before the last producer writes done_fd, so
+// a wake-up may also turn up after the reports were gathered
+void energy_reports_ack(EnergyReports *er) {
+    uint64_t wakes;
+    if (read(er->done_fd, &wakes, sizeof(wakes)) < 0 && errno != EAGAIN)
+        perror("energy reports: eventfd read");
+}
+
+void energy_reports_gather(EnergyReports *er, float *team_efforts) {
+    // Every producer has reported this tick; older reports are stragglers
+    uint32_t gen = er->generation;
+    for (int p = 0; p < er->num_producers; p++) {
+        MailboxMsg msg;
+        while (mailbox_pop(ring_at(er, p), &msg)) {
+            if (msg.type != ENERGY_MSG_REPORT || (uint32_t)msg.arg != gen)
+                er->late++;
+        }
+    }
+
+    const float *sums = chunk_sums(er);
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        float total = 0.0f;
+        if (t < er->num_teams) {
+            for (int k = 0; k < er->chunks_per_team; k++) {
+                total += sums[t * er->chunks_per_team + k];
+            }
+        }
+        team_efforts[t] = total;
+    }
+}
+
+void energy_reports_close(EnergyReports *er) {
+    __atomic_store_n(&er->closed, 1, __ATOMIC_RELEASE);
+    energy_reports_ring(er);
+}
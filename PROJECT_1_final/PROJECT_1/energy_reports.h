@@ -0,0 +1,126 @@
+#ifndef ENERGY_REPORTS_H
+#define ENERGY_REPORTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"     // NUM_TEAMS, Roster, TickKernel
+#include "mailbox.h"
+
+// ----------------------------------------------------------
+// Energy reports
+//  Players evolve their own energy and effort. The roster
+//  sits in shared memory (engine_init_match_shared) and is cut
+//  into chunks of a fixed number of players; every producer (a
+//  player process, or a pool worker running a slice of player
+//  tasks) owns a fixed run of chunks.
+//
+//  Per tick the referee, once falls and recoveries are done,
+//  posts the tick: it arms a countdown of producers, bumps the
+//  generation and rings the bell, a futex all producers sleep
+//  on. Each producer runs the fused tick kernel over its
+//  chunks, stores every chunk's effort sum, pushes one report
+//  into its own SPSC ring and counts down; the last one
+//  writes done_fd, an eventfd the referee waits on in its
+//  event loop, which then only adds the chunk sums up in chunk
+//  order.
+//
+//  Round and match results travel the same way: the referee
+//  writes the result into a small ring, bumps the result
+//  generation and rings the bell once, so every player hears
+//  it after one syscall whatever the team size. Players catch
+//  up from the last generation they saw.
+//
+//  Team totals depend on the chunk size but not on how many
+//  producers there are. They can differ from the referee's own
+//  pass (engine_update_energy) in the last bits, since they
+//  are added up per chunk.
+//
+// Shared block layout:
+//   EnergyReports header
+//   Mailbox  ring[num_producers]          at ring_offset
+//   float    chunk_effort[num_chunks]     at sums_offset
+// ----------------------------------------------------------
+
+#define ENERGY_CHUNK 64                 // Players per chunk for pool workers
+#define ENERGY_MSG_REPORT 1             // Producer -> referee; arg = generation
+
+#define RESULT_SLOTS 8                  // A player may fall RESULT_SLOTS - 1 results behind
+#define RESULT_ROUND 1
+#define RESULT_MATCH 2
+
+typedef struct {
+    int32_t kind;                       // RESULT_*
+    int32_t winning_team;
+    int64_t announced_ns;               // Monotonic time of the announcement
+} MatchResult;
+
+typedef struct {
+    // Written by the referee
+    uint32_t bell;                      // Futex word: bumped for every tick and event
+    uint32_t generation;                // Ticks posted so far
+    int32_t  closed;                    // Match over, producers leave
+    uint32_t result_generation;         // Results announced so far
+    MatchResult results[RESULT_SLOTS];  // Result g is in results[g % RESULT_SLOTS]
+
+    // Counted down by the producers
+    uint32_t outstanding __attribute__((aligned(64)));
+    int      done_fd;                   // eventfd, written when outstanding hits 0
+
+    // Shape, fixed at creation
+    int    num_producers;
+    int    num_teams;
+    int    players_per_team;
+    int    chunk;                       // Players per chunk
+    int    chunks_per_team;
+    int    num_chunks;
+    size_t ring_offset;
+    size_t sums_offset;
+    size_t map_size;
+
+    uint64_t late;                      // Reports found for an older tick
+
+    // Updated by the players
+    int32_t  match_heard;               // Player processes that saw the match result
+    int64_t  max_result_latency_ns;     // Worst announcement-to-seen time
+} EnergyReports;
+
+// Map an anonymous shared block and its eventfd (both inherited across fork)
+EnergyReports *energy_reports_create(int num_teams, int players_per_team, int chunk,
+                                     int num_producers);
+void energy_reports_destroy(EnergyReports *er);
+
+// Chunks [*first, *last) of a producer, and the players they hold as
+// team-major indices (team * players_per_team + player)
+void energy_reports_range(const EnergyReports *er, int producer, int *first, int *last);
+void energy_reports_players(const EnergyReports *er, int first, int last,
+                            int *first_player, int *last_player);
+
+// Producer side: read the bell, check for work, sleep until the bell moves
+uint32_t energy_reports_bell(const EnergyReports *er);
+int  energy_reports_pending(const EnergyReports *er, uint32_t *done);
+void energy_reports_sleep(EnergyReports *er, uint32_t bell);
+
+// Play tick generation 'gen' for the producer's chunks and report it
+void energy_reports_produce(EnergyReports *er, Roster *r, const TickKernel *kernel,
+                            int producer, uint32_t gen);
+
+// Next result after *seen: returns 1 and moves *seen on, 0 if there is
+// none. Results overwritten before they were read count into *missed.
+int  energy_reports_next_result(EnergyReports *er, uint32_t *seen, MatchResult *out,
+                                uint64_t *missed);
+
+// Referee side: post a tick, wait for done_fd until every report is in,
+// then gather the team totals. ack drains done_fd whenever it is readable.
+void energy_reports_post(EnergyReports *er);
+int  energy_reports_done(const EnergyReports *er);
+void energy_reports_ack(EnergyReports *er);
+void energy_reports_gather(EnergyReports *er, float *team_efforts);
+
+// Announce a round or match result to every player with one wake-up
+void energy_reports_announce(EnergyReports *er, int kind, int winning_team);
+
+// Wake every producer without posting a tick (close)
+void energy_reports_ring(EnergyReports *er);
+void energy_reports_close(EnergyReports *er);
+
+#endif /* ENERGY_REPORTS_H */
@@ -0,0 +1,703 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>   // For the shared roster mapping
+
+#include "engine.h"
+#include "game_clock.h"   // monotonic_ns, for alignment deadlines
+
+static void schedule_fall(Match *m, int i, int64_t first_check);
+
+// --------------------------------------------------------------------
+// Allocation and initialization
+// --------------------------------------------------------------------
+
+static int init_match(Match *m, const GameConfig *cfg, unsigned int seed, int energy_bias,
+                      int shared, const Roster *on) {
+    memset(m, 0, sizeof(*m));
+    m->cfg = cfg;
+
+    // One aligned block holds every player array of every team
+    size_t size = roster_block_size(cfg->num_teams, cfg->players_per_team);
+    if (on) {
+        m->roster = *on;
+    } else if (shared) {
+        void *block = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED)
+            return -1;
+        m->roster_block = block;
+        m->roster_mapped = size;
+    } else if (posix_memalign(&m->roster_block, ROSTER_ALIGN, size) != 0) {
+        m->roster_block = NULL;
+        return -1;
+    }
+    if (!on) {
+        memset(m->roster_block, 0, size);
+        roster_bind(&m->roster, m->roster_block, cfg->num_teams, cfg->players_per_team);
+    }
+    m->kernel = tick_kernel_select();
+
+    // One timer per roster slot in each wheel
+    int capacity = m->roster.num_teams * m->roster.stride;
+    if (timer_wheel_init(&m->fall_wheel, capacity) != 0 ||
+        timer_wheel_init(&m->recover_wheel, capacity) != 0) {
+        engine_free_match(m);
+        return -1;
+    }
+
+    m->dirty = calloc(capacity, sizeof(uint8_t));
+    m->dirty_list = malloc(capacity * sizeof(int32_t));
+    if (!m->dirty || !m->dirty_list) {
+        engine_free_match(m);
+        return -1;
+    }
+
+    engine_reset_match(m, seed, energy_bias);
+    return 0;
+}
+
+// Allocate the rosters for a match and deal the starting values
+int engine_init_match(Match *m, const GameConfig *cfg, unsigned int seed, int energy_bias) {
+    return init_match(m, cfg, seed, energy_bias, 0, NULL);
+}
+
+// Same, with the rosters in a shared mapping that forked players inherit
+int engine_init_match_shared(Match *m, const GameConfig *cfg, unsigned int seed, int energy_bias) {
+    return init_match(m, cfg, seed, energy_bias, 1, NULL);
+}
+
+// Same, on roster arrays the caller owns and keeps zeroed outside the
+// players (a view of a larger roster, see roster_view())
+int engine_init_match_on(Match *m, const GameConfig *cfg, const Roster *roster,
+                         unsigned int seed, int energy_bias) {
+    return init_match(m, cfg, seed, energy_bias, 0, roster);
+}
+
+// Put an allocated match back to its starting state.
+// energy_bias plays the role of the wall-clock second the referee mixes into
+// the starting energy (0..19).
+void engine_reset_match(Match *m, unsigned int seed, int energy_bias) {
+    int team_bias[NUM_TEAMS];
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        team_bias[t] = energy_bias;
+    }
+    engine_reset_match_teams(m, seed, team_bias);
+}
+
+// Same, with a bias of its own for every team (tournament teams)
+void engine_reset_match_teams(Match *m, unsigned int seed, const int *team_bias) {
+    const GameConfig *cfg = m->cfg;
+    Roster *r = &m->roster;
+
+    m->seed = seed;
+    m->rope_position = 0.0f;
+    m->round_number = 1;
+    m->game_active = 1;
+    m->round_winner = -1;
+    m->winner = -1;
+    m->ticks = 0;
+    m->countdown_ticks = 0;
+    m->countdown_new_round = 0;
+    engine_mark_all_dirty(m);
+    timer_wheel_reset(&m->fall_wheel, 0);
+    timer_wheel_reset(&m->recover_wheel, 0);
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        m->team_efforts[t] = 0.0f;
+        m->team_round_wins[t] = 0;
+        m->team_consecutive_wins[t] = 0;
+        m->team_pulling[t] = (t < cfg->num_teams) ? cfg->players_per_team : 0;
+    }
+
+    // Initialize each player's parameters
+    for (int t = 0; t < cfg->num_teams; t++) {
+        for (int p = 0; p < cfg->players_per_team; p++) {
+            int i = ROSTER_INDEX(r, t, p);
+
+            // Calculate starting energy with some randomness
+            float en = cfg->minimum_energy + (rand_r(&m->seed) % cfg->range) + (team_bias[t] % 20);
+            // Generate a decay rate randomly
+            float dr = 0.5f + (float)(rand_r(&m->seed) % 16) / 10.0f;
+
+            r->energy[i]       = en;
+            r->effort[i]       = en;   // Initially, effort = energy
+            r->decay_rate[i]   = dr;
+            r->position[i]     = p + 1;
+            r->state[i]        = PLAYER_ACTIVE;
+            r->recover_tick[i] = 0;
+            r->pid[i]          = 0;
+
+            // Everybody can fall from the first tick on
+            schedule_fall(m, i, 0);
+        }
+    }
+}
+
+// Release the rosters of a match
+void engine_free_match(Match *m) {
+    if (m->roster_mapped)
+        munmap(m->roster_block, m->roster_mapped);
+    else
+        free(m->roster_block);
+    m->roster_mapped = 0;
+    m->roster_block = NULL;
+    timer_wheel_free(&m->fall_wheel);
+    timer_wheel_free(&m->recover_wheel);
+    free(m->dirty);
+    free(m->dirty_list);
+    m->dirty = NULL;
+    m->dirty_list = NULL;
+}
+
+// Copy a match in play: players, score and clock. Both matches must be
+// allocated for the same team sizes; dst's timers are not touched.
+void engine_copy_state(Match *dst, const Match *src) {
+    if (dst->roster_block && src->roster_block) {
+        memcpy(dst->roster_block, src->roster_block,
+               roster_block_size(src->roster.num_teams, src->roster.players_per_team));
+    } else {
+        for (int t = 0; t < src->roster.num_teams; t++) {
+            roster_copy_team(&dst->roster, &src->roster, t);
+        }
+    }
+    dst->cfg           = src->cfg;
+    dst->rope_position = src->rope_position;
+    dst->round_number  = src->round_number;
+    dst->game_active   = src->game_active;
+    dst->round_winner  = src->round_winner;
+    dst->winner        = src->winner;
+    dst->ticks         = src->ticks;
+    dst->countdown_ticks     = src->countdown_ticks;
+    dst->countdown_new_round = src->countdown_new_round;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        dst->team_efforts[t]          = src->team_efforts[t];
+        dst->team_round_wins[t]       = src->team_round_wins[t];
+        dst->team_consecutive_wins[t] = src->team_consecutive_wins[t];
+        dst->team_pulling[t]          = src->team_pulling[t];
+    }
+}
+
+// Continue src's match in dst with its own random draws. Recoveries keep
+// their end tick; the falls still to come are drawn afresh, which is
+// exact since the wait for a fall is memoryless.
+void engine_fork_match(Match *dst, const Match *src, unsigned int seed) {
+    engine_copy_state(dst, src);
+    dst->seed = seed;
+    engine_clear_changes(dst);
+    timer_wheel_reset(&dst->fall_wheel, dst->ticks);
+    timer_wheel_reset(&dst->recover_wheel, dst->ticks);
+
+    Roster *r = &dst->roster;
+    for (int t = 0; t < r->num_teams; t++) {
+        for (int i = t * r->stride; i < t * r->stride + r->players_per_team; i++) {
+            if (r->state[i] & PLAYER_RECOVERING)
+                timer_wheel_schedule(&dst->recover_wheel, i, r->recover_tick[i]);
+            else if (PLAYER_PULLING(r->state[i]))
+                schedule_fall(dst, i, dst->ticks);
+        }
+    }
+}
+
+// --------------------------------------------------------------------
+// Change tracking
+// --------------------------------------------------------------------
+
+void engine_mark_dirty(Match *m, int i) {
+    if (!m->dirty[i]) {
+        m->dirty[i] = 1;
+        m->dirty_list[m->dirty_count++] = i;
+    }
+}
+
+void engine_mark_all_dirty(Match *m) {
+    m->all_dirty = 1;
+}
+
+void engine_clear_changes(Match *m) {
+    for (int k = 0; k < m->dirty_count; k++) {
+        m->dirty[m->dirty_list[k]] = 0;
+    }
+    m->dirty_count = 0;
+    m->all_dirty = 0;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        m->hot_dirty[t] = 0;
+    }
+}
+
+// --------------------------------------------------------------------
+// Per-tick phases
+// --------------------------------------------------------------------
+
+// --------------------------------------------------------------------
+// Falls and recoveries
+//  A standing player falls on each tick with probability
+//  p = fall_probability / TICKS_PER_SECOND. Instead of drawing that
+//  Bernoulli for everyone on every tick, the number of ticks until the
+//  next fall is drawn once: it is geometric with parameter p, the
+//  discrete counterpart of an exponential waiting time. Falls and the
+//  recoveries that follow are timers in two wheels, so a tick only
+//  costs as much as the events that happen on it.
+// --------------------------------------------------------------------
+
+// Ticks from the first check until the check that makes the player fall
+// (0 = the first one), or -1 if players never fall
+static int64_t sample_fall_delay(Match *m) {
+    double p = m->cfg->fall_probability / (float)TICKS_PER_SECOND;
+    if (p <= 0.0)
+        return -1;
+    if (p >= 1.0)
+        return 0;
+
+    // Inverse transform of a uniform in (0, 1]
+    double u = ((double)rand_r(&m->seed) + 1.0) / ((double)RAND_MAX + 1.0);
+    return (int64_t)floor(log(u) / log1p(-p));
+}
+
+// Schedule the next fall of player i, counting from tick first_check
+static void schedule_fall(Match *m, int i, int64_t first_check) {
+    int64_t delay = sample_fall_delay(m);
+    if (delay >= 0)
+        timer_wheel_schedule(&m->fall_wheel, i, first_check + delay);
+}
+
+// Fall timer expired: the player goes down for a few whole seconds
+static void on_fall(void *ctx, int i, int64_t tick) {
+    Match *m = ctx;
+    const GameConfig *cfg = m->cfg;
+    Roster *r = &m->roster;
+
+    if (!PLAYER_PULLING(r->state[i]))
+        return;
+    r->state[i] |= PLAYER_RECOVERING;
+    r->effort[i] = 0.0f;
+    engine_mark_dirty(m, i);
+    if (i / r->stride < NUM_TEAMS)
+        m->team_pulling[i / r->stride]--;
+
+    int seconds = (rand_r(&m->seed) % (cfg->fall_recovery_max - cfg->fall_recovery_min + 1))
+                  + cfg->fall_recovery_min;
+    r->recover_tick[i] = tick + (int64_t)seconds * TICKS_PER_SECOND;
+    timer_wheel_schedule(&m->recover_wheel, i, r->recover_tick[i]);
+}
+
+// Recovery timer expired: back up and pulling from the next tick
+static void on_recover(void *ctx, int i, int64_t tick) {
+    Match *m = ctx;
+    Roster *r = &m->roster;
+
+    r->state[i] &= ~PLAYER_RECOVERING;   // Mark player as recovered
+    r->effort[i] = r->energy[i];         // Set effort equal to current energy
+    engine_mark_dirty(m, i);
+    if (i / r->stride < NUM_TEAMS)
+        m->team_pulling[i / r->stride]++;
+    schedule_fall(m, i, tick + 1);
+}
+
+// A fall that comes due while no ticks are played does not happen; the
+// wait is memoryless, so drawing a fresh one from the next tick is exact
+static void on_fall_skipped(void *ctx, int i, int64_t tick) {
+    Match *m = ctx;
+    (void)tick;
+    schedule_fall(m, i, m->ticks);
+}
+
+// Knock over the players whose fall is due this tick
+void engine_check_player_falls(Match *m) {
+    timer_wheel_advance(&m->fall_wheel, m->ticks, on_fall, m);
+}
+
+// Get up the players whose recovery ends this tick
+void engine_recover_players(Match *m) {
+    timer_wheel_advance(&m->recover_wheel, m->ticks, on_recover, m);
+}
+
+// Countdowns: recoveries keep running, falls wait for the next tick
+void engine_skip_time(Match *m, int64_t ticks) {
+    if (ticks <= 0)
+        return;
+    int64_t last = m->ticks + ticks - 1;
+    timer_wheel_advance(&m->recover_wheel, last, on_recover, m);
+    m->ticks += ticks;
+    timer_wheel_advance(&m->fall_wheel, last, on_fall_skipped, m);
+}
+
+// Update the energy and effort of active, non-recovering players.
+// The same pass adds up each team's effort for engine_update_rope().
+void engine_update_energy(Match *m) {
+    Roster *r = &m->roster;
+    for (int t = 0; t < r->num_teams; t++) {
+        // Whole stride: padding lanes are inactive and add nothing
+        int off = t * r->stride;
+        float total = m->kernel->run(r->energy + off, r->effort + off,
+                                     r->decay_rate + off, r->position + off,
+                                     r->state + off, r->stride);
+        if (t < NUM_TEAMS) {
+            m->team_efforts[t] = total;
+            if (m->team_pulling[t] > 0)
+                m->hot_dirty[t] = 1;
+        }
+    }
+}
+
+// Take team efforts the players summed up themselves this tick, in
+// place of engine_update_energy()
+void engine_set_team_efforts(Match *m, const float *team_efforts) {
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        m->team_efforts[t] = team_efforts[t];
+        if (m->team_pulling[t] > 0)
+            m->hot_dirty[t] = 1;
+    }
+}
+
+// Move the rope according to the team efforts summed up by
+// engine_update_energy() this tick
+void engine_update_rope(Match *m) {
+    const GameConfig *cfg = m->cfg;
+
+    // Determine how much the rope moves this tick based on effort difference
+    float diff = m->team_efforts[0] - m->team_efforts[1];
+    float increment = (diff * 0.05f) / (float)TICKS_PER_SECOND;
+    m->rope_position -= increment;
+
+    // Clamp rope position within allowed threshold
+    if (m->rope_position > cfg->rope_threshold)
+        m->rope_position = cfg->rope_threshold;
+    if (m->rope_position < -cfg->rope_threshold)
+        m->rope_position = -cfg->rope_threshold;
+}
+
+// --------------------------------------------------------------------
+// Round handling
+// --------------------------------------------------------------------
+
+// Check whether the current round is over and book the result.
+// The caller is responsible for announcing it and, on ROUND_WON, for
+// aligning the teams and calling engine_start_new_round().
+RoundResult engine_check_round_winner(Match *m) {
+    const GameConfig *cfg = m->cfg;
+    int allExhausted = 1;
+
+    // Check if all players from both teams are out of energy
+    const Roster *r = &m->roster;
+    for (int t = 0; t < r->num_teams && allExhausted; t++) {
+        for (int i = t * r->stride; i < t * r->stride + r->players_per_team; i++) {
+            if (r->energy[i] > 0) {
+                allExhausted = 0;
+                break;
+            }
+        }
+    }
+
+    if (fabs(m->rope_position) >= cfg->round_win_threshold || allExhausted) {
+        // Decide winner based on rope position
+        int winning_team = (m->rope_position > 0) ? 1 : 0;
+        m->round_winner = winning_team;
+        m->team_round_wins[winning_team]++;
+
+        if (allExhausted) {
+            m->game_active = 0;
+            m->winner = winning_team;
+            return MATCH_EXHAUSTED;
+        }
+
+        m->team_consecutive_wins[winning_team]++;
+        for (int t = 0; t < NUM_TEAMS; t++) {
+            if (t != winning_team)
+                m->team_consecutive_wins[t] = 0;
+        }
+
+        if (m->team_consecutive_wins[winning_team] >= cfg->consecutive_rounds_to_win) {
+            m->game_active = 0;
+            m->winner = winning_team;
+            return MATCH_WON;
+        }
+        return ROUND_WON;
+    }
+    return ROUND_NONE;
+}
+
+// --------------------------------------------------------------------
+// Alignment
+//  Players are lined up by a sort key, highest key at the highest
+//  position (position n pulls hardest: effort = energy * position).
+//  The greedy rule keys on the current energy. The keys are sorted
+//  with an LSD radix sort over their float bits, O(n) and stable, so
+//  equal keys keep player order.
+// --------------------------------------------------------------------
+
+// Float bits that order like the floats themselves
+static uint32_t sort_bits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : u | 0x80000000u;
+}
+
+// indices[0..n) = 0..n-1 in ascending key order; tmp holds 3n words
+static void sort_by_key(const float *key, int n, int *indices, uint32_t *tmp) {
+    uint32_t *bits = tmp, *bits_tmp = tmp + n;
+    int *idx_tmp = (int *)(tmp + 2 * n);
+    for (int i = 0; i < n; i++) {
+        bits[i] = sort_bits(key[i]);
+        indices[i] = i;
+    }
+    for (int shift = 0; shift < 32; shift += 8) {
+        int count[257] = {0};
+        for (int i = 0; i < n; i++) {
+            count[((bits[i] >> shift) & 0xff) + 1]++;
+        }
+        if (count[((bits[0] >> shift) & 0xff) + 1] == n)
+            continue;   // Every key has this byte in common
+        for (int b = 0; b < 256; b++) {
+            count[b + 1] += count[b];
+        }
+        for (int i = 0; i < n; i++) {
+            int at = count[(bits[i] >> shift) & 0xff]++;
+            bits_tmp[at] = bits[i];
+            idx_tmp[at] = indices[i];
+        }
+        memcpy(bits, bits_tmp, n * sizeof(uint32_t));
+        memcpy(indices, idx_tmp, n * sizeof(int));
+    }
+}
+
+// Line a team up in ascending key order and recalculate its efforts
+static void apply_order(Match *m, int team_index, const int *ascending, int *new_order) {
+    Roster *r = &m->roster;
+    int n = r->players_per_team;
+    float *energy = r->energy + team_index * r->stride;
+    int32_t *position = r->position + team_index * r->stride;
+    float *effort = r->effort + team_index * r->stride;
+
+    for (int i = 0; i < n; i++) {
+        int idx = ascending[i];
+        int32_t pos = i + 1;
+        float ef = energy[idx] * (float)pos;
+        if (position[idx] != pos || effort[idx] != ef)
+            engine_mark_dirty(m, ROSTER_INDEX(r, team_index, idx));
+        position[idx] = pos;
+        effort[idx] = ef;
+    }
+
+    // Line order as listed: Team 1 from the rope outwards, Team 2
+    // from its far end towards the rope
+    if (new_order) {
+        for (int i = 0; i < n; i++) {
+            new_order[i] = (team_index == 0) ? ascending[n - 1 - i] : ascending[i];
+        }
+    }
+}
+
+// Align players on a single team by sorting them by energy.
+// If new_order is not NULL it receives the player indices in line order.
+int engine_align_team(Match *m, int team_index, int *new_order) {
+    Roster *r = &m->roster;
+    int n = r->players_per_team;
+    int *indices = malloc(n * (sizeof(int) + 3 * sizeof(uint32_t)));
+    if (!indices)
+        return -1;   // Keep the current order
+
+    sort_by_key(r->energy + team_index * r->stride, n, indices, (uint32_t *)(indices + n));
+    apply_order(m, team_index, indices, new_order);
+    free(indices);
+    return 0;
+}
+
+// Energy a player is expected to put into the next horizon_ticks ticks
+// (times its position, that is its share of the team's effort). It only
+// pulls, and only tires, while standing: a fraction 'standing' of the
+// ticks once any recovery still running is over.
+static float expected_energy(float energy, float decay_per_tick, double standing,
+                             int64_t delay, int64_t horizon_ticks) {
+    double u = standing * (double)(horizon_ticks - delay);
+    if (u <= 0.0 || energy <= 0.0f)
+        return 0.0f;
+    if (decay_per_tick <= 0.0f || decay_per_tick * u <= energy)
+        return (float)(energy * u - 0.5 * decay_per_tick * u * u);
+    return (float)(0.5 * energy * energy / decay_per_tick);    // Runs dry first
+}
+
+// Block of players between deadline checks
+#define ALIGN_CHECK_EVERY 1024
+
+int engine_align_team_expected(Match *m, int team_index, int *new_order,
+                               int64_t horizon_ticks, int64_t deadline_ns) {
+    const GameConfig *cfg = m->cfg;
+    Roster *r = &m->roster;
+    int n = r->players_per_team;
+    int *indices = malloc(n * (sizeof(int) + 3 * sizeof(uint32_t) + sizeof(float)));
+    if (!indices)
+        return -1;
+    uint32_t *tmp = (uint32_t *)(indices + n);
+    float *key = (float *)(tmp + 3 * n);
+
+    // Share of the ticks a player is on its feet: a fall every
+    // 1 / p ticks, then on average (min + max) / 2 seconds down
+    double p = cfg->fall_probability / (double)TICKS_PER_SECOND;
+    double down = 0.5 * (cfg->fall_recovery_min + cfg->fall_recovery_max) * TICKS_PER_SECOND;
+    double standing = 1.0 / (1.0 + (p > 0.0 ? p * down : 0.0));
+
+    int done = 1;
+    int off = team_index * r->stride;
+    for (int i = 0; i < n && done; i++) {
+        if (i % ALIGN_CHECK_EVERY == 0 && monotonic_ns() > deadline_ns)
+            done = 0;
+        int k = off + i;
+        int64_t delay = (r->state[k] & PLAYER_RECOVERING) ? r->recover_tick[k] - m->ticks : 0;
+        key[i] = expected_energy(r->energy[k], r->decay_rate[k] / (float)TICKS_PER_SECOND,
+                                 standing, delay > 0 ? delay : 0, horizon_ticks);
+    }
+    // Once the keys are in, the sort is finished whatever the clock says:
+    // throwing it away for the greedy sort would only take longer.
+    // Out of time before that: the greedy order
+    if (done)
+        sort_by_key(key, n, indices, tmp);
+    else
+        sort_by_key(r->energy + off, n, indices, tmp);
+    apply_order(m, team_index, indices, new_order);
+    free(indices);
+    return done;
+}
+
+// Reset the rope and efforts for the next round
+void engine_start_new_round(Match *m) {
+    m->round_number++;
+    m->rope_position = 0.0f;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        m->team_efforts[t] = 0.0f;
+    }
+}
+
+// Winner when time runs out: most round wins, -1 for a tie
+int engine_winner_by_rounds(const Match *m) {
+    if (m->team_round_wins[0] > m->team_round_wins[1])
+        return 0;
+    if (m->team_round_wins[1] > m->team_round_wins[0])
+        return 1;
+    return -1;
+}
+
+// --------------------------------------------------------------------
+// Headless match
+// --------------------------------------------------------------------
+
+// Book the tick just played and, once per game second, end the match
+// or decide the round the way referee_control() does. Returns the
+// ENGINE_EV_* bits besides ENGINE_EV_TICK; after ENGINE_EV_ALIGN a
+// countdown is due before engine_start_new_round().
+static unsigned end_tick(Match *m, EngineObserver observe, void *ctx) {
+    const GameConfig *cfg = m->cfg;
+
+    m->ticks++;
+    if (observe)
+        observe(ctx, m, ENGINE_EV_TICK);
+
+    // Once per game second
+    if (m->ticks % TICKS_PER_SECOND != 0)
+        return 0;
+
+    // End game if duration expired
+    if (m->ticks / TICKS_PER_SECOND >= cfg->game_duration) {
+        m->game_active = 0;
+        m->winner = engine_winner_by_rounds(m);
+        if (observe)
+            observe(ctx, m, ENGINE_EV_MATCH_END);
+        return ENGINE_EV_MATCH_END;
+    }
+
+    RoundResult result = engine_check_round_winner(m);
+    if (result == ROUND_NONE)
+        return 0;
+    unsigned events = result == ROUND_WON ? ENGINE_EV_ROUND : ENGINE_EV_ROUND | ENGINE_EV_MATCH_END;
+    if (observe)
+        observe(ctx, m, events);
+    if (result == ROUND_WON) {
+        for (int t = 0; t < NUM_TEAMS; t++) {
+            engine_align_team(m, t, NULL);
+        }
+        if (observe)
+            observe(ctx, m, ENGINE_EV_ALIGN);
+        events |= ENGINE_EV_ALIGN;
+    }
+    return events;
+}
+
+// Play ticks from the start of tick m->ticks until the match is decided,
+// on game time instead of the wall clock: the ticks run back to back and
+// every countdown simply skips game time
+static int play_on(Match *m, EngineObserver observe, void *ctx) {
+    while (m->game_active) {
+        engine_check_player_falls(m);
+        engine_recover_players(m);
+        engine_update_energy(m);
+        engine_update_rope(m);
+        if (end_tick(m, observe, ctx) & ENGINE_EV_ALIGN) {
+            engine_skip_time(m, ROUND_COUNTDOWN_SECONDS * TICKS_PER_SECOND);
+            engine_start_new_round(m);
+        }
+    }
+    return m->winner;
+}
+
+void engine_begin_match(Match *m) {
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        engine_align_team(m, t, NULL);
+    }
+    m->countdown_ticks = ROUND_COUNTDOWN_SECONDS * TICKS_PER_SECOND;
+    m->countdown_new_round = 0;
+}
+
+int engine_step_begin(Match *m) {
+    if (!m->game_active)
+        return 0;
+
+    // A countdown tick: recoveries carry on, falls wait
+    if (m->countdown_ticks > 0) {
+        engine_skip_time(m, 1);
+        if (--m->countdown_ticks == 0 && m->countdown_new_round) {
+            m->countdown_new_round = 0;
+            engine_start_new_round(m);
+        }
+        return 0;
+    }
+
+    engine_check_player_falls(m);
+    engine_recover_players(m);
+    return 1;
+}
+
+unsigned engine_step_end(Match *m) {
+    engine_update_rope(m);
+    unsigned events = end_tick(m, NULL, NULL);
+    if (events & ENGINE_EV_ALIGN) {
+        m->countdown_ticks = ROUND_COUNTDOWN_SECONDS * TICKS_PER_SECOND;
+        m->countdown_new_round = 1;
+    }
+    return ENGINE_EV_TICK | events;
+}
+
+unsigned engine_step(Match *m) {
+    if (!engine_step_begin(m))
+        return 0;
+    engine_update_energy(m);
+    return engine_step_end(m);
+}
+
+int engine_run_match(Match *m) {
+    return engine_run_match_observed(m, NULL, NULL);
+}
+
+int engine_run_match_observed(Match *m, EngineObserver observe, void *ctx) {
+    // The referee starts the game clock before the opening countdown
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        engine_align_team(m, t, NULL);
+    }
+    if (observe)
+        observe(ctx, m, ENGINE_EV_ALIGN);
+    engine_skip_time(m, ROUND_COUNTDOWN_SECONDS * TICKS_PER_SECOND);
+    return play_on(m, observe, ctx);
+}
+
+int engine_finish_match(Match *m) {
+    return play_on(m, NULL, NULL);
+}
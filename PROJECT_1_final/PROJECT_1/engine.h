@@ -0,0 +1,150 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "roster.h"
+#include "tick_kernels.h"
+#include "timer_wheel.h"
+
+// ----------------------------------------------------------
+// Match engine
+//  The game rules as pure state transitions on a Match.
+//  No sleeps, forks, pipes or signals live in here: the
+//  referee in main.c wraps these with its side effects, and
+//  the batch runner drives them back to back.
+// ----------------------------------------------------------
+
+// Number of teams in a match: a rope has two ends, so config.num_teams
+// must match this (the player rosters themselves are sized at runtime);
+// a tournament plays its larger field two teams at a time
+#define NUM_TEAMS 2
+
+// Simulation tick configuration
+#define TICKS_PER_SECOND 10         // We divide each game second into 10 ticks
+#define ROUND_COUNTDOWN_SECONDS 5   // Countdown before the match and between rounds
+
+// Outcome of a round check
+typedef enum {
+    ROUND_NONE = 0,     // Nobody has won the round yet
+    ROUND_WON,          // A team won the round, the match goes on
+    MATCH_WON,          // A team won enough consecutive rounds
+    MATCH_EXHAUSTED     // Every player ran out of energy
+} RoundResult;
+
+// What an observer of engine_run_match_observed() is told about
+#define ENGINE_EV_TICK      0x01    // A tick was played
+#define ENGINE_EV_ALIGN     0x02    // Teams were lined up by energy
+#define ENGINE_EV_ROUND     0x04    // A round was decided (round_winner)
+#define ENGINE_EV_MATCH_END 0x08    // The match was decided (winner)
+
+// ----------------------------------------------------------
+// Complete state of one match
+// ----------------------------------------------------------
+typedef struct {
+    const GameConfig *cfg;                    // Rules this match is played with
+    Roster roster;                            // Players of every team
+    void  *roster_block;                      // Storage behind roster, NULL if borrowed
+    size_t roster_mapped;                     // Size of a shared roster mapping, 0 if malloc'd
+    const TickKernel *kernel;                 // Fused energy/effort/sum pass
+    float team_efforts[NUM_TEAMS];            // Total effort per team
+    float rope_position;                      // Position of rope in current round
+    int   team_round_wins[NUM_TEAMS];         // Number of rounds each team has won
+    int   team_consecutive_wins[NUM_TEAMS];   // Track win streaks
+    int   round_number;                       // Current round number
+    int   game_active;                        // 0 once the match is decided
+    int   round_winner;                       // Winner of the last finished round
+    int   winner;                             // Match winner, -1 for none/tie
+    unsigned int seed;                        // Private rand_r() state
+    int64_t ticks;                            // Game time in ticks, countdowns included
+    TimerWheel fall_wheel;                    // Next fall of every standing player
+    TimerWheel recover_wheel;                 // Recovery of every fallen player
+    int   countdown_ticks;                    // Countdown ticks still to go (engine_step)
+    int   countdown_new_round;                // A new round starts once it is over
+
+    // Changes since the last engine_clear_changes(), for publishers
+    uint8_t *dirty;                           // Per roster slot: already in dirty_list
+    int32_t *dirty_list;                      // Slots changed outside the tick kernel
+    int   dirty_count;
+    int   all_dirty;                          // Every slot changed (reset, pids)
+    int   hot_dirty[NUM_TEAMS];               // Tick kernel moved the team's energy/effort
+    int   team_pulling[NUM_TEAMS];            // Players of the team on their feet
+} Match;
+
+// Allocation and (re)initialization
+int  engine_init_match(Match *m, const GameConfig *cfg, unsigned int seed, int energy_bias);
+int  engine_init_match_shared(Match *m, const GameConfig *cfg, unsigned int seed, int energy_bias);
+int  engine_init_match_on(Match *m, const GameConfig *cfg, const Roster *roster,
+                          unsigned int seed, int energy_bias);
+void engine_reset_match(Match *m, unsigned int seed, int energy_bias);
+void engine_reset_match_teams(Match *m, unsigned int seed, const int *team_bias);
+void engine_free_match(Match *m);
+
+// Snapshots of a match in play, for what-if rollouts
+void engine_copy_state(Match *dst, const Match *src);
+void engine_fork_match(Match *dst, const Match *src, unsigned int seed);
+
+// Per-tick phases, for the tick m->ticks; the caller moves
+// m->ticks on once a tick is done
+void engine_check_player_falls(Match *m);
+void engine_recover_players(Match *m);
+void engine_update_energy(Match *m);
+void engine_set_team_efforts(Match *m, const float *team_efforts);
+void engine_update_rope(Match *m);
+
+// Let game time pass without ticks being played (countdowns)
+void engine_skip_time(Match *m, int64_t ticks);
+
+// Round handling
+RoundResult engine_check_round_winner(Match *m);
+
+// Line the team up by energy. Returns -1, leaving the team as it
+// stands, if the sort's buffer cannot be allocated; 0 otherwise.
+int  engine_align_team(Match *m, int team_index, int *new_order);
+
+// Line the team up for the most effort expected over the next
+// horizon_ticks instead: every player's energy is projected through its
+// decay, the falls to be expected and any recovery still running. If
+// the monotonic clock passes deadline_ns before every key is in, the
+// greedy energy order is used. Returns 1 if the expected-effort order
+// was applied, 0 for the greedy one, -1 as engine_align_team().
+int  engine_align_team_expected(Match *m, int team_index, int *new_order,
+                                int64_t horizon_ticks, int64_t deadline_ns);
+void engine_start_new_round(Match *m);
+int  engine_winner_by_rounds(const Match *m);
+
+// Change tracking: a slot whose fields change outside the tick kernel
+// is listed once; the kernel's energy/effort updates are flagged per team
+void engine_mark_dirty(Match *m, int i);
+void engine_mark_all_dirty(Match *m);
+void engine_clear_changes(Match *m);
+
+// Play a whole match without any waiting; returns the winner (-1 for a tie)
+int engine_run_match(Match *m);
+
+// Same, calling observe with ENGINE_EV_* bits after every tick and event
+typedef void (*EngineObserver)(void *ctx, const Match *m, unsigned events);
+int engine_run_match_observed(Match *m, EngineObserver observe, void *ctx);
+
+// Play a match in progress from the start of tick m->ticks to its end
+int engine_finish_match(Match *m);
+
+// Stepping a match one tick of game time at a time, for callers that
+// keep many matches on the wall clock: engine_begin_match() lines the
+// teams up and starts the opening countdown; every engine_step() is
+// then a countdown tick or a tick of play with the round and match
+// checks of engine_run_match(). Returns the ENGINE_EV_* bits of what
+// happened (0 for a countdown tick or a decided match).
+void     engine_begin_match(Match *m);
+unsigned engine_step(Match *m);
+
+// engine_step() in two halves, for callers that run the tick kernel
+// over the rosters of many matches at once: engine_step_begin() plays
+// a countdown tick (returns 0) or the falls and recoveries of a tick of
+// play (returns 1); after a 1 the team efforts must be set, by
+// engine_update_energy() or engine_set_team_efforts(), before
+// engine_step_end() moves the rope and returns the ENGINE_EV_* bits.
+int      engine_step_begin(Match *m);
+unsigned engine_step_end(Match *m);
+
+#endif /* ENGINE_H */
@@ -0,0 +1,20 @@
+#ifndef FONT5X7_H
+#define FONT5X7_H
+
+#include <stdint.h>
+
+// ----------------------------------------------------------
+// Built-in 5x7 bitmap font for printable ASCII (' ' .. '~').
+// Each glyph is 7 rows, top row first; bit 4 of a row is the
+// leftmost pixel. The renderer bakes it into its glyph atlas,
+// so text needs neither GLUT fonts nor a display.
+// ----------------------------------------------------------
+
+#define FONT_FIRST_CHAR ' '
+#define FONT_LAST_CHAR  '~'
+#define FONT_WIDTH      5
+#define FONT_HEIGHT     7
+
+extern const uint8_t font5x7[FONT_LAST_CHAR - FONT_FIRST_CHAR + 1][FONT_HEIGHT];
+
+#endif /* FONT5X7_H */
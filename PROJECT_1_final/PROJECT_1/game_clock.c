@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "game_clock.h"
+
+int64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+int game_clock_parse(GameClock *c, const char *spec) {
+    memset(c, 0, sizeof(*c));
+    c->speed = 1.0;
+
+    if (strcmp(spec, "real") == 0) {
+        c->mode = CLOCK_MODE_REAL;
+        return 0;
+    }
+    if (strcmp(spec, "afap") == 0) {
+        c->mode = CLOCK_MODE_AFAP;
+        return 0;
+    }
+    if (spec[0] == 'x') {
+        char *end;
+        double speed = strtod(spec + 1, &end);
+        if (*end == '\0' && speed > 0.0 && isfinite(speed)) {
+            c->mode = (speed == 1.0) ? CLOCK_MODE_REAL : CLOCK_MODE_ACCELERATED;
+            c->speed = speed;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void game_clock_start(GameClock *c) {
+    c->origin_ns = monotonic_ns();
+    c->virtual_ns = 0;
+}
+
+int64_t game_clock_now_ns(const GameClock *c) {
+    switch (c->mode) {
+    case CLOCK_MODE_AFAP:
+        return c->virtual_ns;
+    case CLOCK_MODE_ACCELERATED:
+        return (int64_t)((double)(monotonic_ns() - c->origin_ns) * c->speed);
+    case CLOCK_MODE_REAL:
+    default:
+        return monotonic_ns() - c->origin_ns;
+    }
+}
+
+double game_clock_seconds(const GameClock *c) {
+    return (double)game_clock_now_ns(c) / (double)NSEC_PER_SEC;
+}
+
+void game_clock_sleep_until_ns(GameClock *c, int64_t game_deadline_ns) {
+    if (c->mode == CLOCK_MODE_AFAP) {
+        if (game_deadline_ns > c->virtual_ns)
+            c->virtual_ns = game_deadline_ns;
+        return;
+    }
+
+    int64_t wall_ns = game_clock_wall_ns(c, game_deadline_ns);
+    struct timespec ts = { (time_t)(wall_ns / NSEC_PER_SEC), (long)(wall_ns % NSEC_PER_SEC) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        // Interrupted by a signal: the deadline has not moved
+    }
+}
+
+int64_t game_clock_wall_ns(const GameClock *c, int64_t game_ns) {
+    if (c->mode == CLOCK_MODE_AFAP)
+        return -1;
+    int64_t wall_ns = (c->mode == CLOCK_MODE_ACCELERATED)
+                      ? (int64_t)((double)game_ns / c->speed) : game_ns;
+    return c->origin_ns + wall_ns;
+}
+
+unsigned int game_clock_alarm_seconds(const GameClock *c, int game_seconds) {
+    if (c->mode == CLOCK_MODE_AFAP || game_seconds <= 0)
+        return 0;
+    double wall = (double)game_seconds / c->speed;
+    unsigned int secs = (unsigned int)ceil(wall);
+    return secs > 0 ? secs : 1;
+}
+
+const char *game_clock_describe(const GameClock *c, char *buf, int len) {
+    switch (c->mode) {
+    case CLOCK_MODE_AFAP:
+        snprintf(buf, len, "as fast as possible");
+        break;
+    case CLOCK_MODE_ACCELERATED:
+        snprintf(buf, len, "accelerated x%g", c->speed);
+        break;
+    case CLOCK_MODE_REAL:
+    default:
+        snprintf(buf, len, "real time");
+        break;
+    }
+    return buf;
+}
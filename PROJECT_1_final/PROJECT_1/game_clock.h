@@ -0,0 +1,61 @@
+#ifndef GAME_CLOCK_H
+#define GAME_CLOCK_H
+
+#include <stdint.h>
+
+// ----------------------------------------------------------
+// Game clock
+//  Every time-based decision of the referee (match length,
+//  tick pacing, countdowns, stats cadence) reads game time
+//  through this clock instead of time()/sleep()/usleep().
+//
+//   CLOCK_MODE_REAL         game time is wall time
+//   CLOCK_MODE_ACCELERATED  game time runs 'speed' times faster
+//   CLOCK_MODE_AFAP         as fast as possible: sleeping just
+//                           moves game time forward, so a match
+//                           is a deterministic function of its seed
+// ----------------------------------------------------------
+
+#define NSEC_PER_SEC 1000000000LL
+
+typedef enum {
+    CLOCK_MODE_REAL = 0,
+    CLOCK_MODE_ACCELERATED,
+    CLOCK_MODE_AFAP
+} GameClockMode;
+
+typedef struct {
+    GameClockMode mode;
+    double  speed;            // Game seconds per wall second
+    int64_t origin_ns;        // Monotonic wall time at game time 0
+    int64_t virtual_ns;       // Game time in AFAP mode
+} GameClock;
+
+// Parse "real", "afap" or "xN" (e.g. x8, x0.5); returns 0 on success
+int game_clock_parse(GameClock *c, const char *spec);
+
+// Start game time at 0 now
+void game_clock_start(GameClock *c);
+
+// Current game time
+int64_t game_clock_now_ns(const GameClock *c);
+double  game_clock_seconds(const GameClock *c);
+
+// Sleep until game time reaches an absolute deadline (returns at once
+// if it already has)
+void game_clock_sleep_until_ns(GameClock *c, int64_t game_deadline_ns);
+
+// Monotonic wall time at which game time reaches game_ns, or -1 in AFAP
+// mode where no wall time has to pass
+int64_t game_clock_wall_ns(const GameClock *c, int64_t game_ns);
+
+// Wall-clock seconds after which SIGALRM should end a match lasting
+// game_seconds, or 0 if no alarm is needed (AFAP)
+unsigned int game_clock_alarm_seconds(const GameClock *c, int game_seconds);
+
+const char *game_clock_describe(const GameClock *c, char *buf, int len);
+
+// Monotonic wall time in nanoseconds
+int64_t monotonic_ns(void);
+
+#endif /* GAME_CLOCK_H */
@@ -0,0 +1,54 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <stdint.h>
+
+// ----------------------------------------------------------
+// Single-producer / single-consumer mailbox
+//  A fixed ring of small messages. Exactly one thread pushes
+//  and exactly one thread pops, so no locks are needed: the
+//  producer publishes a slot by storing tail with release
+//  order, the consumer frees it by storing head the same way.
+//  head and tail sit on their own cache lines so the two sides
+//  do not keep stealing each other's line.
+// ----------------------------------------------------------
+
+#define MAILBOX_SLOTS 16               // Power of two
+
+typedef struct {
+    int32_t type;
+    int32_t arg;
+} MailboxMsg;
+
+typedef struct {
+    MailboxMsg slot[MAILBOX_SLOTS];
+    uint32_t head __attribute__((aligned(64)));   // Next slot to pop (consumer)
+    uint32_t tail __attribute__((aligned(64)));   // Next slot to fill (producer)
+} __attribute__((aligned(64))) Mailbox;
+
+static inline void mailbox_init(Mailbox *mb) {
+    mb->head = 0;
+    mb->tail = 0;
+}
+
+// Producer side; returns 0 when the mailbox is full
+static inline int mailbox_push(Mailbox *mb, MailboxMsg msg) {
+    uint32_t tail = mb->tail;
+    if (tail - __atomic_load_n(&mb->head, __ATOMIC_ACQUIRE) == MAILBOX_SLOTS)
+        return 0;
+    mb->slot[tail & (MAILBOX_SLOTS - 1)] = msg;
+    __atomic_store_n(&mb->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Consumer side; returns 0 when the mailbox is empty
+static inline int mailbox_pop(Mailbox *mb, MailboxMsg *msg) {
+    uint32_t head = mb->head;
+    if (__atomic_load_n(&mb->tail, __ATOMIC_ACQUIRE) == head)
+        return 0;
+    *msg = mb->slot[head & (MAILBOX_SLOTS - 1)];
+    __atomic_store_n(&mb->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+#endif /* MAILBOX_H */
@@ -14,6 +14,23 @@
 #include <GL/freeglut.h> // OpenGL utility toolkit for visualization
 #include "config.h" 
 #include "opengl.h"     // Custom visualization logic
+#include "engine.h"     // Game rules as pure state transitions
+#include "shared_state.h" // Block shared with the visualizer
+#include "batch.h"      // Headless batch runner
+#include "tournament.h" // League of many teams on the batch engine
+#include "sweep.h"      // Parameter sweeps with cached match results
+#include "match_server.h" // Many matches hosted by one referee process
+#include "spectator.h"  // Viewers attached over a Unix socket
+#include "win_estimator.h" // Live win probability from background rollouts
+#include "stats_printer.h" // Stats tables printed off the referee thread
+#include "game_clock.h" // Real, accelerated or as-fast-as-possible game time
+#include "tick_scheduler.h" // Absolute tick deadlines with overrun accounting
+#include "recorder.h"   // Offscreen rendering to frame files
+#include "tick_trace.h" // Binary per-tick trace of the match
+#include "profiler.h"   // Nanosecond phase timers, Chrome trace-event export
+#include "player_pool.h" // Players as pooled tasks with SPSC mailboxes
+#include "energy_reports.h" // Players play their own ticks and report effort
+#include "referee_loop.h" // signalfd/timerfd/epoll loop the referee waits in
 
 // Pointer to the shared memory structure
 SharedState *shared_state = NULL;
@@ -25,55 +42,64 @@ SharedState *shared_state = NULL;
 int my_team = -1;
 int my_player = -1;
 
-// Simulation tick configuration
-#define TICKS_PER_SECOND 10         // We divide each real second into 10 ticks
-#define TICK_SLEEP_USEC 100000      // 100 ms sleep per tick
+// Simulation tick configuration (TICKS_PER_SECOND lives in engine.h)
+#define TICK_SLEEP_NSEC (NSEC_PER_SEC / TICKS_PER_SECOND)  // 100 ms of game time per tick
 
-// Define custom signals to trigger different game actions
-#define SIG_WIN_ROUND  SIGUSR2      // Notify player/team of round win
-#define SIG_LOSE_ROUND SIGURG       // Notify player/team of round loss
-#define SIG_MATCH_WIN  SIGWINCH     // Match win signal
-#define SIG_MATCH_LOSE SIGIO        // Match loss signal
-#define SIG_JUMP       SIGUSR1      // Used to trigger jump
-#define SIG_PULL       SIGUSR2      // Used to trigger pull
-#define SIG_ALIGN      SIGRTMIN     // Custom signal for team alignment
+// Channels of the referee event loop
+#define LOOP_CHANNEL_REPORTS 0            // energy_reports->done_fd
+#define LOOP_CHANNEL_SPECTATORS 1         // spectator_feed.listen_fd
+
+// Custom signal for team alignment (round and match results reach the
+// players through the shared result ring, see energy_reports.h, not
+// through signals)
+#define SIG_ALIGN      SIGRTMIN
 
 // Global structures and game data
-Player **teams = NULL;                     // Dynamic 2D array of players
-int   team_round_wins[NUM_TEAMS] = {0, 0}; // Number of rounds each team has won
-int   team_consecutive_wins[NUM_TEAMS] = {0, 0}; // Track win streaks
-float *team_efforts = NULL;               // Track total effort for each team
-float rope_position = 0.0f;               // Position of rope in current round
-int   game_active = 1;                    // Flag for whether game is still running
-int   round_number = 1;                   // Current round number
-time_t game_start_time;                   // When the game started
-int **energy_pipes = NULL;                // Pipes for energy communication
+Match match;                              // Teams, rope, scores and round state
+GameClock game_clock;                     // Source of all game time
+TickScheduler tick_scheduler;             // Releases referee ticks on fixed deadlines
+TickOverrunPolicy tick_policy = TICK_CATCH_UP; // From --overrun
+unsigned int match_seed = 0;              // Seed from --seed, then the one dealt with
+int   match_seed_given = 0;               // 1 if --seed was passed
+int   game_ended = 0;                     // Set once the match result is announced
+EnergyReports *energy_reports = NULL;     // Tick posts and effort reports from the players
 int   window_width = 800;                 // Window size for visualization
 int   window_height = 600;
 pid_t vis_pid = -1;                       // PID for OpenGL visualizer process
 
 // Config variable to make threshold accessible by OpenGL
 float config_rope_threshold = 0.0f;  
-
-
-int Winner_Team_ID = -1;                // ID of the match winner
-pid_t players[NUM_TEAMS * PLAYERS_PER_TEAM]; // Store all player PIDs
-
-// Pipe arrays used for communication between referee and players
-int sendID_pipe[2];
-int Ref_Player[2];
-int jump_pipe[2];
-int pull_pipe[2];
-int spec_pipe[2];
-int pull_handler_pipe[2];
-int pipe_for_decrease[2];
-
-// Store each player's current energy for local reference
-int Energies[NUM_TEAMS * PLAYERS_PER_TEAM] = {100,100,100,100, 100,100,100,100};
+int   viewer_fps = 60;                    // Target frame rate of the viewer (--fps)
+const char *record_path = NULL;           // --record: render offscreen to this path
+int   record_fps = RECORD_DEFAULT_FPS;    // --record-fps: frames per game second
+TickTrace tick_trace;                     // --trace: one record per tick
+const char *trace_path = NULL;
+long  trace_ticks = 0;                    // --trace-ticks: ring size, 0 = the whole match
+const char *replay_path = NULL;           // --replay: play a trace back instead
+double replay_speed = 1.0;                // --speed: replay speed factor
+const char *profile_path = NULL;          // --profile: phase timings as trace-event JSON
+int profile_detail = 0;                   // --profile-detail: also the phases inside each tick
+int   player_threads = 0;                 // --players threads: pooled tasks instead of processes
+PlayerPool player_pool;
+RefereeLoop referee_loop;                 // Signals, tick timer and player channels
+int   players_lost = 0;                   // A player process exited mid-match
+int   estimator_threads = 0;              // --estimator N: win-probability rollout threads
+WinEstimator win_estimator;
+StatsPrinter stats_printer;               // Formats the stats tables on its own thread
+const char *stats_path = NULL;            // --stats: match statistics as CSV or JSON
+double align_budget_ms = 0.0;             // --align-budget MS: expected-effort alignment, 0 = greedy
+int64_t round_start_tick = 0;             // match.ticks when the current round started
+int64_t decided_round_ticks = 0;          // Length of the rounds decided so far
+int   rounds_decided = 0;
+unsigned long aligns_optimized = 0;       // Team alignments done in budget
+unsigned long aligns_fallback = 0;        // ... and out of time, lined up greedily
+const char *spectators_path = NULL;       // --spectators: socket viewers attach to
+SpectatorFeed spectator_feed;
 
 // Interval to print stats about teams
 #define STATS_PRINT_INTERVAL 5
-time_t last_stats_print_time = 0;
+#define STATS_MAX_ROWS 16         // Players listed per team before eliding the rest
+double last_stats_print_time = 0.0;       // Game seconds of the last stats print
 
 // --------------------------------------------------------------------
 // Function declarations for readability
@@ -84,66 +110,248 @@ void visualization_loop(int argc, char **argv);
 void setup_signal_handlers();
 void initialize_config(const char *config_file);
 void initialize_game();
-void setup_pipes();
+void setup_energy_reports();
 void start_players();
 void referee_control();
 void request_energy_reports_partial();
 void update_rope_position_partial();
+void update_match_stats_partial();
 void check_round_winner();
 void cleanup();
 void signal_handler(int sig);
-void parent_alarm_handler(int sig);
 void check_player_falls_partial();
 void recover_players_partial();
 void notify_round_result(int winning_team);
 void notify_match_result(int winning_team);
 void reset_for_new_round();
 void print_game_status();
-void print_team_stats();
 
 // Extra helper functions for visual effects and synchronization
-void align_team(int team_index);
+void align_team(int team_index, int64_t deadline_ns);
 void align_all_teams(void);
-void alignment_handler(int sig);
 void countdown(int seconds);
+void mirror_to_shared_memory();
+void check_match_config(void);
 
 // --------------------------------------------------------------------
 // Main game entry point
 // --------------------------------------------------------------------
 int main(int argc, char *argv[]) {
-    void *map_ptr = mmap(NULL, sizeof(SharedState),
-    PROT_READ | PROT_WRITE,
-    MAP_SHARED | MAP_ANONYMOUS,
-    -1, 0);
-    if (map_ptr == MAP_FAILED) {
-    perror("mmap failed");
-    exit(EXIT_FAILURE);
-    }
-shared_state = (SharedState*)map_ptr;
-memset(shared_state, 0, sizeof(SharedState));
-
-    // 2. Create communication pipes between referee and players
-    if (pipe(Ref_Player) == -1 || pipe(spec_pipe) == -1 ||
-        pipe(jump_pipe) == -1 || pipe(pull_pipe) == -1 ||
-        pipe(pull_handler_pipe) == -1 || pipe(pipe_for_decrease) == -1 ||
-        pipe(sendID_pipe) == -1) {
-        perror("Pipe Error");
+    // Headless mode: tug_of_war --batch N [result_file [seed]]
+    if (argc >= 3 && strcmp(argv[1], "--batch") == 0) {
+        int num_matches = atoi(argv[2]);
+        const char *out_path = (argc >= 4) ? argv[3] : "batch_results.bin";
+        unsigned int seed = (argc >= 5) ? (unsigned int)strtoul(argv[4], NULL, 10)
+                                        : (unsigned int)time(NULL);
+        if (num_matches <= 0) {
+            fprintf(stderr, "Usage: %s --batch N [result_file [seed]]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        initialize_config("config.txt");
+        check_match_config();
+        return run_batch(num_matches, out_path, seed) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // League of config.num_teams teams: tug_of_war --tournament roundrobin|bracket
+    // [result_file [seed [trace_dir]]]
+    if (argc >= 3 && strcmp(argv[1], "--tournament") == 0) {
+        TournamentFormat format = TOURNAMENT_ROUND_ROBIN;
+        if (strcmp(argv[2], "bracket") == 0) {
+            format = TOURNAMENT_BRACKET;
+        } else if (strcmp(argv[2], "roundrobin") != 0) {
+            fprintf(stderr, "Usage: %s --tournament roundrobin|bracket [result_file [seed [trace_dir]]]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        const char *out_path = (argc >= 4) ? argv[3] : "tournament_results.bin";
+        unsigned int seed = (argc >= 5) ? (unsigned int)strtoul(argv[4], NULL, 10)
+                                        : (unsigned int)time(NULL);
+        const char *trace_dir = (argc >= 6) ? argv[5] : NULL;
+        initialize_config("config.txt");
+        return run_tournament(format, out_path, seed, trace_dir) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Parameter sweep over variations of config.txt: tug_of_war --sweep SPEC [csv_file]
+    if (argc >= 3 && strcmp(argv[1], "--sweep") == 0) {
+        const char *out_path = (argc >= 4) ? argv[3] : "sweep_results.csv";
+        initialize_config("config.txt");
+        check_match_config();
+        return run_sweep(argv[2], out_path) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Referee server for many matches: tug_of_war --server SOCKET
+    // [max_matches [workers]] [--clock real|afap|xN]
+    if (argc >= 3 && strcmp(argv[1], "--server") == 0) {
+        int max_matches = (argc >= 4 && argv[3][0] != '-') ? atoi(argv[3]) : 256;
+        int workers = (argc >= 5 && argv[4][0] != '-') ? atoi(argv[4]) : 0;
+        game_clock_parse(&game_clock, "real");
+        for (int i = 3; i + 1 < argc; i++) {
+            if (strcmp(argv[i], "--clock") == 0 && game_clock_parse(&game_clock, argv[i + 1]) != 0) {
+                fprintf(stderr, "--clock must be real, afap or xN\n");
+                return EXIT_FAILURE;
+            }
+        }
+        if (max_matches < 1 || max_matches > 100000 || workers < 0 || workers > 256) {
+            fprintf(stderr, "Usage: %s --server SOCKET [max_matches [workers]] [--clock real|afap|xN]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        initialize_config("config.txt");
+        check_match_config();
+        return run_match_server(argv[2], &config, &game_clock, max_matches, workers) == 0
+            ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // One request to a running server: tug_of_war --request SOCKET WORDS...
+    if (argc >= 4 && strcmp(argv[1], "--request") == 0) {
+        char line[SERVER_LINE_MAX] = "";
+        for (int i = 3; i < argc; i++) {
+            if (strlen(line) + strlen(argv[i]) + 2 > sizeof(line))
+                break;
+            if (i > 3)
+                strcat(line, " ");
+            strcat(line, argv[i]);
+        }
+        return match_server_request(argv[2], line) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Follow one of a server's matches: tug_of_war --watch SOCKET ID
+    if (argc >= 4 && strcmp(argv[1], "--watch") == 0) {
+        return match_server_watch(argv[2], (unsigned int)strtoul(argv[3], NULL, 10)) == 0
+            ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Watch a running match from another process: tug_of_war --spectate SOCKET [--text]
+    if (argc >= 3 && strcmp(argv[1], "--spectate") == 0) {
+        if (argc >= 4 && strcmp(argv[3], "--text") == 0)
+            return spectate_text(argv[2]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        return spectate_visualization(argc, argv, argv[2]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Check the SIMD tick kernels against the scalar one
+    if (argc >= 2 && strcmp(argv[1], "--verify-kernels") == 0) {
+        return tick_kernels_verify() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Referee options: --clock real|afap|xN, --overrun catchup|skip, --fps N,
+    // --record PATH, --record-fps N, --trace PATH, --trace-ticks N, --profile PATH,
+    // --profile-detail PATH, --players processes|threads, --estimator N, --align-budget MS,
+    // --stats PATH, --seed S, --spectators PATH, and for the viewer alone --replay PATH [--speed X]
+    game_clock_parse(&game_clock, "real");
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--clock") == 0) {
+            if (game_clock_parse(&game_clock, argv[++i]) != 0) {
+                fprintf(stderr, "Usage: %s [--clock real|afap|xN] [--overrun catchup|skip] [--fps N] [--record PATH [--record-fps N]] [--trace PATH [--trace-ticks N]] [--profile|--profile-detail PATH] [--players processes|threads] [--estimator N] [--align-budget MS] [--stats PATH] [--seed S] [--spectators PATH] [--replay PATH [--speed X]]\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--fps") == 0) {
+            viewer_fps = atoi(argv[++i]);
+            if (viewer_fps < 1 || viewer_fps > 1000) {
+                fprintf(stderr, "--fps must be between 1 and 1000\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--record") == 0) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--record-fps") == 0) {
+            record_fps = atoi(argv[++i]);
+            if (record_fps < 1 || record_fps > 1000) {
+                fprintf(stderr, "--record-fps must be between 1 and 1000\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace-ticks") == 0) {
+            trace_ticks = atol(argv[++i]);
+            if (trace_ticks < 1) {
+                fprintf(stderr, "--trace-ticks must be at least 1\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--overrun") == 0) {
+            if (tick_policy_parse(&tick_policy, argv[++i]) != 0) {
+                fprintf(stderr, "Usage: %s [--clock real|afap|xN] [--overrun catchup|skip] [--fps N] [--record PATH [--record-fps N]] [--trace PATH [--trace-ticks N]] [--profile|--profile-detail PATH] [--players processes|threads] [--estimator N] [--align-budget MS] [--stats PATH] [--seed S] [--spectators PATH] [--replay PATH [--speed X]]\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--players") == 0) {
+            const char *mode = argv[++i];
+            if (strcmp(mode, "threads") == 0) {
+                player_threads = 1;
+            } else if (strcmp(mode, "processes") != 0) {
+                fprintf(stderr, "--players must be processes or threads\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--estimator") == 0) {
+            estimator_threads = atoi(argv[++i]);
+            if (estimator_threads < 0 || estimator_threads > 256) {
+                fprintf(stderr, "--estimator must be between 0 and 256 threads\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--align-budget") == 0) {
+            align_budget_ms = strtod(argv[++i], NULL);
+            if (!(align_budget_ms >= 0.0 && align_budget_ms <= 1000.0)) {
+                fprintf(stderr, "--align-budget must be between 0 and 1000 ms\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats_path = argv[++i];
+        } else if (strcmp(argv[i], "--spectators") == 0) {
+            spectators_path = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--profile-detail") == 0) {
+            profile_path = argv[++i];
+            profile_detail = 1;
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--speed") == 0) {
+            replay_speed = strtod(argv[++i], NULL);
+            if (!(replay_speed >= REPLAY_MIN_SPEED && replay_speed <= REPLAY_MAX_SPEED)) {
+                fprintf(stderr, "--speed must be between %g and %g\n", REPLAY_MIN_SPEED, REPLAY_MAX_SPEED);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            match_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+            match_seed_given = 1;
+        }
+    }
+
+    // Replay a recorded match: only the viewer runs
+    if (replay_path) {
+        return replay_visualization(argc, argv, replay_path, replay_speed) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // A raw stream on stdout: the game prints to stderr instead
+    if (record_path && strcmp(record_path, "-") == 0 && record_claim_stdout() != 0)
+        return EXIT_FAILURE;
+
+    // Time the referee's phases from the start
+    if (profile_path && profiler_start(PROFILER_DEFAULT_EVENTS, profile_detail) != 0)
+        profile_path = NULL;
+
+    // 1. Load the game rules; they decide the size of the rosters
+    initialize_config("config.txt");
+    check_match_config();
+
+    shared_state = shared_state_create(config.num_teams, config.players_per_team);
+    if (shared_state == NULL) {
         exit(EXIT_FAILURE);
     }
 
+    // Game time starts now, so the first published snapshot reads ~0 s
+    game_clock_start(&game_clock);
+
     // 4. Setup all teams and player attributes
     initialize_game();
 
     // Copy config threshold for OpenGL access
     
     config_rope_threshold = config.rope_threshold;
-    shared_state->round_number = round_number;
 
     // Display basic game information
     printf("=== TUG OF WAR GAME SIMULATION ===\n");
     printf("Configuration:\n");
     printf("- Teams: %d\n", config.num_teams);
     printf("- Players per team: %d\n", config.players_per_team);
+    printf("- Tick kernel: %s\n", match.kernel->name);
+    char clock_desc[64];
+    printf("- Clock: %s\n", game_clock_describe(&game_clock, clock_desc, sizeof(clock_desc)));
 
     // Seed the random generator using multiple sources
     srand(
@@ -153,22 +361,65 @@ memset(shared_state, 0, sizeof(SharedState));
             + getpid() * 101
         )
     );
-    
-    game_start_time = time(NULL);
 
-    // Reinitialize pipes for energy data
-    setup_pipes();
+    // The referee only takes its signals from its event loop: block them
+    // before any player thread or process exists (children unblock)
+    int referee_signals[] = { SIGALRM, SIGCHLD, SIG_ALIGN, SIGINT, SIGTERM };
+    if (referee_loop_block(&referee_loop, referee_signals,
+                           (int)(sizeof(referee_signals) / sizeof(referee_signals[0]))) != 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    // Shared rings the players report their effort through
+    setup_energy_reports();
 
     // Fork all players as child processes
     start_players();
 
     // 5. Fork another process to handle OpenGL visualization
+    //    With --record it renders offscreen instead of opening a window
+    fflush(stdout);     // The child must not write the referee's buffer again
     vis_pid = fork();
     if (vis_pid == 0) {
+        referee_loop_unblock_child(&referee_loop);
+        if (record_path) {
+            exit(record_visualization(record_path, record_fps) == 0 ? 0 : 1);
+        }
         init_visualization(argc, argv);
         visualization_loop(argc, argv);
         exit(0);
     }
+    if (record_path && vis_pid > 0) {
+        __atomic_store_n(&shared_state->recorder_attached, 1, __ATOMIC_RELEASE);
+    }
+
+    // Everything is forked: from here on the referee waits in its event loop
+    if (referee_loop_open(&referee_loop) != 0 ||
+        referee_loop_add_channel(&referee_loop, energy_reports->done_fd, LOOP_CHANNEL_REPORTS) != 0) {
+        exit(EXIT_FAILURE);
+    }
+    if (spectators_path &&
+        (spectator_feed_open(&spectator_feed, spectators_path, shared_state, config.rope_threshold) != 0 ||
+         referee_loop_add_channel(&referee_loop, spectator_feed.listen_fd, LOOP_CHANNEL_SPECTATORS) != 0)) {
+        fprintf(stderr, "Spectator feed disabled\n");
+        spectator_feed_close(&spectator_feed);
+    } else if (spectators_path) {
+        printf("Spectators can attach at %s\n", spectators_path);
+    }
+
+    // Rollout threads start after the forks, with the referee's signals blocked
+    if (estimator_threads > 0 &&
+        win_estimator_start(&win_estimator, shared_state, &config, estimator_threads) != 0)
+        fprintf(stderr, "Win estimator disabled\n");
+    stats_printer_start(&stats_printer, shared_state, &config, STATS_MAX_ROWS, stats_path);
+
+    // Trace every tick from here on; by default the ring holds the whole match
+    if (trace_path) {
+        uint64_t capacity = trace_ticks > 0 ? (uint64_t)trace_ticks
+                                            : (uint64_t)config.game_duration * TICKS_PER_SECOND + 1;
+        if (tick_trace_open(&tick_trace, trace_path, &match, capacity, match_seed) != 0)
+            fprintf(stderr, "Tracing disabled\n");
+    }
 
     // Align all teams before starting the match
     align_all_teams();
@@ -178,16 +429,17 @@ memset(shared_state, 0, sizeof(SharedState));
     countdown(5);
 
     // 6. Setup a signal alarm to end the game after duration expires
-    struct sigaction sa;
-    sa.sa_handler = parent_alarm_handler;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = 0;
-    sigaction(SIGALRM, &sa, NULL);
-    alarm(config.game_duration); // Trigger SIGALRM when time is up
+    //    (read from the event loop like every other referee signal)
+    unsigned int alarm_secs = game_clock_alarm_seconds(&game_clock, config.game_duration);
+    if (alarm_secs > 0)
+        alarm(alarm_secs); // Trigger SIGALRM when time is up
 
     // 7. Begin main control loop where the referee manages the game
     referee_control();
 
+    if (profile_path)
+        profiler_export(profile_path);
+
     // 8. Clean up memory and processes
     cleanup();
     return 0;
@@ -198,165 +450,256 @@ memset(shared_state, 0, sizeof(SharedState));
 // 6) SIGNAL HANDLERS & SETUP
 // --------------------------------------------------------------------
 
-// Handler for the alarm signal sent when game time expires
-void parent_alarm_handler(int sig) {
-    printf("\n=== GAME TIME EXPIRED ===\n");
-    game_active = 0;
+// Reap children that exited: the viewer or recorder may go at any time,
+// a player process never should
+static void reap_children(void) {
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        if (pid == vis_pid) {
+            vis_pid = -1;
+            if (__atomic_load_n(&shared_state->recorder_attached, __ATOMIC_ACQUIRE)) {
+                fprintf(stderr, "Recorder exited early; recording stopped\n");
+                __atomic_store_n(&shared_state->recorder_attached, 0, __ATOMIC_RELEASE);
+            }
+            continue;
+        }
+        for (int t = 0; t < config.num_teams; t++) {
+            for (int p = 0; p < config.players_per_team; p++) {
+                int i = ROSTER_INDEX(&match.roster, t, p);
+                if (match.roster.pid[i] != pid)
+                    continue;
+                fprintf(stderr, "Player %d of team %d exited during the match\n", p + 1, t + 1);
+                match.roster.pid[i] = 0;
+                players_lost = 1;
+                match.game_active = 0;
+            }
+        }
+    }
 }
 
-// This handler is triggered when a signal to align teams is received
-void alignment_handler(int sig) {
-    (void)sig;
-    printf("Referee signal received: Aligning teams based on effort...\n");
-    align_all_teams();
+// Handle one event of the referee loop. Events are only handled while the
+// referee waits between ticks, so none of this runs in the middle of a tick.
+static void handle_loop_event(const LoopEvent *ev) {
+    if (ev->type == LOOP_EV_CHANNEL) {
+        if (ev->channel == LOOP_CHANNEL_REPORTS)
+            energy_reports_ack(energy_reports);
+        else if (ev->channel == LOOP_CHANNEL_SPECTATORS)
+            spectator_feed_accept(&spectator_feed);
+        return;
+    }
+    if (ev->type != LOOP_EV_SIGNAL)
+        return;
+
+    if (ev->signo == SIGALRM) {
+        // Game time expired
+        printf("\n=== GAME TIME EXPIRED ===\n");
+        match.game_active = 0;
+    } else if (ev->signo == SIG_ALIGN) {
+        printf("Referee signal received: Aligning teams based on effort...\n");
+        align_all_teams();
+    } else if (ev->signo == SIGCHLD) {
+        reap_children();
+    } else if (ev->signo == SIGINT || ev->signo == SIGTERM) {
+        printf("\n=== MATCH INTERRUPTED ===\n");
+        match.game_active = 0;
+    }
+}
+
+// Events taken while the players work on a tick, held for its end
+static int deferred_align = 0;            // SIG_ALIGN arrived
+static int deferred_viewers = 0;          // Viewers are waiting; their channel is paused
+
+// While the players work on a tick they share the roster with it, so
+// only their reports are handled. SIGCHLD is reaped at once (that only
+// touches pids and flags; a lost player would never report), time up and
+// interrupts only end the match after the tick; alignments and viewers
+// wait for referee_wait_until().
+static void take_tick_event(const LoopEvent *ev) {
+    if (ev->type == LOOP_EV_CHANNEL && ev->channel == LOOP_CHANNEL_SPECTATORS) {
+        deferred_viewers = 1;
+        referee_loop_pause_channel(&referee_loop, spectator_feed.listen_fd, LOOP_CHANNEL_SPECTATORS, 1);
+    } else if (ev->type == LOOP_EV_SIGNAL && ev->signo == SIG_ALIGN) {
+        deferred_align = 1;
+    } else {
+        handle_loop_event(ev);
+    }
 }
 
-// This function sets up various signal handlers for the parent process
+static void run_deferred_events(void) {
+    if (deferred_viewers) {
+        deferred_viewers = 0;
+        referee_loop_pause_channel(&referee_loop, spectator_feed.listen_fd, LOOP_CHANNEL_SPECTATORS, 0);
+        spectator_feed_accept(&spectator_feed);
+    }
+    if (deferred_align) {
+        deferred_align = 0;
+        LoopEvent ev = { .type = LOOP_EV_SIGNAL, .signo = SIG_ALIGN };
+        handle_loop_event(&ev);
+    }
+}
+
+// Let game time reach a deadline, handling events on the way. In AFAP
+// mode no wall time passes and only what is already pending is handled.
+static void referee_wait_until(int64_t game_deadline_ns) {
+    LoopEvent ev;
+    run_deferred_events();
+    int64_t wall = game_clock_wall_ns(&game_clock, game_deadline_ns);
+    if (wall < 0) {
+        game_clock_sleep_until_ns(&game_clock, game_deadline_ns);
+        while (referee_loop_next(&referee_loop, &ev, 0))
+            handle_loop_event(&ev);
+        return;
+    }
+
+    referee_loop_arm(&referee_loop, wall);
+    while (referee_loop_next(&referee_loop, &ev, 1) && ev.type != LOOP_EV_TIMER)
+        handle_loop_event(&ev);
+}
+
+// A player process outlives the signals meant for the referee: it leaves
+// when the referee closes the energy reports
 void setup_signal_handlers() {
     struct sigaction sa;
     sa.sa_handler = signal_handler;
     sigemptyset(&sa.sa_mask);
     sa.sa_flags = SA_RESTART;
 
-    // Register our general handler to handle these signals
-    sigaction(SIGUSR1, &sa, NULL);
-    sigaction(SIGALRM, &sa, NULL);
-    sigaction(SIG_WIN_ROUND, &sa, NULL);
-    sigaction(SIG_LOSE_ROUND, &sa, NULL);
-    sigaction(SIG_MATCH_WIN, &sa, NULL);
-    sigaction(SIG_MATCH_LOSE, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
     sigaction(SIGINT, &sa, NULL);
-    sigaction(SIGRTMIN, &sa, NULL);  // Catch any real-time signals if needed
-
-    // Set up a separate handler just for team alignment
-    struct sigaction sa_align;
-    sa_align.sa_handler = alignment_handler;
-    sigemptyset(&sa_align.sa_mask);
-    sa_align.sa_flags = SA_RESTART;
-    sigaction(SIG_ALIGN, &sa_align, NULL);
+    sigaction(SIG_ALIGN, &sa, NULL);  // Alignment is the referee's business
 }
 
-// Placeholder for handling signals
+// Nothing to do: the signal has only to not end the player
 void signal_handler(int sig) {
-    if (sig == SIGUSR1) {
-        // Can be expanded later to handle other game events
-    }
-    // More signal handling cases can be added here
+    (void)sig;
 }
 
 
-// Main game setup logic
-void initialize_game() {
-    // Allocate 2D array of players for all teams
-    teams = malloc(config.num_teams * sizeof(Player*));
-    for (int i = 0; i < config.num_teams; i++) {
-        teams[i] = malloc(config.players_per_team * sizeof(Player));
+// A match is always played between NUM_TEAMS teams
+void check_match_config(void) {
+    if (config.num_teams != NUM_TEAMS) {
+        fprintf(stderr, "num_teams=%d is not supported: a match needs exactly %d teams\n",
+                config.num_teams, NUM_TEAMS);
+        exit(EXIT_FAILURE);
     }
+}
 
+// Main game setup logic
+void initialize_game() {
     // Get current second for use in randomization
     time_t now = time(NULL);
     struct tm *local_time = localtime(&now);
     int current_second = local_time->tm_sec;
 
-    // Initialize each player's parameters
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            // Calculate starting energy with some randomness
-            float en = config.minimum_energy + (rand() % config.range) + (current_second % 20);
-            // Generate a decay rate randomly
-            float dr = 0.5f + (float)(rand() % 16) / 10.0f;
+    // Allocate and deal every team's players
+    unsigned int seed = (unsigned int)(now * 100003 + (unsigned int)clock() + getpid() * 101);
+    if (match_seed_given) {
+        // Replayable match: nothing may depend on the wall clock
+        seed = match_seed;
+        current_second = (int)(match_seed % 60);
+    }
+    match_seed = seed;
+    if (engine_init_match_shared(&match, &config, seed, current_second) != 0) {
+        perror("Failed to allocate teams");
+        exit(EXIT_FAILURE);
+    }
 
-            // Debug print to track initial values
+    // Debug print to track initial values
+    for (int t = 0; t < config.num_teams; t++) {
+        for (int p = 0; p < config.players_per_team && p < STATS_MAX_ROWS; p++) {
             printf("Team %d Player %d: init second=%d, raw energy=%.2f\n",
-                   t, p, current_second, en);
-
-            // Assign player properties
-            teams[t][p].energy       = en;
-            teams[t][p].effort       = en;   // Initially, effort = energy
-            teams[t][p].decay_rate   = dr;
-            teams[t][p].position     = p + 1;
-            teams[t][p].active       = 1;
-            teams[t][p].recovering   = 0;
-            teams[t][p].recover_time = 0;
-            teams[t][p].pid          = 0;
+                   t, p, current_second, match.roster.energy[ROSTER_INDEX(&match.roster, t, p)]);
         }
     }
 
-    // Allocate array for team total efforts
-    team_efforts = calloc(config.num_teams, sizeof(float));
-
-    // Allocate pipe arrays for each player
-    energy_pipes = malloc(config.num_teams * config.players_per_team * sizeof(int*));
-    for (int i = 0; i < config.num_teams * config.players_per_team; i++) {
-        energy_pipes[i] = malloc(2 * sizeof(int));
-    }
-
     // Setup shared game state memory
-    shared_state->rope_position         = 0.0f;
-    shared_state->team_round_wins[0]    = 0;
-    shared_state->team_round_wins[1]    = 0;
-    shared_state->round_number          = round_number;
-    shared_state->game_ended            = 0;
-    shared_state->final_winner          = -1;
+    game_ended = 0;
 
     // Copy all initialized players to the shared memory state
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            shared_state->players[t][p] = teams[t][p];
-        }
+    mirror_to_shared_memory();
+}
+
+// Every player process reports its own effort; pool workers report
+// fixed chunks of players
+void setup_energy_reports() {
+    int chunk = player_threads ? ENERGY_CHUNK : 1;
+    int chunks = config.num_teams * ((config.players_per_team + chunk - 1) / chunk);
+    int producers = player_threads ? player_pool_default_workers(chunks) : chunks;
+    energy_reports = energy_reports_create(config.num_teams, config.players_per_team,
+                                           chunk, producers);
+    if (energy_reports == NULL) {
+        exit(EXIT_FAILURE);
     }
 }
 
-// Create a pipe for each player to communicate with the parent
-void setup_pipes() {
-    for (int i = 0; i < config.num_teams * config.players_per_team; i++) {
-        if (pipe(energy_pipes[i]) != 0) {
-            perror("pipe failed");
-            exit(EXIT_FAILURE);
+// A player process: plays its own tick whenever the referee posts one
+// and follows the announced results, until the match is closed
+static void player_process_loop(int producer) {
+    uint32_t done = 0;             // Last tick generation played
+    uint32_t seen = 0;             // Last result generation heard
+    for (;;) {
+        uint32_t bell = energy_reports_bell(energy_reports);
+        int closed = __atomic_load_n(&energy_reports->closed, __ATOMIC_ACQUIRE);
+
+        MatchResult res;
+        while (energy_reports_next_result(energy_reports, &seen, &res, NULL)) {
+            if (res.kind == RESULT_MATCH)
+                __atomic_add_fetch(&energy_reports->match_heard, 1, __ATOMIC_RELAXED);
         }
+        if (closed)
+            _exit(EXIT_SUCCESS);   // Do not flush the referee's stdio buffers again
+        if (energy_reports_pending(energy_reports, &done))
+            energy_reports_produce(energy_reports, &match.roster, match.kernel, producer, done);
+        else
+            energy_reports_sleep(energy_reports, bell);
+    }
+}
+
+// Start players on a pool of worker threads; they are running once every
+// one of them has answered through its mailbox
+static void start_player_tasks(void) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (player_pool_start(&player_pool, &match, energy_reports) != 0 ||
+        player_pool_wait_ready(&player_pool) != 0) {
+        fprintf(stderr, "Failed to start the player tasks\n");
+        exit(EXIT_FAILURE);
     }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("- Players: %d tasks on %d threads, ready in %.2f ms\n",
+           player_pool.num_players, player_pool.num_workers,
+           (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
 }
 
 // Start player processes using fork
 void start_players() {
+    if (player_threads) {
+        start_player_tasks();
+        return;
+    }
+
     int player_idx = 0;
     for (int t = 0; t < config.num_teams; t++) {
         for (int p = 0; p < config.players_per_team; p++) {
+            fflush(stdout);
             pid_t pid = fork();
             if (pid == 0) {
-                // In child process: seed random with unique values
-                srand((unsigned int)(time(NULL) * 100003 + (unsigned int)clock() + getpid() * 101));
+                referee_loop_unblock_child(&referee_loop);
 
                 // Save this player's identifiers
                 my_team = t;
                 my_player = p;
 
-                // Close read-end of pipe (child only writes)
-                close(energy_pipes[player_idx][0]);
-
                 // Setup signals
                 setup_signal_handlers();
 
-                // Set alarm to trigger periodically
-                alarm(1 + rand() % 3);
-
-                // Wait for signals to activate
-                while (1) {
-                    pause();
-
-                    // Exit if effort drops to zero
-                    if (teams[my_team][my_player].effort <= 0) {
-                        exit(EXIT_SUCCESS);
-                    }
-                }
+                // Evolve this player's energy and effort, one report per tick
+                player_process_loop(player_idx);
             } else {
                 // In parent: store child's PID
-                teams[t][p].pid = pid;
-                shared_state->players[t][p].pid = pid;
+                match.roster.pid[ROSTER_INDEX(&match.roster, t, p)] = pid;
+                engine_mark_dirty(&match, ROSTER_INDEX(&match.roster, t, p));
 
-                // Close write-end of pipe (parent only reads)
-                close(energy_pipes[player_idx][1]);
                 player_idx++;
             }
         }
@@ -367,367 +710,376 @@ void start_players() {
 // 8) REFEREE CONTROL (MAIN LOOP)
 // --------------------------------------------------------------------
 
+// Wait for the next tick deadline; ticks dropped after an overrun still
+// pass in game time. Returns the ticks that went by.
+static int wait_next_tick(void) {
+    PROFILE_DETAIL(PROF_TICK_WAIT);
+    int dropped = tick_scheduler_begin_wait(&tick_scheduler);
+    referee_wait_until(tick_scheduler.next_deadline);
+    tick_scheduler_end_wait(&tick_scheduler);
+    if (dropped > 0)
+        engine_skip_time(&match, dropped);
+    return 1 + dropped;
+}
+
 // This is the core loop run by the referee to manage game progress
 void referee_control() {
     int ticks_this_second = 0;
-    time_t round_start = time(NULL);
-    last_stats_print_time = time(NULL);
-    static int in_game_seconds_passed = 0;
-
-    while (game_active) {
-        // Run substeps of the simulation logic
-        check_player_falls_partial();
-        recover_players_partial();
-        request_energy_reports_partial();
-        update_rope_position_partial();
+    last_stats_print_time = game_clock_seconds(&game_clock);
+    tick_scheduler_start(&tick_scheduler, &game_clock, TICK_SLEEP_NSEC, tick_policy,
+                         &shared_state->tick_stats);
+
+    while (match.game_active) {
+        {
+            PROFILE_SCOPE(PROF_TICK);
+
+            // The estimator rolls out from the start of a tick
+            if (match.ticks % ESTIMATOR_POST_TICKS == 0) {
+                PROFILE_DETAIL(PROF_ESTIMATE);
+                win_estimator_post(&win_estimator, &match, (float)game_clock_seconds(&game_clock));
+            }
 
-        // Synchronize shared memory state
-        mirror_to_shared_memory();
+            // Run substeps of the simulation logic
+            check_player_falls_partial();
+            recover_players_partial();
+            request_energy_reports_partial();
+            update_rope_position_partial();
+            update_match_stats_partial();
+            tick_trace_record(&tick_trace, &match, (float)game_clock_seconds(&game_clock));
+
+            // Synchronize shared memory state
+            mirror_to_shared_memory();
+            match.ticks++;
+        }
 
-        // Sleep for one game tick
-        usleep(TICK_SLEEP_USEC);
-        ticks_this_second++;
+        ticks_this_second += wait_next_tick();
 
         // Every second, perform time-based updates
         if (ticks_this_second >= TICKS_PER_SECOND) {
-            ticks_this_second = 0;
-            in_game_seconds_passed++;
+            ticks_this_second %= TICKS_PER_SECOND;
+            double now = game_clock_seconds(&game_clock);
 
-            // Print game stats every 5 seconds
-            if (in_game_seconds_passed % 5 == 0) {
-                print_team_stats();
+            // Game stats every 5 seconds, printed by the stats printer
+            if (now - last_stats_print_time >= STATS_PRINT_INTERVAL) {
+                stats_printer_post(&stats_printer);
+                last_stats_print_time = now;
             }
 
-            time_t now = time(NULL);
             // End game if duration expired
-            if ((now - game_start_time) >= config.game_duration) {
+            if (now >= config.game_duration) {
                 printf("\n=== GAME TIME EXPIRED ===\n");
-                game_active = 0;
+                match.game_active = 0;
                 print_game_status();
                 break;
             }
 
-            // Check if a team won the round
+            // Check if a team won the round; a new round starts after
+            // a countdown the tick schedule must not try to catch up on
+            int round_before = match.round_number;
             check_round_winner();
+            if (match.round_number != round_before)
+                tick_scheduler_resync(&tick_scheduler);
         }
     }
 
     // Determine final match result if game ended
-    time_t now = time(NULL);
-    if ((now - game_start_time) >= config.game_duration) {
-        if (team_round_wins[0] > team_round_wins[1]) {
-            printf("\n=== GAME TIME EXPIRED: Team 1 wins the match by round wins! ===\n");
-            notify_match_result(0);
-        } else if (team_round_wins[1] > team_round_wins[0]) {
-            printf("\n=== GAME TIME EXPIRED: Team 2 wins the match by round wins! ===\n");
-            notify_match_result(1);
+    if (game_clock_seconds(&game_clock) >= config.game_duration) {
+        int winner = engine_winner_by_rounds(&match);
+        match.winner = winner;
+        if (winner >= 0) {
+            printf("\n=== GAME TIME EXPIRED: Team %d wins the match by round wins! ===\n", winner + 1);
+            notify_match_result(winner);
         } else {
             printf("\n=== GAME TIME EXPIRED: The match is a tie! ===\n");
+            tick_trace_event(&tick_trace, TRACE_EV_MATCH_END, -1);
         }
     }
+
+    tick_stats_print(&shared_state->tick_stats);
+    referee_loop_print(&referee_loop);
 }
 
+// An attached recorder must take every snapshot before the next one
+// replaces it; stop waiting if it has gone away
+static void wait_for_recorder(void) {
+    if (!__atomic_load_n(&shared_state->recorder_attached, __ATOMIC_ACQUIRE))
+        return;
+    PROFILE_DETAIL(PROF_RECORDER_WAIT);
+    while (__atomic_load_n(&shared_state->recorder_attached, __ATOMIC_ACQUIRE) &&
+           __atomic_load_n(&shared_state->recorder_seen, __ATOMIC_ACQUIRE) != shared_state->publish_count) {
+        if (waitpid(vis_pid, NULL, WNOHANG) == vis_pid) {
+            fprintf(stderr, "Recorder exited early; recording stopped\n");
+            shared_state->recorder_attached = 0;
+            vis_pid = -1;
+            break;
+        }
+        struct timespec ts = { 0, 20000L };
+        nanosleep(&ts, NULL);
+    }
+}
+
+// Changes of the previous publish: the back buffer is two publishes
+// old, so it still lacks them
+static int32_t *published_list = NULL;
+static int published_count = 0;
+static int published_all = 0;
+static int published_hot[NUM_TEAMS];
+static uint32_t change_seq = 0;           // Bumped by every publish that changes something
+
 // Sync the current internal game state with the shared memory block
+//  The whole frame goes into the back buffer and is published at once,
+//  so the visualizer never sees totals and players from different ticks.
+//  Only the player slots the engine marked dirty (plus the energy/effort
+//  columns of teams with someone pulling) are copied.
 void mirror_to_shared_memory() {
-    shared_state->rope_position = rope_position;
-    shared_state->round_number  = round_number;
-    shared_state->team_round_wins[0] = team_round_wins[0];
-    shared_state->team_round_wins[1] = team_round_wins[1];
+    PROFILE_DETAIL(PROF_MIRROR);
+    const Roster *src = &match.roster;
+    wait_for_recorder();
+    if (published_list == NULL) {
+        published_list = malloc((size_t)src->num_teams * src->stride * sizeof(int32_t));
+        if (published_list == NULL) {
+            perror("malloc failed");
+            exit(EXIT_FAILURE);
+        }
+        published_all = 1;
+    }
 
-    // Copy team effort values
-    for (int t = 0; t < config.num_teams; t++) {
-        shared_state->team_efforts[t] = team_efforts[t];
+    StateSnapshot *snap = shared_state_begin_write(shared_state);
+    Roster dst;
+    snapshot_roster(shared_state, snap, &dst);
+
+    // Summary fields are always written; a change bumps change_seq
+    int changed = match.all_dirty || match.dirty_count > 0;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        changed |= match.hot_dirty[t];
+    }
+    StateSnapshot next;
+    memset(&next, 0, sizeof(next));
+    next.rope_position = match.rope_position;
+    next.round_number  = match.round_number;
+    next.game_ended    = game_ended;
+    next.final_winner  = game_ended ? match.winner : -1;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        next.team_round_wins[t] = match.team_round_wins[t];
+        next.team_efforts[t]    = match.team_efforts[t];
+    }
+    static StateSnapshot last;
+    if (changed || change_seq == 0 ||
+        next.rope_position != last.rope_position || next.round_number != last.round_number ||
+        next.game_ended != last.game_ended ||
+        memcmp(next.team_round_wins, last.team_round_wins, sizeof(next.team_round_wins)) != 0 ||
+        memcmp(next.team_efforts, last.team_efforts, sizeof(next.team_efforts)) != 0) {
+        change_seq++;
+        last = next;
     }
 
-    // Copy each player's current status
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            shared_state->players[t][p] = teams[t][p];
+    snap->change_seq    = change_seq;
+    snap->rope_position = next.rope_position;
+    snap->round_number  = next.round_number;
+    snap->game_seconds  = (float)game_clock_seconds(&game_clock);
+    snap->game_ended    = next.game_ended;
+    snap->final_winner  = next.final_winner;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        snap->team_round_wins[t] = next.team_round_wins[t];
+        snap->team_efforts[t]    = next.team_efforts[t];
+    }
+
+    // Players: this publish's changes and the previous one's
+    if (match.all_dirty || published_all) {
+        memcpy((char *)snap + shared_state->roster_offset, match.roster_block,
+               roster_block_size(src->num_teams, src->players_per_team));
+    } else {
+        for (int t = 0; t < NUM_TEAMS; t++) {
+            if (match.hot_dirty[t] || published_hot[t])
+                roster_copy_hot(&dst, src, t);
         }
+        for (int k = 0; k < published_count; k++) {
+            roster_copy_slot(&dst, src, published_list[k]);
+        }
+        for (int k = 0; k < match.dirty_count; k++) {
+            roster_copy_slot(&dst, src, match.dirty_list[k]);
+        }
+    }
+    shared_state_end_write(shared_state, snap);
+    if (spectator_feed.num_viewers > 0) {
+        PROFILE_DETAIL(PROF_SPECTATORS);
+        spectator_feed_publish(&spectator_feed, snap);
     }
+
+    // This publish's changes become the ones the other buffer lacks
+    memcpy(published_list, match.dirty_list, match.dirty_count * sizeof(int32_t));
+    published_count = match.dirty_count;
+    published_all = match.all_dirty;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        published_hot[t] = match.hot_dirty[t];
+    }
+    engine_clear_changes(&match);
 }
 
 // --------------------------------------------------------------------
 // 9) GAME LOGIC FUNCTIONS
 // --------------------------------------------------------------------
 
-// Print current stats for teams and players
-void print_team_stats() {
-    time_t now = time(NULL);
-    int elapsed = (int)(now - game_start_time);
-    printf("\n=== Game Stats at %d seconds (Round %d) ===\n", elapsed, round_number);
-    printf("Rope Position: %.2f/%.2f\n", rope_position, config.rope_threshold);
-    printf("Scores: Team 1: %d, Team 2: %d\n", team_round_wins[0], team_round_wins[1]);
-    for (int t = 0; t < NUM_TEAMS; t++) {
-        printf("\nTeam %d Players:\n", t + 1);
-        printf("ID  | Energy | Effort | Status     | Position\n");
-        printf("----|--------|--------|------------|---------\n");
-        for (int p = 0; p < PLAYERS_PER_TEAM; p++) {
-            printf("%2d  | %6.1f | %6.1f | %-10s | %d\n",
-                   p + 1,
-                   teams[t][p].energy,
-                   teams[t][p].effort,
-                   teams[t][p].recovering ? "Recovering" : (teams[t][p].active ? "Active" : "Inactive"),
-                   teams[t][p].position);
-        }
-        printf("Total Team Effort: %.2f\n", team_efforts[t]);
-    }
-    printf("\n");
-}
-
 // Check if any player falls down due to fatigue or randomness
 void check_player_falls_partial() {
-    float p_fall_this_tick = config.fall_probability / (float)TICKS_PER_SECOND;
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            if (teams[t][p].active && !teams[t][p].recovering) {
-                float r = (float)rand() / (float)RAND_MAX;
-                if (r < p_fall_this_tick) {
-                    teams[t][p].recovering = 1;
-                    teams[t][p].effort = 0.0f;
-                    teams[t][p].recover_time = time(NULL) +
-                        (rand() % (config.fall_recovery_max - config.fall_recovery_min + 1))
-                        + config.fall_recovery_min;
-                }
-            }
-        }
-    }
+    PROFILE_DETAIL(PROF_FALLS);
+    engine_check_player_falls(&match);
 }
 
 // This function checks if recovering players have finished their recovery period
 void recover_players_partial() {
-    time_t now = time(NULL);  // Get current time
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            // If a player is recovering and their recovery time has passed
-            if (teams[t][p].recovering && now >= teams[t][p].recover_time) {
-                teams[t][p].recovering = 0;  // Mark player as recovered
-                teams[t][p].effort = teams[t][p].energy;  // Set effort equal to current energy
-            }
-        }
-    }
+    PROFILE_DETAIL(PROF_RECOVERIES);
+    engine_recover_players(&match);
 }
 
-// This function updates the effort of active, non-recovering players
+// The players update the energy and effort of their active, non-recovering
+// selves; the referee only adds up the team totals they report
 void request_energy_reports_partial() {
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            if (teams[t][p].active && !teams[t][p].recovering) {
-                // First, apply energy decay per tick
-                float dec = teams[t][p].decay_rate / (float)TICKS_PER_SECOND;
-                teams[t][p].energy -= dec;
-
-                // Make sure energy doesn’t go negative
-                if (teams[t][p].energy < 0)
-                    teams[t][p].energy = 0;
-
-                // Set effort as energy multiplied by the player's position (1..4)
-                int pos = teams[t][p].position;
-                teams[t][p].effort = teams[t][p].energy * (float)pos;
-            }
-        }
+    PROFILE_DETAIL(PROF_ENERGY);
+    float totals[NUM_TEAMS];
+    energy_reports_post(energy_reports);
+    while (!energy_reports_done(energy_reports)) {
+        // The last report wakes the loop; a lost player never reports
+        LoopEvent ev;
+        if (referee_loop_next(&referee_loop, &ev, 1))
+            take_tick_event(&ev);
+        if (players_lost)
+            return;
     }
+    energy_reports_gather(energy_reports, totals);
+    engine_set_team_efforts(&match, totals);
+}
+
+// Fold the tick into the streaming statistics in shared memory
+void update_match_stats_partial() {
+    PROFILE_DETAIL(PROF_STATS);
+    match_stats_tick(shared_state_stats(shared_state), &match, (float)game_clock_seconds(&game_clock));
 }
 
 // Calculates total effort for both teams and updates rope position accordingly
 void update_rope_position_partial() {
-    float total_effort[NUM_TEAMS] = {0.0f, 0.0f};
-
-    // Sum up effort from all active and non-recovering players
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            if (teams[t][p].active && !teams[t][p].recovering) {
-                total_effort[t] += teams[t][p].effort;
-            }
-        }
-    }
-
-    // Store calculated team efforts in the global array
-    for (int t = 0; t < config.num_teams; t++) {
-        team_efforts[t] = total_effort[t];
-    }
-
-    // Determine how much the rope moves this tick based on effort difference
-    float diff = total_effort[0] - total_effort[1];
-    float increment = (diff * 0.05f) / (float)TICKS_PER_SECOND;
-    rope_position -= increment;
-
-    // Clamp rope position within allowed threshold
-    if (rope_position > config.rope_threshold)
-        rope_position = config.rope_threshold;
-    if (rope_position < -config.rope_threshold)
-        rope_position = -config.rope_threshold;
+    PROFILE_DETAIL(PROF_ROPE);
+    engine_update_rope(&match);
 }
 
 // Checks if a round has ended, determines the winner, and prepares for the next round
 void check_round_winner() {
-    int allExhausted = 1;
-
-    // Check if all players from both teams are out of energy
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            if (teams[t][p].energy > 0) {
-                allExhausted = 0;
-                break;
-            }
-        }
-        if (!allExhausted) break;
+    PROFILE_SCOPE(PROF_ROUND_CHECK);
+    RoundResult result = engine_check_round_winner(&match);
+    int winning_team = match.round_winner;
+
+    // Decided rounds set the horizon of expected-effort alignment
+    if (result != ROUND_NONE) {
+        decided_round_ticks += match.ticks - round_start_tick;
+        rounds_decided++;
     }
 
-    // If rope moved far enough or everyone is exhausted, round ends
-    if (fabs(rope_position) >= config.round_win_threshold || allExhausted) {
-        int winning_team;
-
-        // Decide winner based on rope position
-        if (rope_position < 0)
-            winning_team = 0;
-        else if (rope_position > 0)
-            winning_team = 1;
-        else
-            winning_team = 0;
-
-        // If all players are exhausted, announce the round winner based on rope state
-        if (allExhausted) {
-            printf("=== All players exhausted. Round winner: Team %d ===\n", winning_team + 1);
-            team_round_wins[winning_team]++;
-            notify_round_result(winning_team);
-            game_active = 0;
-            notify_match_result(winning_team);
-            return;
-        } else {
-            // Otherwise, it's a regular win by reaching the rope threshold
-            team_round_wins[winning_team]++;
-            team_consecutive_wins[winning_team]++;
-
-            // Reset the losing team's consecutive win counter
-            for (int t = 0; t < config.num_teams; t++) {
-                if (t != winning_team)
-                    team_consecutive_wins[t] = 0;
-            }
-
-            notify_round_result(winning_team);
-
-            // Check if team has won enough rounds in a row to win the match
-            if (team_consecutive_wins[winning_team] >= config.consecutive_rounds_to_win) {
-                printf("=== Team %d wins the match by achieving %d consecutive wins! ===\n",
-                       winning_team + 1, config.consecutive_rounds_to_win);
-                game_active = 0;
-                notify_match_result(winning_team);
-                return;
-            }
-
-            // Prepare for a new round: align teams and reset rope
-            printf("Aligning teams for new round...\n");
-            align_all_teams();
-
-            // Countdown before restarting the round
-            printf("Next round starting in:\n");
-            countdown(5);
-
-            round_number++;
-            rope_position = 0.0f;
-            for (int t = 0; t < config.num_teams; t++) {
-                team_efforts[t] = 0.0f;
-            }
-        }
+    switch (result) {
+    case ROUND_NONE:
+        break;
+
+    case MATCH_EXHAUSTED:
+        // All players are exhausted, the round winner takes the match
+        printf("=== All players exhausted. Round winner: Team %d ===\n", winning_team + 1);
+        notify_round_result(winning_team);
+        notify_match_result(winning_team);
+        break;
+
+    case MATCH_WON:
+        notify_round_result(winning_team);
+        printf("=== Team %d wins the match by achieving %d consecutive wins! ===\n",
+               winning_team + 1, config.consecutive_rounds_to_win);
+        notify_match_result(winning_team);
+        break;
+
+    case ROUND_WON:
+        notify_round_result(winning_team);
+
+        // Prepare for a new round: align teams and reset rope
+        printf("Aligning teams for new round...\n");
+        align_all_teams();
+
+        // Countdown before restarting the round
+        printf("Next round starting in:\n");
+        countdown(5);
+
+        engine_start_new_round(&match);
+        break;
     }
 }
 
-// Notifies all players about the round result using signals
+// Announces the round result to every player with one wake-up
 void notify_round_result(int winning_team) {
+    PROFILE_SCOPE(PROF_NOTIFY_ROUND);
     printf("=== Round Winner: Team %d ===\n", winning_team+1);
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            if (t == winning_team)
-                kill(teams[t][p].pid, SIG_WIN_ROUND);  // Signal win
-            else
-                kill(teams[t][p].pid, SIG_LOSE_ROUND);  // Signal loss
-        }
-    }
+    tick_trace_event(&tick_trace, TRACE_EV_ROUND, winning_team);
+    energy_reports_announce(energy_reports, RESULT_ROUND, winning_team);
 }
 
-// Notifies players about the final match result
+// Announces the final match result the same way
 void notify_match_result(int winning_team) {
+    PROFILE_SCOPE(PROF_NOTIFY_MATCH);
     printf("=== Match Winner: Team %d ===\n", winning_team+1);
-    shared_state->final_winner = winning_team;
-    shared_state->game_ended = 1;
-    for (int t = 0; t < config.num_teams; t++) {
-        for (int p = 0; p < config.players_per_team; p++) {
-            if (kill(teams[t][p].pid, 0) == 0) {
-                if (t == winning_team)
-                    kill(teams[t][p].pid, SIG_MATCH_WIN);
-                else
-                    kill(teams[t][p].pid, SIG_MATCH_LOSE);
-            }
-        }
-    }
+    match.winner = winning_team;
+    game_ended = 1;
+    tick_trace_event(&tick_trace, TRACE_EV_MATCH_END, winning_team);
+    mirror_to_shared_memory();
+    energy_reports_announce(energy_reports, RESULT_MATCH, winning_team);
 }
 
-// Aligns players on a single team by sorting them by energy
-void align_team(int team_index) {
-    int indices[config.players_per_team];
-
-    // Collect player indices for sorting
-    for (int i = 0; i < config.players_per_team; i++) {
-        indices[i] = i;
-    }
-
-    // Simple bubble sort to sort indices based on player energy
-    for (int i = 0; i < config.players_per_team - 1; i++) {
-        for (int j = i + 1; j < config.players_per_team; j++) {
-            if (teams[team_index][indices[i]].energy > teams[team_index][indices[j]].energy) {
-                int temp = indices[i];
-                indices[i] = indices[j];
-                indices[j] = temp;
-            }
-        }
-    }
-
-    int new_order[config.players_per_team];
-
-    // For Team 1, higher energy players get higher positions
-    // For Team 2, lower energy players get lower positions
-    if (team_index == 0) {
-        new_order[0] = indices[3];
-        new_order[1] = indices[2];
-        new_order[2] = indices[1];
-        new_order[3] = indices[0];
+// Aligns players on a single team by sorting them by energy, or with
+// --align-budget by the energy they are expected to pull with next round
+void align_team(int team_index, int64_t deadline_ns) {
+    // Without the order the team is still aligned, just not listed
+    int *new_order = malloc(config.players_per_team * sizeof(int));
+    if (!new_order)
+        perror("Alignment order");
+
+    int aligned;
+    if (align_budget_ms > 0.0) {
+        // Horizon: the mean decided round so far, until then an even
+        // share of the game time
+        int64_t horizon = rounds_decided > 0
+            ? decided_round_ticks / rounds_decided
+            : (int64_t)config.game_duration * TICKS_PER_SECOND / (config.total_rounds > 0 ? config.total_rounds : 1);
+        aligned = engine_align_team_expected(&match, team_index, new_order, horizon, deadline_ns);
+        if (aligned > 0)
+            aligns_optimized++;
+        else if (aligned == 0)
+            aligns_fallback++;
     } else {
-        new_order[0] = indices[0];
-        new_order[1] = indices[1];
-        new_order[2] = indices[2];
-        new_order[3] = indices[3];
+        aligned = engine_align_team(&match, team_index, new_order);
     }
-
-    // Assign positions and recalculate effort accordingly
-    for (int i = 0; i < config.players_per_team; i++) {
-        if (team_index == 0) {
-            teams[team_index][ new_order[i] ].position = 4 - i;
-        } else {
-            teams[team_index][ new_order[i] ].position = i + 1;
-        }
-
-        teams[team_index][ new_order[i] ].effort =
-            teams[team_index][ new_order[i] ].energy * (float)teams[team_index][ new_order[i] ].position;
+    if (aligned < 0) {
+        fprintf(stderr, "Team %d could not be aligned (out of memory); it keeps its order\n", team_index + 1);
+        free(new_order);
+        return;
     }
+    if (!new_order)
+        return;
 
     // Print new team order for debugging
+    const Roster *r = &match.roster;
     printf("Team %d aligned order (player index: new position, energy, effort): ", team_index + 1);
-    for (int i = 0; i < config.players_per_team; i++) {
+    for (int i = 0; i < config.players_per_team && i < STATS_MAX_ROWS; i++) {
         int idx = new_order[i];
-        printf("(%d: %d, %.1f, %.1f) ", idx,
-               teams[team_index][idx].position,
-               teams[team_index][idx].energy,
-               teams[team_index][idx].effort);
+        int k = ROSTER_INDEX(r, team_index, idx);
+        printf("(%d: %d, %.1f, %.1f) ", idx, r->position[k], r->energy[k], r->effort[k]);
     }
+    if (config.players_per_team > STATS_MAX_ROWS)
+        printf("...");
     printf("\n");
+    free(new_order);
 }
 
 // Aligns both teams before a new round begins
 void align_all_teams(void) {
+    PROFILE_SCOPE(PROF_ALIGN);
+    int64_t deadline_ns = monotonic_ns() + (int64_t)(align_budget_ms * 1e6);
     for (int t = 0; t < config.num_teams; t++) {
-        align_team(t);
+        align_team(t, deadline_ns);
     }
+    tick_trace_event(&tick_trace, TRACE_EV_ALIGN, -1);
 
     // Reflect team changes into shared memory for other processes
     mirror_to_shared_memory();
@@ -735,37 +1087,71 @@ void align_all_teams(void) {
 
 // Simple countdown before the game resumes
 void countdown(int seconds) {
+    PROFILE_SCOPE(PROF_COUNTDOWN);
     for (int i = seconds; i > 0; i--) {
         printf("%d...\n", i);
         fflush(stdout);
-        sleep(1);
+        referee_wait_until(game_clock_now_ns(&game_clock) + NSEC_PER_SEC);
     }
     printf("Go!\n");
+
+    // The game clock kept running: recoveries carry on, falls wait
+    engine_skip_time(&match, (int64_t)seconds * TICKS_PER_SECOND);
+    round_start_tick = match.ticks;
 }
 
 // Cleans up allocated memory and shared state before exit
 void cleanup() {
-    if (vis_pid > 0) {
+    win_estimator_stop(&win_estimator);
+    stats_printer_stop(&stats_printer);
+    if (vis_pid > 0 && record_path) {
+        // Let the recorder write its last frames
+        __atomic_store_n(&shared_state->closed, 1, __ATOMIC_RELEASE);
+        waitpid(vis_pid, NULL, 0);
+    } else if (vis_pid > 0) {
         kill(vis_pid, SIGTERM);  // Kill visualization process
         waitpid(vis_pid, NULL, 0);  // Wait for it to finish
     }
-    for (int t = 0; t < config.num_teams; t++) {
-        free(teams[t]);  // Free each team's memory
-    }
-    free(teams);  // Free top-level pointer
-    free(team_efforts);  // Free efforts array
-
-    if (shared_state) {
-        munmap(shared_state, sizeof(SharedState));  // Unmap shared memory
+    tick_trace_close(&tick_trace, &match, (float)game_clock_seconds(&game_clock));
+    if (player_threads) {
+        player_pool_stop(&player_pool);
+    } else {
+        // Player processes leave once the reports are closed
+        energy_reports_close(energy_reports);
+        for (int i = 0; i < config.num_teams * config.players_per_team; i++) {
+            pid_t pid = match.roster.pid[ROSTER_INDEX(&match.roster, i / config.players_per_team,
+                                                      i % config.players_per_team)];
+            if (pid > 0)
+                waitpid(pid, NULL, 0);
+        }
+        printf("Player processes: %d of %d heard the match result\n",
+               energy_reports->match_heard, config.num_teams * config.players_per_team);
     }
+    if (aligns_optimized + aligns_fallback > 0)
+        printf("Alignments: %lu by expected effort, %lu fell back to greedy (budget %.2f ms)\n",
+               aligns_optimized, aligns_fallback, align_budget_ms);
+    printf("Results: %u announced, worst announce-to-player latency %.1f us\n",
+           energy_reports->result_generation, energy_reports->max_result_latency_ns / 1000.0);
+    if (energy_reports->late > 0)
+        printf("Energy reports: %llu arrived for an older tick\n",
+               (unsigned long long)energy_reports->late);
+    energy_reports_destroy(energy_reports);
+    energy_reports = NULL;
+    spectator_feed_print(&spectator_feed);
+    spectator_feed_close(&spectator_feed);
+    referee_loop_close(&referee_loop);
+    engine_free_match(&match);  // Free every team's memory
+
+    shared_state_destroy(shared_state);  // Unmap shared memory
+    shared_state = NULL;
 }
 
 // Displays game status such as rope position and team stats
 void print_game_status() {
     printf("\n=== GAME STATUS ===\n");
-    printf("Rope Position: %.2f\n", rope_position);
-    for (int t = 0; t < config.num_teams; t++) {
+    printf("Rope Position: %.2f\n", match.rope_position);
+    for (int t = 0; t < NUM_TEAMS; t++) {
         printf("Team %d: Round Wins: %d, Consecutive Wins: %d, Total Effort: %.2f\n",
-               t + 1, team_round_wins[t], team_consecutive_wins[t], team_efforts[t]);
+               t + 1, match.team_round_wins[t], match.team_consecutive_wins[t], match.team_efforts[t]);
     }
 }
@@ -0,0 +1,831 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/time.h>
+
+#include "engine.h"
+#include "shared_state.h"
+#include "referee_loop.h"
+#include "tick_scheduler.h"
+#include "match_server.h"
+
+// Loop channels: the listening socket, then one per client
+#define CHANNEL_LISTEN 0
+#define CHANNEL_CLIENT 1
+
+typedef struct {
+    int      in_use;
+    uint32_t id;
+    Match    match;
+    int      allocated;                 // Timers kept for the next match in the slot
+    SharedState *ss;                    // Slot in the arena
+
+    // Changes the last publish wrote, which the other snapshot lacks
+    int32_t *published_list;
+    int      published_count;
+    int      published_all;
+    int      published_hot[NUM_TEAMS];
+} ServerMatch;
+
+typedef struct {
+    int    fd;                          // -1 when free
+    size_t len;
+    char   buf[SERVER_LINE_MAX];
+} ServerClient;
+
+typedef struct {
+    const GameConfig *cfg;
+    GameClock *clock;
+    ServerMatch *matches;
+    int      max_matches;
+    int      live;
+    uint32_t next_id;
+    void    *arena;
+    size_t   slot_size;
+    size_t   arena_size;
+    int      arena_fd;                  // Read-only fd of the arena's memfd, -1 if anonymous
+
+    // Rosters of chunk c: one roster of SERVER_CHUNK * num_teams teams,
+    // match slot c * SERVER_CHUNK + k owning teams [k * num_teams, ...)
+    Roster  *chunk_rosters;
+    void   **chunk_blocks;              // NULL until a match is made in the chunk
+    const TickKernel *kernel;
+
+    RefereeLoop  loop;
+    int          listen_fd;
+    ServerClient clients[SERVER_MAX_CLIENTS];
+    int          stop;
+
+    // Tick pass over the slots, shared with the workers
+    pthread_mutex_t lock;
+    pthread_cond_t  go;                 // A pass started, or closing
+    pthread_cond_t  done;               // The last worker finished its part
+    pthread_t *workers;
+    int        num_workers;
+    uint64_t   pass;                    // Passes started
+    int        next_slot;               // Next slot nobody has claimed yet
+    int        busy;                    // Workers still in the pass
+    int        closed;
+
+    // Counters
+    uint64_t ticks;
+    uint64_t created;
+    int      max_live;
+    int64_t  pass_ns_total;
+    int64_t  pass_ns_max;
+} MatchServer;
+
+// ----------------------------------------------------------
+// Tick pass
+// ----------------------------------------------------------
+
+// Publish a match to its slot: summary, the players that changed since
+// the back snapshot was written, and the tick into the statistics
+static void publish_match(ServerMatch *sm, unsigned events) {
+    Match *m = &sm->match;
+    SharedState *ss = sm->ss;
+    float seconds = (float)m->ticks / TICKS_PER_SECOND;
+
+    StateSnapshot *snap = shared_state_begin_write(ss);
+    Roster dst;
+    snapshot_roster(ss, snap, &dst);
+    snap->change_seq    = ss->publish_count + 1;
+    snap->rope_position = m->rope_position;
+    snap->round_number  = m->round_number;
+    snap->game_seconds  = seconds;
+    snap->game_ended    = !m->game_active;
+    snap->final_winner  = m->game_active ? -1 : m->winner;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        snap->team_round_wins[t] = m->team_round_wins[t];
+        snap->team_efforts[t]    = m->team_efforts[t];
+    }
+
+    // Players: this publish's changes and the previous one's
+    if (m->all_dirty || sm->published_all) {
+        for (int t = 0; t < m->roster.num_teams; t++) {
+            roster_copy_team(&dst, &m->roster, t);
+        }
+    } else {
+        for (int t = 0; t < NUM_TEAMS; t++) {
+            if (m->hot_dirty[t] || sm->published_hot[t])
+                roster_copy_hot(&dst, &m->roster, t);
+        }
+        for (int k = 0; k < sm->published_count; k++) {
+            roster_copy_slot(&dst, &m->roster, sm->published_list[k]);
+        }
+        for (int k = 0; k < m->dirty_count; k++) {
+            roster_copy_slot(&dst, &m->roster, m->dirty_list[k]);
+        }
+    }
+    shared_state_end_write(ss, snap);
+
+    memcpy(sm->published_list, m->dirty_list, m->dirty_count * sizeof(int32_t));
+    sm->published_count = m->dirty_count;
+    sm->published_all = m->all_dirty;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        sm->published_hot[t] = m->hot_dirty[t];
+    }
+    engine_clear_changes(m);
+
+    if (events & ENGINE_EV_TICK)
+        match_stats_tick(shared_state_stats(ss), m, seconds);
+}
+
+// Claim the next chunk of slots, which always starts a chunk roster;
+// returns how many were claimed
+static int claim_chunk(MatchServer *s, int *first) {
+    pthread_mutex_lock(&s->lock);
+    *first = s->next_slot;
+    int count = s->max_matches - s->next_slot;
+    if (count > SERVER_CHUNK)
+        count = SERVER_CHUNK;
+    s->next_slot += count;
+    pthread_mutex_unlock(&s->lock);
+    return count;
+}
+
+// Step and publish claimed chunks until none are left. The matches of
+// a chunk in a tick of play share one roster, so every run of them
+// back to back goes through the tick kernel in a single call.
+static void run_chunks(MatchServer *s) {
+    int teams = s->cfg->num_teams;
+    int first, count;
+    while ((count = claim_chunk(s, &first)) > 0) {
+        const Roster *chunk = &s->chunk_rosters[first / SERVER_CHUNK];
+        int live[SERVER_CHUNK], playing[SERVER_CHUNK];
+        float sums[SERVER_CHUNK * NUM_TEAMS];
+
+        // Countdowns, falls and recoveries, match by match
+        for (int k = 0; k < count; k++) {
+            ServerMatch *sm = &s->matches[first + k];
+            live[k] = sm->in_use && sm->match.game_active;
+            playing[k] = live[k] && engine_step_begin(&sm->match);
+        }
+
+        // Energy and effort of every player of a run of matches in play
+        for (int k = 0; k < count; ) {
+            if (!playing[k]) {
+                k++;
+                continue;
+            }
+            int end = k;
+            while (end < count && playing[end])
+                end++;
+            size_t off = (size_t)k * teams * chunk->stride;
+            s->kernel->run_teams(chunk->energy + off, chunk->effort + off, chunk->decay_rate + off,
+                                 chunk->position + off, chunk->state + off,
+                                 chunk->stride, (end - k) * teams, sums + k * teams);
+            k = end;
+        }
+
+        // Rope, round and match checks, then publish
+        for (int k = 0; k < count; k++) {
+            ServerMatch *sm = &s->matches[first + k];
+            if (!live[k])
+                continue;
+            unsigned events = 0;
+            if (playing[k]) {
+                engine_set_team_efforts(&sm->match, sums + k * teams);
+                events = engine_step_end(&sm->match);
+            }
+            publish_match(sm, events);
+        }
+    }
+}
+
+static void *server_worker(void *arg) {
+    MatchServer *s = arg;
+    uint64_t seen = 0;
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->closed && s->pass == seen) {
+            pthread_cond_wait(&s->go, &s->lock);
+        }
+        if (s->closed)
+            break;
+        seen = s->pass;
+        pthread_mutex_unlock(&s->lock);
+        run_chunks(s);
+        pthread_mutex_lock(&s->lock);
+        if (--s->busy == 0)
+            pthread_cond_signal(&s->done);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+// One tick of every live match
+static void run_pass(MatchServer *s) {
+    int64_t start = monotonic_ns();
+    pthread_mutex_lock(&s->lock);
+    s->next_slot = 0;
+    s->busy = s->num_workers;
+    s->pass++;
+    if (s->num_workers > 0)
+        pthread_cond_broadcast(&s->go);
+    pthread_mutex_unlock(&s->lock);
+
+    run_chunks(s);
+
+    pthread_mutex_lock(&s->lock);
+    while (s->busy > 0) {
+        pthread_cond_wait(&s->done, &s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    int64_t spent = monotonic_ns() - start;
+    s->ticks++;
+    s->pass_ns_total += spent;
+    if (spent > s->pass_ns_max)
+        s->pass_ns_max = spent;
+}
+
+// ----------------------------------------------------------
+// Requests
+// ----------------------------------------------------------
+
+static ServerMatch *find_match(MatchServer *s, uint32_t id) {
+    for (int i = 0; i < s->max_matches; i++) {
+        if (s->matches[i].in_use && s->matches[i].id == id)
+            return &s->matches[i];
+    }
+    return NULL;
+}
+
+static void create_match(MatchServer *s, unsigned int seed, FILE *out) {
+    int slot = -1;
+    for (int i = 0; i < s->max_matches && slot < 0; i++) {
+        if (!s->matches[i].in_use)
+            slot = i;
+    }
+    if (slot < 0) {
+        fprintf(out, "err all %d slots in use\n", s->max_matches);
+        return;
+    }
+
+    ServerMatch *sm = &s->matches[slot];
+    if (!sm->allocated) {
+        // The chunk's roster is made with its first match
+        int c = slot / SERVER_CHUNK, teams = s->cfg->num_teams;
+        size_t size = roster_block_size(SERVER_CHUNK * teams, s->cfg->players_per_team);
+        if (!s->chunk_blocks[c]) {
+            if (posix_memalign(&s->chunk_blocks[c], ROSTER_ALIGN, size) != 0) {
+                s->chunk_blocks[c] = NULL;
+                fprintf(out, "err out of memory\n");
+                return;
+            }
+            memset(s->chunk_blocks[c], 0, size);
+            roster_bind(&s->chunk_rosters[c], s->chunk_blocks[c],
+                        SERVER_CHUNK * teams, s->cfg->players_per_team);
+        }
+        Roster view;
+        roster_view(&view, &s->chunk_rosters[c], (slot % SERVER_CHUNK) * teams, teams);
+        sm->published_list = malloc((size_t)teams * view.stride * sizeof(int32_t));
+        if (!sm->published_list ||
+            engine_init_match_on(&sm->match, s->cfg, &view, seed, (int)(seed % 20)) != 0) {
+            free(sm->published_list);
+            sm->published_list = NULL;
+            fprintf(out, "err out of memory\n");
+            return;
+        }
+        sm->allocated = 1;
+    } else {
+        engine_reset_match(&sm->match, seed, (int)(seed % 20));
+    }
+    engine_begin_match(&sm->match);
+    sm->ss = shared_state_init((char *)s->arena + (size_t)slot * s->slot_size,
+                               s->cfg->num_teams, s->cfg->players_per_team);
+    sm->published_all = 1;             // Both snapshots start empty
+    sm->id = ++s->next_id;
+    sm->in_use = 1;
+    publish_match(sm, 0);
+
+    s->created++;
+    if (++s->live > s->max_live)
+        s->max_live = s->live;
+    fprintf(out, "ok %u %d\n", sm->id, slot);
+}
+
+// Handle one request line, writing the reply to out; *pass_arena is set
+// if the arena's fd must go with the reply
+static void handle_request(MatchServer *s, char *line, FILE *out, int *pass_arena) {
+    char word[16] = "";
+    unsigned long arg = 0;
+    int args = sscanf(line, "%15s %lu", word, &arg);
+
+    if (args >= 1 && strcmp(word, "create") == 0) {
+        unsigned int seed = args == 2 ? (unsigned int)arg
+                                      : (unsigned int)(monotonic_ns() ^ (s->next_id * 2654435761u));
+        create_match(s, seed, out);
+    } else if (args == 2 && strcmp(word, "destroy") == 0) {
+        ServerMatch *sm = find_match(s, (uint32_t)arg);
+        if (sm) {
+            __atomic_store_n(&sm->ss->closed, 1, __ATOMIC_RELEASE);
+            sm->in_use = 0;
+            s->live--;
+            fprintf(out, "ok\n");
+        } else {
+            fprintf(out, "err no match %lu\n", arg);
+        }
+    } else if (args == 2 && strcmp(word, "attach") == 0) {
+        ServerMatch *sm = find_match(s, (uint32_t)arg);
+        if (!sm) {
+            fprintf(out, "err no match %lu\n", arg);
+        } else if (s->arena_fd < 0) {
+            fprintf(out, "err no arena memfd to hand out\n");
+        } else {
+            int slot = (int)(sm - s->matches);
+            fprintf(out, "ok %u %d %zu %zu\n", sm->id, slot, (size_t)slot * s->slot_size, s->slot_size);
+            *pass_arena = 1;
+        }
+    } else if (args >= 1 && strcmp(word, "list") == 0) {
+        for (int i = 0; i < s->max_matches; i++) {
+            const ServerMatch *sm = &s->matches[i];
+            if (!sm->in_use)
+                continue;
+            const Match *m = &sm->match;
+            const char *state = !m->game_active ? "over" : (m->countdown_ticks > 0 ? "countdown" : "playing");
+            fprintf(out, "%u %d %s %d %.2f %d %d %.1f %d\n",
+                    sm->id, i, state, m->round_number, m->rope_position,
+                    m->team_round_wins[0], m->team_round_wins[1],
+                    (double)m->ticks / TICKS_PER_SECOND, m->game_active ? -1 : m->winner);
+        }
+        fprintf(out, "end\n");
+    } else if (args >= 1 && strcmp(word, "stats") == 0) {
+        fprintf(out, "ok matches=%d players=%d ticks=%llu pass_us_mean=%.1f pass_us_max=%.1f\n",
+                s->live, s->live * s->cfg->num_teams * s->cfg->players_per_team,
+                (unsigned long long)s->ticks,
+                s->ticks ? s->pass_ns_total / 1000.0 / (double)s->ticks : 0.0,
+                s->pass_ns_max / 1000.0);
+    } else if (args >= 1 && strcmp(word, "shutdown") == 0) {
+        s->stop = 1;
+        fprintf(out, "ok\n");
+    } else {
+        fprintf(out, "err unknown request\n");
+    }
+}
+
+static void close_client(MatchServer *s, int c) {
+    close(s->clients[c].fd);        // Also takes it out of the epoll set
+    s->clients[c].fd = -1;
+    s->clients[c].len = 0;
+}
+
+static void accept_clients(MatchServer *s) {
+    int fd;
+    while ((fd = accept(s->listen_fd, NULL, NULL)) >= 0) {
+        // Reads never block (MSG_DONTWAIT); a reply may stall the loop
+        // for SERVER_SEND_TIMEOUT_MS at most before the client is dropped
+        struct timeval tv = { 0, SERVER_SEND_TIMEOUT_MS * 1000 };
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        int c = 0;
+        while (c < SERVER_MAX_CLIENTS && s->clients[c].fd >= 0)
+            c++;
+        if (c == SERVER_MAX_CLIENTS ||
+            referee_loop_add_channel(&s->loop, fd, CHANNEL_CLIENT + c) != 0) {
+            const char *busy = "err too many connections\n";
+            send(fd, busy, strlen(busy), MSG_NOSIGNAL);
+            close(fd);
+            continue;
+        }
+        s->clients[c].fd = fd;
+        s->clients[c].len = 0;
+    }
+}
+
+// Send a batch of replies, with the arena's fd if one of them asked for it
+static int send_reply(const MatchServer *s, int fd, const char *reply, size_t len, int pass_arena) {
+    struct iovec iov = { (void *)reply, len };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (pass_arena) {
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cm), &s->arena_fd, sizeof(int));
+    }
+    return sendmsg(fd, &msg, MSG_NOSIGNAL) == (ssize_t)len;
+}
+
+// Read what a client sent and answer every complete line; the replies
+// go out in one send
+static void serve_client(MatchServer *s, int c) {
+    ServerClient *cl = &s->clients[c];
+    for (;;) {
+        ssize_t got = recv(cl->fd, cl->buf + cl->len, sizeof(cl->buf) - 1 - cl->len, MSG_DONTWAIT);
+        if (got < 0 && errno == EAGAIN)
+            return;
+        if (got <= 0) {
+            close_client(s, c);
+            return;
+        }
+        cl->len += (size_t)got;
+        cl->buf[cl->len] = '\0';
+
+        char *reply = NULL;
+        size_t reply_len = 0;
+        FILE *out = open_memstream(&reply, &reply_len);
+        if (!out) {
+            close_client(s, c);
+            return;
+        }
+        char *line = cl->buf, *nl;
+        int pass_arena = 0;
+        while ((nl = strchr(line, '\n')) != NULL) {
+            *nl = '\0';
+            handle_request(s, line, out, &pass_arena);
+            line = nl + 1;
+        }
+        fclose(out);
+        int sent = reply_len == 0 || send_reply(s, cl->fd, reply, reply_len, pass_arena);
+        free(reply);
+
+        cl->len -= (size_t)(line - cl->buf);
+        memmove(cl->buf, line, cl->len);
+        if (!sent || cl->len == sizeof(cl->buf) - 1) {
+            close_client(s, c);     // Not reading its replies, or a line longer than any request
+            return;
+        }
+    }
+}
+
+static void handle_event(MatchServer *s, const LoopEvent *ev) {
+    if (ev->type == LOOP_EV_SIGNAL) {
+        s->stop = 1;
+    } else if (ev->type == LOOP_EV_CHANNEL) {
+        if (ev->channel == CHANNEL_LISTEN)
+            accept_clients(s);
+        else if (ev->channel - CHANNEL_CLIENT < SERVER_MAX_CLIENTS &&
+                 s->clients[ev->channel - CHANNEL_CLIENT].fd >= 0)
+            serve_client(s, ev->channel - CHANNEL_CLIENT);
+    }
+}
+
+// Wait for the next tick deadline, serving requests meanwhile
+static void wait_until(MatchServer *s, int64_t game_deadline_ns) {
+    LoopEvent ev;
+    int64_t wall = game_clock_wall_ns(s->clock, game_deadline_ns);
+    if (wall < 0) {
+        game_clock_sleep_until_ns(s->clock, game_deadline_ns);
+        while (referee_loop_next(&s->loop, &ev, 0))
+            handle_event(s, &ev);
+        return;
+    }
+    referee_loop_arm(&s->loop, wall);
+    while (!s->stop && referee_loop_next(&s->loop, &ev, 1) && ev.type != LOOP_EV_TIMER)
+        handle_event(s, &ev);
+}
+
+// ----------------------------------------------------------
+// Setup and teardown
+// ----------------------------------------------------------
+
+static int open_socket(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    // A socket left over from a server that did not shut down; anything
+    // else at the path is not ours to remove, and bind() reports it
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        perror("bind/listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void stop_workers(MatchServer *s) {
+    pthread_mutex_lock(&s->lock);
+    s->closed = 1;
+    pthread_cond_broadcast(&s->go);
+    pthread_mutex_unlock(&s->lock);
+    for (int i = 0; i < s->num_workers; i++) {
+        pthread_join(s->workers[i], NULL);
+    }
+    free(s->workers);
+    s->workers = NULL;
+    s->num_workers = 0;
+}
+
+static void free_server(MatchServer *s, const char *socket_path) {
+    stop_workers(s);
+    for (int i = 0; s->matches && i < s->max_matches; i++) {
+        if (s->matches[i].in_use)
+            __atomic_store_n(&s->matches[i].ss->closed, 1, __ATOMIC_RELEASE);   // For watchers
+    }
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        if (s->clients[i].fd >= 0)
+            close(s->clients[i].fd);
+    }
+    if (s->listen_fd >= 0) {
+        close(s->listen_fd);
+        unlink(socket_path);
+    }
+    referee_loop_close(&s->loop);
+    if (s->matches) {
+        for (int i = 0; i < s->max_matches; i++) {
+            if (s->matches[i].allocated)
+                engine_free_match(&s->matches[i].match);
+            free(s->matches[i].published_list);
+        }
+    }
+    free(s->matches);
+    for (int c = 0; s->chunk_blocks && c < (s->max_matches + SERVER_CHUNK - 1) / SERVER_CHUNK; c++) {
+        free(s->chunk_blocks[c]);
+    }
+    free(s->chunk_blocks);
+    free(s->chunk_rosters);
+    if (s->arena)
+        munmap(s->arena, s->arena_size);
+    if (s->arena_fd >= 0)
+        close(s->arena_fd);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->go);
+    pthread_cond_destroy(&s->done);
+}
+
+int run_match_server(const char *socket_path, const GameConfig *cfg, GameClock *clock,
+                     int max_matches, int num_workers) {
+    MatchServer s;
+    memset(&s, 0, sizeof(s));
+    s.cfg = cfg;
+    s.clock = clock;
+    s.max_matches = max_matches;
+    s.listen_fd = -1;
+    s.arena_fd = -1;
+    s.loop.epoll_fd = s.loop.signal_fd = s.loop.timer_fd = -1;
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        s.clients[i].fd = -1;
+    }
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.go, NULL);
+    pthread_cond_init(&s.done, NULL);
+
+    // One arena for every slot, behind a memfd that watchers map read-only
+    s.slot_size = shared_state_size(cfg->num_teams, cfg->players_per_team);
+    s.arena_size = s.slot_size * (size_t)max_matches;
+    int fd = shared_state_memfd("tug_of_war_arena", s.arena_size);
+    s.arena = mmap(NULL, s.arena_size, PROT_READ | PROT_WRITE,
+                   fd >= 0 ? MAP_SHARED : MAP_SHARED | MAP_ANONYMOUS, fd, 0);
+    s.matches = calloc((size_t)max_matches, sizeof(ServerMatch));
+    int chunks = (max_matches + SERVER_CHUNK - 1) / SERVER_CHUNK;
+    s.chunk_rosters = calloc((size_t)chunks, sizeof(Roster));
+    s.chunk_blocks = calloc((size_t)chunks, sizeof(void *));
+    s.kernel = tick_kernel_select();
+    if (s.arena == MAP_FAILED || !s.matches || !s.chunk_rosters || !s.chunk_blocks) {
+        perror("Match server arena");
+        if (s.arena == MAP_FAILED)
+            s.arena = NULL;
+        if (fd >= 0)
+            close(fd);
+        free_server(&s, socket_path);
+        return -1;
+    }
+    if (fd >= 0)
+        s.arena_fd = shared_state_seal(fd);
+
+    // Signals stay blocked in every thread and are read from the loop
+    int signals[] = { SIGINT, SIGTERM };
+    if (referee_loop_block(&s.loop, signals, 2) != 0 || referee_loop_open(&s.loop) != 0 ||
+        (s.listen_fd = open_socket(socket_path)) < 0 ||
+        referee_loop_add_channel(&s.loop, s.listen_fd, CHANNEL_LISTEN) != 0) {
+        free_server(&s, socket_path);
+        return -1;
+    }
+
+    s.workers = calloc(num_workers > 0 ? num_workers : 1, sizeof(pthread_t));
+    for (int i = 0; s.workers && i < num_workers; i++) {
+        if (pthread_create(&s.workers[i], NULL, server_worker, &s) != 0)
+            break;
+        s.num_workers++;
+    }
+
+    char clock_desc[64];
+    printf("Match server on %s: up to %d matches of %d x %d players, %d worker thread(s), %s clock\n",
+           socket_path, max_matches, cfg->num_teams, cfg->players_per_team, s.num_workers,
+           game_clock_describe(clock, clock_desc, sizeof(clock_desc)));
+    printf("Arena: %zu bytes per slot, %zu in all\n", s.slot_size, s.arena_size);
+    fflush(stdout);
+
+    TickScheduler sched;
+    TickStats tick_stats;
+    game_clock_start(clock);
+    tick_scheduler_start(&sched, clock, NSEC_PER_SEC / TICKS_PER_SECOND, TICK_CATCH_UP, &tick_stats);
+    while (!s.stop) {
+        run_pass(&s);
+        tick_scheduler_begin_wait(&sched);
+        wait_until(&s, sched.next_deadline);
+        tick_scheduler_end_wait(&sched);
+    }
+
+    printf("\n=== MATCH SERVER ===\n");
+    printf("Matches created: %llu, at most %d at once, %d still open\n",
+           (unsigned long long)s.created, s.max_live, s.live);
+    printf("Tick passes: %llu, mean %.1f us, worst %.1f us\n", (unsigned long long)s.ticks,
+           s.ticks ? s.pass_ns_total / 1000.0 / (double)s.ticks : 0.0, s.pass_ns_max / 1000.0);
+    tick_stats_print(&tick_stats);
+    free_server(&s, socket_path);
+    return 0;
+}
+
+// ----------------------------------------------------------
+// Client
+// ----------------------------------------------------------
+
+// Connect and send one request line; returns the socket or -1
+static int send_request(const char *socket_path, const char *line) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", socket_path);
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("Match server");
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    char req[SERVER_LINE_MAX];
+    int n = snprintf(req, sizeof(req), "%s\n", line);
+    if (n >= (int)sizeof(req) || send(fd, req, (size_t)n, MSG_NOSIGNAL) != n) {
+        fprintf(stderr, "Match server: request not sent\n");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int match_server_request(const char *socket_path, const char *line) {
+    int fd = send_request(socket_path, line);
+    if (fd < 0)
+        return -1;
+
+    // A list ends with "end", everything else is one line
+    int is_list = strncmp(line, "list", 4) == 0;
+    int ok = -1;
+    char buf[4096];
+    size_t len = 0;
+    for (;;) {
+        ssize_t got = read(fd, buf + len, sizeof(buf) - 1 - len);
+        if (got <= 0)
+            break;
+        len += (size_t)got;
+        buf[len] = '\0';
+
+        char *start = buf, *nl;
+        int finished = 0;
+        while ((nl = strchr(start, '\n')) != NULL) {
+            *nl = '\0';
+            printf("%s\n", start);
+            if (!is_list || strcmp(start, "end") == 0) {
+                ok = (is_list || strncmp(start, "ok", 2) == 0) ? 0 : -1;
+                finished = 1;
+                break;
+            }
+            start = nl + 1;
+        }
+        if (finished)
+            break;
+        len -= (size_t)(start - buf);
+        memmove(buf, start, len);
+    }
+    close(fd);
+    return ok;
+}
+
+int match_server_watch(const char *socket_path, unsigned int id) {
+    char line[32];
+    snprintf(line, sizeof(line), "attach %u", id);
+    int fd = send_request(socket_path, line);
+    if (fd < 0)
+        return -1;
+
+    // The reply and the arena's fd arrive in one message
+    char reply[SERVER_LINE_MAX];
+    struct iovec iov = { reply, sizeof(reply) - 1 };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    reply[n > 0 ? n : 0] = '\0';
+    int arena_fd = -1;
+    struct cmsghdr *cm = n > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+    if (cm && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+        memcpy(&arena_fd, CMSG_DATA(cm), sizeof(int));
+
+    unsigned int got_id;
+    int slot;
+    size_t offset, size;
+    struct stat st;
+    void *arena = MAP_FAILED;
+    if (arena_fd >= 0 && sscanf(reply, "ok %u %d %zu %zu", &got_id, &slot, &offset, &size) == 4 &&
+        fstat(arena_fd, &st) == 0 && offset + size <= (size_t)st.st_size)
+        arena = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, arena_fd, 0);
+    if (arena_fd >= 0)
+        close(arena_fd);    // The mapping keeps the arena alive
+    if (arena == MAP_FAILED) {
+        fprintf(stderr, "Match server: %s", n > 0 ? reply : "no reply\n");
+        close(fd);
+        return -1;
+    }
+    const SharedState *ss = (const SharedState *)((char *)arena + offset);
+    StateSnapshot *frame = ss->map_size == size ? shared_state_alloc_snapshot(ss) : NULL;
+    if (frame == NULL) {
+        fprintf(stderr, "Match server: slot %d is not a match state\n", slot);
+        munmap(arena, (size_t)st.st_size);
+        close(fd);
+        return -1;
+    }
+    printf("Watching match %u in slot %d: %d teams of %d players\n",
+           got_id, slot, ss->num_teams, ss->players_per_team);
+
+    // Read the slot until the match is over or gone; the request
+    // connection stays open and hangs up if the server goes away
+    int shown = -1, gone = 0;
+    uint32_t last = 0;
+    for (;;) {
+        int closed = __atomic_load_n(&ss->closed, __ATOMIC_ACQUIRE);
+        shared_state_read(ss, frame);
+        if (closed || frame->publish_count < last) {
+            gone = 1;       // Destroyed, perhaps already reused by another match
+            break;
+        }
+        last = frame->publish_count;
+        if ((int)frame->game_seconds != shown) {
+            shown = (int)frame->game_seconds;
+            printf("[%4d s] Round %d | Rope %7.2f | Wins %d-%d | Effort %.1f vs %.1f\n",
+                   shown, frame->round_number, frame->rope_position,
+                   frame->team_round_wins[0], frame->team_round_wins[1],
+                   frame->team_efforts[0], frame->team_efforts[1]);
+            fflush(stdout);
+        }
+        if (frame->game_ended)
+            break;
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        char byte;
+        if (poll(&pfd, 1, SERVER_WATCH_POLL_MS) > 0 && recv(fd, &byte, 1, MSG_DONTWAIT) <= 0) {
+            gone = 1;
+            break;
+        }
+    }
+
+    int ended = !gone && frame->game_ended;
+    if (!ended)
+        printf("Match %u was destroyed or the server shut down before it ended\n", got_id);
+    else if (frame->final_winner >= 0)
+        printf("Match over: Team %d wins (%d-%d)\n", frame->final_winner + 1,
+               frame->team_round_wins[0], frame->team_round_wins[1]);
+    else
+        printf("Match over: tie (%d-%d)\n", frame->team_round_wins[0], frame->team_round_wins[1]);
+    free(frame);
+    munmap(arena, (size_t)st.st_size);
+    close(fd);
+    return ended ? 0 : -1;
+}
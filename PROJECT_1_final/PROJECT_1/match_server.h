@@ -0,0 +1,66 @@
+#ifndef MATCH_SERVER_H
+#define MATCH_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "game_clock.h"
+
+// ----------------------------------------------------------
+// Multi-match referee server
+//  One long-lived process hosts up to max_matches independent
+//  headless matches, each played on the game clock with the
+//  rules of engine_run_match() (engine_step()). Every match
+//  publishes to a SharedState slot of its own (snapshots and
+//  streaming statistics); the slots are laid out back to back
+//  in one shared arena mapping, slot i at i * slot_size.
+//
+//  All matches tick on the same deadlines. On each one, the
+//  live matches are stepped and published in a single pass,
+//  handed out in chunks of SERVER_CHUNK slots to the event
+//  loop thread and the optional worker threads. The players
+//  of a chunk's matches live in one roster, so the tick kernel
+//  updates every match of a chunk in play in one call; falls,
+//  recoveries and the round checks stay per match. A publish
+//  copies only the players that changed (engine dirty lists).
+//
+//  Between ticks the loop waits on one epoll set: the tick
+//  timer, SIGINT/SIGTERM (shut down) and a Unix stream socket
+//  that takes one request per line:
+//
+//    create [seed]   -> ok ID SLOT
+//    destroy ID      -> ok
+//    attach ID       -> ok ID SLOT OFFSET SIZE, with a read-only fd of
+//                       the arena's sealed memfd (SCM_RIGHTS): the
+//                       match's SharedState is the SIZE bytes at OFFSET
+//    list            -> one line per match, then "end":
+//                       ID SLOT countdown|playing|over ROUND ROPE
+//                       WINS1 WINS2 SECONDS WINNER
+//    stats           -> ok matches=N players=N ticks=N pass_us_mean=X pass_us_max=X
+//    shutdown        -> ok
+//
+//  Failed requests answer "err REASON". A finished match keeps
+//  its slot, state "over", until it is destroyed; destroying it
+//  (or shutting down) sets the slot's closed flag for watchers.
+// ----------------------------------------------------------
+
+#define SERVER_CHUNK        16      // Match slots claimed at a time in a pass
+#define SERVER_MAX_CLIENTS  64      // Request connections open at once
+#define SERVER_LINE_MAX     256     // Longest request line
+#define SERVER_SEND_TIMEOUT_MS 100  // Longest a reply may wait for a slow client
+#define SERVER_WATCH_POLL_MS 50     // How often a watcher reads its slot
+
+// Serve matches of cfg's shape on socket_path until shut down.
+// Returns 0 on a clean shutdown, -1 if the server could not start.
+int run_match_server(const char *socket_path, const GameConfig *cfg, GameClock *clock,
+                     int max_matches, int num_workers);
+
+// Client side: send one request line and print the reply. Returns 0
+// if the server answered "ok" (or a list), -1 otherwise.
+int match_server_request(const char *socket_path, const char *line);
+
+// Attach to match id's slot and print a line per game second until the
+// match ends. Returns 0 if the end of the match was seen.
+int match_server_watch(const char *socket_path, unsigned int id);
+
+#endif /* MATCH_SERVER_H */
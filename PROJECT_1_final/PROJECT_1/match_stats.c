@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "match_stats.h"
+
+size_t match_stats_size(int num_teams, int players_per_team) {
+    return sizeof(MatchStats) + (size_t)num_teams * players_per_team * sizeof(PlayerStats);
+}
+
+void match_stats_init(MatchStats *ms, int num_teams, int players_per_team) {
+    ms->num_teams        = num_teams;
+    ms->players_per_team = players_per_team;
+}
+
+// ----------------------------------------------------------
+// Quantile sketch
+// ----------------------------------------------------------
+
+// Bucket of an effort: 0 below 2^MIN_EXP, then SUB per octave
+static int sketch_bucket(float v) {
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    int exp = (int)((u >> 23) & 0xff) - 127;
+    if ((u & 0x80000000u) || exp < STATS_SKETCH_MIN_EXP)
+        return 0;
+    if (exp >= STATS_SKETCH_MIN_EXP + STATS_SKETCH_OCTAVES)
+        return STATS_SKETCH_BUCKETS - 1;
+    return 1 + ((exp - STATS_SKETCH_MIN_EXP) << STATS_SKETCH_SUB_BITS)
+             + (int)((u >> (23 - STATS_SKETCH_SUB_BITS)) & (STATS_SKETCH_SUB - 1));
+}
+
+// Middle of a bucket's range
+static double sketch_value(int b) {
+    if (b == 0)
+        return 0.0;
+    int exp = ((b - 1) >> STATS_SKETCH_SUB_BITS) + STATS_SKETCH_MIN_EXP;
+    int sub = (b - 1) & (STATS_SKETCH_SUB - 1);
+    return ldexp(1.0 + (sub + 0.5) / STATS_SKETCH_SUB, exp);
+}
+
+double match_stats_quantile(const TeamStats *ts, double q) {
+    if (ts->sketch_count == 0)
+        return 0.0;
+    uint64_t rank = (uint64_t)(q * (double)(ts->sketch_count - 1));
+    uint64_t seen = 0;
+    for (int b = 0; b < STATS_SKETCH_BUCKETS; b++) {
+        seen += ts->sketch[b];
+        if (seen > rank)
+            return sketch_value(b);
+    }
+    return sketch_value(STATS_SKETCH_BUCKETS - 1);
+}
+
+// ----------------------------------------------------------
+// Writer side (referee only)
+// ----------------------------------------------------------
+void match_stats_tick(MatchStats *ms, const Match *m, float game_seconds) {
+    const Roster *r = &m->roster;
+    int n = ms->players_per_team;
+
+    __atomic_store_n(&ms->seq, ms->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (int t = 0; t < ms->num_teams && t < NUM_TEAMS; t++) {
+        const float *effort = r->effort + t * r->stride;
+        const uint8_t *state = r->state + t * r->stride;
+        PlayerStats *ps = ms->player + t * n;
+        TeamStats *ts = &ms->team[t];
+
+        // Team counters in locals: they could alias the player rows
+        uint64_t falls = 0, recovering = 0, pulled = 0;
+        uint64_t *sketch = ts->sketch;
+        for (int p = 0; p < n; p++) {
+            uint8_t st = state[p];
+            PlayerStats *pp = &ps[p];
+            if (st & PLAYER_RECOVERING) {
+                uint32_t fell = !(pp->last_state & PLAYER_RECOVERING);
+                pp->recovering_ticks++;
+                pp->falls += fell;
+                falls += fell;
+                recovering++;
+            } else if (PLAYER_PULLING(st)) {
+                double x = effort[p];
+                double d = x - pp->mean;
+                uint64_t k = pp->samples + 1;
+                double mean = pp->mean + d / (double)k;
+                pp->samples = k;
+                pp->mean = mean;
+                pp->m2 += d * (x - mean);
+                sketch[sketch_bucket(effort[p])]++;
+                pulled++;
+            }
+            pp->last_state = st;
+        }
+        ts->falls += falls;
+        ts->recovering_ticks += recovering;
+        ts->sketch_count += pulled;
+
+        double x = m->team_efforts[t];
+        double d = x - ts->total_mean;
+        ts->ticks++;
+        ts->total_mean += d / (double)ts->ticks;
+        ts->total_m2 += d * (x - ts->total_mean);
+    }
+    ms->ticks++;
+    ms->game_seconds = game_seconds;
+
+    __atomic_store_n(&ms->seq, ms->seq + 1, __ATOMIC_RELEASE);
+}
+
+// ----------------------------------------------------------
+// Reader side
+// ----------------------------------------------------------
+int match_stats_read(const MatchStats *ms, MatchStats *out, int rows_per_team) {
+    int n = ms->players_per_team;
+    int rows = (rows_per_team < 0 || rows_per_team > n) ? n : rows_per_team;
+    for (int retries = 0; ; retries++) {
+        uint32_t before = __atomic_load_n(&ms->seq, __ATOMIC_ACQUIRE);
+        if (before & 1)
+            continue;
+
+        memcpy(out, ms, sizeof(MatchStats));
+        for (int t = 0; t < ms->num_teams; t++) {
+            memcpy(out->player + t * n, ms->player + t * n, rows * sizeof(PlayerStats));
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&ms->seq, __ATOMIC_RELAXED) == before)
+            return retries;
+    }
+}
+
+double match_stats_sd(uint64_t n, double m2) {
+    return n > 1 ? sqrt(m2 / (double)(n - 1)) : 0.0;
+}
+
+// Merge the players' Welford pairs (Chan et al.)
+void match_stats_team_effort(const MatchStats *ms, int team, double *mean, double *sd) {
+    const PlayerStats *ps = ms->player + team * ms->players_per_team;
+    uint64_t total = 0;
+    double sum = 0.0;
+    for (int p = 0; p < ms->players_per_team; p++) {
+        total += ps[p].samples;
+        sum += ps[p].mean * (double)ps[p].samples;
+    }
+    double mu = total > 0 ? sum / (double)total : 0.0;
+    double m2 = 0.0;
+    for (int p = 0; p < ms->players_per_team; p++) {
+        double d = ps[p].mean - mu;
+        m2 += ps[p].m2 + d * d * (double)ps[p].samples;
+    }
+    *mean = mu;
+    *sd = match_stats_sd(total, m2);
+}
+
+// ----------------------------------------------------------
+// Export
+// ----------------------------------------------------------
+static void export_csv(const MatchStats *ms, FILE *f) {
+    int n = ms->players_per_team;
+    fprintf(f, "team,player,pulling_ticks,effort_mean,effort_sd,falls,recovering_seconds,"
+               "effort_p50,effort_p90,effort_p99,total_effort_mean,total_effort_sd\n");
+    for (int t = 0; t < ms->num_teams; t++) {
+        const TeamStats *ts = &ms->team[t];
+        double mean, sd;
+        match_stats_team_effort(ms, t, &mean, &sd);
+        fprintf(f, "%d,all,%llu,%.4f,%.4f,%llu,%.1f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                t + 1, (unsigned long long)ts->sketch_count, mean, sd,
+                (unsigned long long)ts->falls, (double)ts->recovering_ticks / TICKS_PER_SECOND,
+                match_stats_quantile(ts, 0.5), match_stats_quantile(ts, 0.9),
+                match_stats_quantile(ts, 0.99),
+                ts->total_mean, match_stats_sd(ts->ticks, ts->total_m2));
+        for (int p = 0; p < n; p++) {
+            const PlayerStats *ps = &ms->player[t * n + p];
+            fprintf(f, "%d,%d,%llu,%.4f,%.4f,%u,%.1f,,,,,\n",
+                    t + 1, p + 1, (unsigned long long)ps->samples, ps->mean,
+                    match_stats_sd(ps->samples, ps->m2), ps->falls,
+                    (double)ps->recovering_ticks / TICKS_PER_SECOND);
+        }
+    }
+}
+
+static void export_json(const MatchStats *ms, FILE *f) {
+    int n = ms->players_per_team;
+    fprintf(f, "{\"ticks\":%llu,\"game_seconds\":%.1f,\"teams\":[",
+            (unsigned long long)ms->ticks, ms->game_seconds);
+    for (int t = 0; t < ms->num_teams; t++) {
+        const TeamStats *ts = &ms->team[t];
+        double mean, sd;
+        match_stats_team_effort(ms, t, &mean, &sd);
+        fprintf(f, "%s\n{\"team\":%d,\"pulling_ticks\":%llu,\"effort_mean\":%.4f,\"effort_sd\":%.4f,"
+                   "\"effort_quantiles\":{\"p50\":%.4f,\"p90\":%.4f,\"p99\":%.4f},"
+                   "\"total_effort_mean\":%.4f,\"total_effort_sd\":%.4f,"
+                   "\"falls\":%llu,\"recovering_seconds\":%.1f,\"players\":[",
+                t ? "," : "", t + 1, (unsigned long long)ts->sketch_count, mean, sd,
+                match_stats_quantile(ts, 0.5), match_stats_quantile(ts, 0.9),
+                match_stats_quantile(ts, 0.99),
+                ts->total_mean, match_stats_sd(ts->ticks, ts->total_m2),
+                (unsigned long long)ts->falls, (double)ts->recovering_ticks / TICKS_PER_SECOND);
+        for (int p = 0; p < n; p++) {
+            const PlayerStats *ps = &ms->player[t * n + p];
+            fprintf(f, "%s\n {\"player\":%d,\"pulling_ticks\":%llu,\"effort_mean\":%.4f,"
+                       "\"effort_sd\":%.4f,\"falls\":%u,\"recovering_seconds\":%.1f}",
+                    p ? "," : "", p + 1, (unsigned long long)ps->samples, ps->mean,
+                    match_stats_sd(ps->samples, ps->m2), ps->falls,
+                    (double)ps->recovering_ticks / TICKS_PER_SECOND);
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n]}\n");
+}
+
+int match_stats_export(const MatchStats *ms, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror("Failed to open stats file");
+        return -1;
+    }
+    size_t len = strlen(path);
+    if (len >= 5 && strcmp(path + len - 5, ".json") == 0)
+        export_json(ms, f);
+    else
+        export_csv(ms, f);
+    if (fclose(f) != 0) {
+        perror("Failed to write stats file");
+        return -1;
+    }
+    return 0;
+}
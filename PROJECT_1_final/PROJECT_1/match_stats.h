@@ -0,0 +1,90 @@
+#ifndef MATCH_STATS_H
+#define MATCH_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"    // NUM_TEAMS, Match
+
+// ----------------------------------------------------------
+// Streaming match statistics
+//  Folded in by the referee once per tick played, in one pass
+//  over the roster; nothing is kept per tick, so the memory
+//  is fixed by the team sizes whatever the match length.
+//
+//  Per player: mean and variance of its effort over the ticks
+//  it pulled (Welford), the ticks it spent recovering and how
+//  often it fell. Per team: the same for the team's effort
+//  total, and a quantile sketch of its players' efforts.
+//
+//  The sketch is a log-linear histogram: STATS_SKETCH_SUB
+//  buckets per power of two from 2^STATS_SKETCH_MIN_EXP up,
+//  picked straight from the float's exponent and top mantissa
+//  bits, so a quantile comes back within 1/(2 * SUB) of the
+//  true value (1.6%). Smaller efforts count as 0.
+//
+//  The block sits in the SharedState mapping after the
+//  snapshots (shared_state_stats()); readers copy it with
+//  match_stats_read(), a seqlock like the snapshots'.
+// ----------------------------------------------------------
+
+#define STATS_SKETCH_SUB_BITS 5
+#define STATS_SKETCH_SUB      (1 << STATS_SKETCH_SUB_BITS)
+#define STATS_SKETCH_MIN_EXP  (-6)          // 1/64
+#define STATS_SKETCH_OCTAVES  32            // Up to 2^26
+#define STATS_SKETCH_BUCKETS  (1 + STATS_SKETCH_OCTAVES * STATS_SKETCH_SUB)
+
+typedef struct {
+    uint64_t samples;                // Ticks the player pulled
+    double   mean;                   // Effort over those ticks
+    double   m2;                     // Sum of squared deviations (Welford)
+    uint32_t falls;
+    uint32_t recovering_ticks;
+    uint8_t  last_state;             // PLAYER_* bits at the last tick folded in
+} PlayerStats;
+
+typedef struct {
+    uint64_t ticks;                  // Team effort total, one sample per tick
+    double   total_mean;
+    double   total_m2;
+    uint64_t falls;
+    uint64_t recovering_ticks;       // Summed over the players
+    uint64_t sketch_count;           // Player efforts in the sketch
+    uint64_t sketch[STATS_SKETCH_BUCKETS];
+} TeamStats;
+
+typedef struct {
+    uint32_t seq;                    // Odd while the referee is folding a tick in
+    int      num_teams;
+    int      players_per_team;
+    float    game_seconds;           // Game clock of the last tick folded in
+    uint64_t ticks;                  // Ticks folded in
+    TeamStats team[NUM_TEAMS];
+    PlayerStats player[];            // Team by team, players_per_team each
+} MatchStats;
+
+// Bytes for a block of the given shape
+size_t match_stats_size(int num_teams, int players_per_team);
+
+// Set up a zeroed block of match_stats_size() bytes
+void match_stats_init(MatchStats *ms, int num_teams, int players_per_team);
+
+// Referee: fold in the tick just played
+void match_stats_tick(MatchStats *ms, const Match *m, float game_seconds);
+
+// Reader: copy the team totals and the first rows_per_team players of
+// every team into out (a block of the same shape). Returns the retries.
+int match_stats_read(const MatchStats *ms, MatchStats *out, int rows_per_team);
+
+// Standard deviation from a Welford pair
+double match_stats_sd(uint64_t n, double m2);
+
+// The team's player efforts: merged mean and deviation over all its
+// players, and the q-quantile (0..1) from the sketch
+void   match_stats_team_effort(const MatchStats *ms, int team, double *mean, double *sd);
+double match_stats_quantile(const TeamStats *ts, double q);
+
+// Write the block as JSON if path ends in .json, CSV otherwise.
+// Returns 0 on success, -1 on error.
+int match_stats_export(const MatchStats *ms, const char *path);
+
+#endif /* MATCH_STATS_H */
@@ -6,6 +6,9 @@
 #include <time.h>
 
 #include "opengl.h"
+#include "renderer.h"   // Retained geometry, instanced figures, glyph atlas
+#include "tick_trace.h" // Recorded matches for replay
+#include "spectator.h"  // Live matches followed over the spectator feed
 
 // ---------------------------------------------------------------------
 // Global drawing parameters
@@ -19,16 +22,53 @@ static float team_colors[NUM_TEAMS][3] = {
     {0.0f, 0.3f, 1.0f}, // Team 1: Blue
     {0.0f, 0.8f, 0.0f}  // Team 2: Green
 };
+static const float black[3]      = {0.0f, 0.0f, 0.0f};
+static const float dark_gray[3]  = {0.2f, 0.2f, 0.2f};
+static const float red[3]        = {1.0f, 0.0f, 0.0f};
+static const float rope_color[3] = {0.6f, 0.3f, 0.1f};
+
+// Spacing between neighbouring players and the widest a team may get
+#define PLAYER_SPACING 60.0f
+#define TEAM_MAX_WIDTH_FRACTION 0.22f
+#define MAX_LABELED_PLAYERS 8   // Larger teams are drawn without per-player labels
 
 // We'll track when we first detect the match is over
 static time_t winner_display_start = 0;
 
+// Local copy of the last consistent frame published by the referee
+static StateSnapshot *frame = NULL;
+
+// Frame pacing: what the window shows, and the viewer's own cost
+static uint32_t drawn_change_seq = 0;
+static int drawn_second = -1;
+static int frames_drawn = 0;
+static float viewer_cpu_percent = 0.0f;   // CPU time / wall time over the last second
+static int viewer_fps_drawn = 0;          // Frames actually drawn over the last second
+static double stats_wall = 0.0, stats_cpu = 0.0;
+static int interactive = 0;               // Drawing to a GLUT window
+
+// Replay of a tick trace instead of the live shared state
+#define REPLAY_SEEK_SECONDS 5
+static int replaying = 0;
+static TraceReader replay;
+static double replay_tick = 0.0;          // Play position in (fractional) ticks
+static double replay_speed = 1.0;
+static int replay_paused = 0;
+static double replay_wall = 0.0;          // Wall clock of the last advance
+static uint64_t replay_shown = TRACE_NO_RECORD;
+static char replay_status[96];
+
+// A match followed over the spectator feed instead of a forked viewer
+static int spectating = 0;
+static SpectatorClient spectator;
+
 // Forward-declare helper functions
 static void display_callback(void);
 static void reshape_callback(int w, int h);
-static void draw_text(float x, float y, const char *text);
-static void draw_player(float x, float y, float scale);
-static void draw_player_fallen(float x, float y, float scale, int team);
+static void draw_team(const Roster *r, int team, float rope_offset, float base_y);
+static void replay_advance(StateSnapshot *snap);
+static void replay_keyboard(unsigned char key, int x, int y);
+static void replay_special(int key, int x, int y);
 
 // ---------------------------------------------------------------------
 // init_visualization
@@ -39,9 +79,23 @@ void init_visualization(int argc, char **argv) {
     glutInitWindowSize(window_width, window_height);
     glutCreateWindow("Tug of War Visualization - Real-Time");
 
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    glMatrixMode(GL_PROJECTION);
-    gluOrtho2D(0, (GLdouble)window_width, 0, (GLdouble)window_height);
+    if (renderer_init() != 0) {
+        fprintf(stderr, "Failed to set up the renderer\n");
+        exit(1);
+    }
+
+    frame = shared_state_alloc_snapshot(shared_state);
+    if (frame == NULL) {
+        fprintf(stderr, "Failed to allocate the visualizer frame\n");
+        exit(1);
+    }
+    shared_state_read(shared_state, frame);
+}
+
+static double clock_seconds(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
 }
 
 // ---------------------------------------------------------------------
@@ -50,8 +104,11 @@ void init_visualization(int argc, char **argv) {
 void visualization_loop(int argc, char **argv) {
     glutDisplayFunc(display_callback);
     glutReshapeFunc(reshape_callback);
-    // Force continuous redraw to see real-time updates
-    glutIdleFunc(update_visualization);
+    // Poll the shared state at the target frame rate; redraw on change
+    interactive = 1;
+    stats_wall = clock_seconds(CLOCK_MONOTONIC);
+    stats_cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    glutTimerFunc(1000 / viewer_fps, update_visualization, 0);
 
     glutMainLoop();
 }
@@ -59,245 +116,421 @@ void visualization_loop(int argc, char **argv) {
 // ---------------------------------------------------------------------
 // update_visualization
 // ---------------------------------------------------------------------
-void update_visualization() {
-    glutPostRedisplay();
+void update_visualization(int value) {
+    glutTimerFunc(1000 / viewer_fps, update_visualization, value);
+
+    // Between referee ticks nothing changes: only redraw when the
+    // published state or the whole second in the header moved
+    if (replaying) {
+        replay_advance(frame);
+    } else if (spectating) {
+        // The feed closing before the end means the referee is gone
+        if (spectator_poll(&spectator, frame) < 0 && !frame->game_ended)
+            exit(0);
+    } else {
+        shared_state_read(shared_state, frame);
+    }
+    int redraw = frame->change_seq != drawn_change_seq ||
+                 (int)frame->game_seconds != drawn_second;
+
+    // Once a second, measure what the viewer itself costs
+    double wall = clock_seconds(CLOCK_MONOTONIC);
+    if (wall - stats_wall >= 1.0) {
+        double cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+        viewer_cpu_percent = (float)(100.0 * (cpu - stats_cpu) / (wall - stats_wall));
+        viewer_fps_drawn = (int)(frames_drawn / (wall - stats_wall) + 0.5);
+        frames_drawn = 0;
+        stats_wall = wall;
+        stats_cpu = cpu;
+        redraw = 1;
+    }
+
+    // The end-of-match screen stays up for 5 seconds (a replay stays open)
+    if (!replaying && winner_display_start != 0 && (time(NULL) - winner_display_start) > 5) {
+        exit(0);
+    }
+
+    if (redraw)
+        glutPostRedisplay();
 }
 
 // ---------------------------------------------------------------------
 // display_callback
 // ---------------------------------------------------------------------
 static void display_callback(void) {
-    glClear(GL_COLOR_BUFFER_BIT);
+    // Draw the frame update_visualization() last read
+    drawn_change_seq = frame->change_seq;
+    drawn_second = (int)frame->game_seconds;
+    frames_drawn++;
+    if (frame->game_ended == 1 && winner_display_start == 0) {
+        winner_display_start = time(NULL);
+    }
+
+    visualization_draw(frame);
+    glutSwapBuffers();
+}
+
+// ---------------------------------------------------------------------
+// visualization_draw
+//  Renders one snapshot into the current GL context, a GLUT window or
+//  the offscreen recorder's surface
+// ---------------------------------------------------------------------
+void visualization_draw(StateSnapshot *snap) {
+    renderer_begin_frame(window_width, window_height);
 
     // --- End-of-match drawing (unchanged) ---
-    if (shared_state->game_ended == 1) {
-        if (winner_display_start == 0) {
-            winner_display_start = time(NULL);
-        }
-        int winning_team = shared_state->final_winner;
+    if (snap->game_ended == 1) {
+        int winning_team = snap->final_winner;
         char winner_str[80];
         sprintf(winner_str, "TEAM %d IS THE WINNER!", winning_team + 1);
-        int t1_wins = shared_state->team_round_wins[0];
-        int t2_wins = shared_state->team_round_wins[1];
+        int t1_wins = snap->team_round_wins[0];
+        int t2_wins = snap->team_round_wins[1];
         char score_str[100];
         sprintf(score_str, "Final Score: Team1=%d  |  Team2=%d", t1_wins, t2_wins);
-        glColor3f(1.0f, 0.0f, 0.0f);
-        draw_text(window_width * 0.4f, window_height * 0.55f, winner_str);
-        glColor3f(0.0f, 0.0f, 0.0f);
-        draw_text(window_width * 0.4f, window_height * 0.55f - 40, score_str);
-        if ((time(NULL) - winner_display_start) > 5) {
-            exit(0);
-        }
-        glutSwapBuffers();
+        renderer_text(window_width * 0.4f, window_height * 0.55f, winner_str, red);
+        renderer_text(window_width * 0.4f, window_height * 0.55f - 40, score_str, black);
+        renderer_end_frame();
         return;
     }
     
     // --- Normal Rendering ---
-    float ropePos = shared_state->rope_position;
-    int roundNum  = shared_state->round_number;
-    int t1_wins   = shared_state->team_round_wins[0];
-    int t2_wins   = shared_state->team_round_wins[1];
+    float ropePos = snap->rope_position;
+    int roundNum  = snap->round_number;
+    int t1_wins   = snap->team_round_wins[0];
+    int t2_wins   = snap->team_round_wins[1];
 
     float max_pixels = 0.25f * window_width;
     float rope_offset = -((ropePos / config_rope_threshold) * max_pixels);
     float current_rope_center = (rope_center_x * window_width) - rope_offset;
     float rope_y = 0.5f * window_height;
 
-    // Draw the rope and center-line (unchanged)
-    glColor3f(0.6f, 0.3f, 0.1f);
-    glLineWidth(5.0f);
-    glBegin(GL_LINES);
-        glVertex2f(current_rope_center - 100, rope_y);
-        glVertex2f(current_rope_center + 100, rope_y);
-    glEnd();
-    glColor3f(1.0f, 0.0f, 0.0f);
-    glBegin(GL_LINES);
-        glVertex2f(0.5f * window_width, rope_y - 20);
-        glVertex2f(0.5f * window_width, rope_y + 20);
-    glEnd();
+    // Draw the rope and center-line
+    renderer_line(current_rope_center - 100, rope_y, current_rope_center + 100, rope_y, rope_color);
+    renderer_line(0.5f * window_width, rope_y - 20, 0.5f * window_width, rope_y + 20, red);
 
     float base_y = rope_y - 50.0f;
 
-    for (int p = 0; p < PLAYERS_PER_TEAM; p++) {
-        Player *pl = &shared_state->players[0][p];
-        float posIndex = (float)(pl->position - 1); // reversed compared to before
-        float offset = (1.5f - posIndex) * 60.0f;
-        float px = (team1_base_x * window_width) - rope_offset + offset;
-        
-        // Determine scale based on energy
-        float scale = 0.6f + (pl->energy / 100.0f) * 0.4f;
-        if (pl->recovering) {
-            draw_player_fallen(px, base_y, scale, 0);
-        } else {
-            glColor3fv(team_colors[0]);
-            draw_player(px, base_y, scale);
-        }
-        
-        // Place labels to the right of the player.
-        // Now the label positions follow the new order.
-        float label_x = px + 15;
-        float label_y = base_y + 70;
-        char energy_label[12];
-        snprintf(energy_label, sizeof(energy_label), "E %.1f", pl->energy);
-        char effort_label[12];
-        snprintf(effort_label, sizeof(effort_label), "F%.1f", pl->effort);
-        glColor3f(0.0f, 0.0f, 0.0f);
-        draw_text(label_x, label_y, energy_label);
-        glColor3f(0.2f, 0.2f, 0.2f);
-        draw_text(label_x, label_y - 20, effort_label);
-    }
-    
-    // --- Draw Team 2 (right side) ---
-    for (int p = 0; p < PLAYERS_PER_TEAM; p++) {
-        Player *pl = &shared_state->players[1][p];
-        // For team 2, positions are arranged as 1 2 3 4.
-        float posIndex = (float)(pl->position - 1);
-        float offset = (posIndex - 1.5f) * 60.0f;
-        float px = (team2_base_x * window_width) - rope_offset + offset;
-        
-        float scale = 0.6f + (pl->energy / 100.0f) * 0.4f;
-        if (pl->recovering) {
-            draw_player_fallen(px, base_y, scale, 1);
-        } else {
-            glColor3fv(team_colors[1]);
-            draw_player(px, base_y, scale);
-        }
-        
-        // For Team 2, place labels to the left of the player.
-        float label_x = px - 65;
-        float label_y = base_y + 70;
-        char energy_label[12];
-        snprintf(energy_label, sizeof(energy_label), "E %.1f", pl->energy);
-        char effort_label[12];
-        snprintf(effort_label, sizeof(effort_label), "F%.1f", pl->effort);
-        glColor3f(0.0f, 0.0f, 0.0f);
-        draw_text(label_x, label_y, energy_label);
-        glColor3f(0.2f, 0.2f, 0.2f);
-        draw_text(label_x, label_y - 20, effort_label);
-    }
+    // Bind our view of the player arrays stored in the snapshot
+    Roster roster;
+    snapshot_roster(shared_state, snap, &roster);
+    draw_team(&roster, 0, rope_offset, base_y);
+    draw_team(&roster, 1, rope_offset, base_y);
     
     // --- Draw Total Effort Labels Under Each Team ---
     char team1_effort_label[50];
     char team2_effort_label[50];
-    snprintf(team1_effort_label, sizeof(team1_effort_label), "Team 1 Total Effort: %.1f", shared_state->team_efforts[0]);
-    snprintf(team2_effort_label, sizeof(team2_effort_label), "Team 2 Total Effort: %.1f", shared_state->team_efforts[1]);
+    snprintf(team1_effort_label, sizeof(team1_effort_label), "Team 1 Total Effort: %.1f", snap->team_efforts[0]);
+    snprintf(team2_effort_label, sizeof(team2_effort_label), "Team 2 Total Effort: %.1f", snap->team_efforts[1]);
     // Place these labels below the players; adjust Y as needed.
-    draw_text((team1_base_x * window_width) - 50, base_y - 40, team1_effort_label);
-    draw_text((team2_base_x * window_width) - 50, base_y - 40, team2_effort_label);
+    renderer_text((team1_base_x * window_width) - 50, base_y - 40, team1_effort_label, black);
+    renderer_text((team2_base_x * window_width) - 50, base_y - 40, team2_effort_label, black);
     
     // --- Draw header information ---
-    time_t now = time(NULL);
-    int elapsed = (int)(now - game_start_time);
+    int elapsed = (int)snap->game_seconds;
     char header[128];
     snprintf(header, sizeof(header),
-             "Time: %d sec | Round: %d | Team1 Wins: %d | Team2 Wins: %d | Rope: %.1f/%.1f",
-             elapsed, roundNum, t1_wins, t2_wins, ropePos, config_rope_threshold);
-    glColor3f(0.0f, 0.0f, 0.0f);
-    draw_text(20, window_height - 30, header);
+             "Time: %d sec | Round: %d | Rope: %.1f/%.1f",
+             elapsed, roundNum, ropePos, config_rope_threshold);
+    char header2[128];
+    int len = snprintf(header2, sizeof(header2), "Team1 Wins: %d | Team2 Wins: %d", t1_wins, t2_wins);
+    if (interactive)
+        snprintf(header2 + len, sizeof(header2) - len, " | Viewer: %.1f%% CPU, %d fps",
+                 viewer_cpu_percent, viewer_fps_drawn);
+    renderer_text(20, window_height - 30, header, black);
+    renderer_text(20, window_height - 52, header2, black);
+    // Live win probability once the estimator has published one
+    WinEstimate odds;
+    shared_state_read_estimate(shared_state, &odds);
+    if (!replaying && odds.rollouts > 0) {
+        char odds_str[160];
+        snprintf(odds_str, sizeof(odds_str),
+                 "Team 1 wins: %.0f%% (%.0f-%.0f%%) | Team 2: %.0f%% | Tie: %.0f%% | %u rollouts, %.0fk/s per core",
+                 100.0f * odds.p_win[0], 100.0f * odds.ci_low, 100.0f * odds.ci_high,
+                 100.0f * odds.p_win[1], 100.0f * odds.p_tie, odds.rollouts,
+                 odds.rollouts_per_core_sec / 1000.0f);
+        renderer_text(20, window_height - 74, odds_str, dark_gray);
+    }
+    if (replaying) {
+        renderer_text(20, window_height - 74, replay_status, dark_gray);
+        renderer_text(20, 20, "Space: pause  +/-: speed  Arrows: 5 s  [ ] 1-9: round", dark_gray);
+    }
 
-    glutSwapBuffers();
+    renderer_end_frame();
+}
+
+// ---------------------------------------------------------------------
+// draw_team
+//  Draws one team's players in line order. Team 1 stands on the left
+//  with position 1 furthest from the rope, Team 2 mirrors it on the right.
+// ---------------------------------------------------------------------
+static void draw_team(const Roster *r, int team, float rope_offset, float base_y) {
+    int n = r->players_per_team;
+    float spacing = PLAYER_SPACING;
+    if (n > 1 && spacing * (n - 1) > TEAM_MAX_WIDTH_FRACTION * window_width)
+        spacing = TEAM_MAX_WIDTH_FRACTION * window_width / (float)(n - 1);
+    float center = (n - 1) * 0.5f;
+    float base_x = (team == 0 ? team1_base_x : team2_base_x) * window_width;
+
+    // With less than a pixel between neighbours the figures pile up:
+    // keep only the one drawn last in each pixel column
+    static int *column_owner = NULL;
+    static int column_capacity = 0;
+    int columns = (spacing < 1.0f) ? (int)(spacing * (n - 1)) + 1 : 0;
+    if (columns > column_capacity) {
+        int *owners = realloc(column_owner, columns * sizeof(int));
+        if (owners) {
+            column_owner = owners;
+            column_capacity = columns;
+        } else {
+            columns = 0;   // Draw everybody
+        }
+    }
+    if (columns > 0) {
+        for (int c = 0; c < columns; c++) {
+            column_owner[c] = -1;
+        }
+        for (int p = 0; p < n; p++) {
+            int c = (int)((r->position[ROSTER_INDEX(r, team, p)] - 1) * spacing);
+            if (c >= 0 && c < columns)
+                column_owner[c] = p;
+        }
+    }
+
+    for (int k = 0; k < (columns > 0 ? columns : n); k++) {
+        int p = (columns > 0) ? column_owner[k] : k;
+        if (p < 0)
+            continue;
+        int i = ROSTER_INDEX(r, team, p);
+        float posIndex = (float)(r->position[i] - 1);
+        float offset = (team == 0) ? (center - posIndex) * spacing : (posIndex - center) * spacing;
+        float px = base_x - rope_offset + offset;
+
+        // Determine scale based on energy
+        float scale = 0.6f + (r->energy[i] / 100.0f) * 0.4f;
+        renderer_figure(px, base_y, scale, team_colors[team], r->state[i] & PLAYER_RECOVERING);
+
+        if (n > MAX_LABELED_PLAYERS)
+            continue;
+
+        // Team 1 labels go to the right of the player, Team 2 to the left
+        float label_x = (team == 0) ? px + 15 : px - 65;
+        float label_y = base_y + 70;
+        char energy_label[12];
+        snprintf(energy_label, sizeof(energy_label), "E %.1f", r->energy[i]);
+        char effort_label[12];
+        snprintf(effort_label, sizeof(effort_label), "F%.1f", r->effort[i]);
+        renderer_text(label_x, label_y, energy_label, black);
+        renderer_text(label_x, label_y - 20, effort_label, dark_gray);
+    }
 }
 
 // ---------------------------------------------------------------------
 // reshape_callback
 // ---------------------------------------------------------------------
 static void reshape_callback(int w, int h) {
+    // The renderer sets the viewport and projection every frame
     window_width = w;
     window_height = h;
-    glViewport(0, 0, w, h);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(0, w, 0, h);
-    glMatrixMode(GL_MODELVIEW);
 }
 
 // ---------------------------------------------------------------------
-// draw_text
+// replay_visualization
+//  Plays a tick trace back in the window: no referee, no players. The
+//  trace is mapped, and every record holds a whole frame, so seeking
+//  through the keyframe index costs the same anywhere in the match.
 // ---------------------------------------------------------------------
-static void draw_text(float x, float y, const char *text) {
-    glRasterPos2f(x, y);
-    while (*text) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *text);
-        text++;
+int replay_visualization(int argc, char **argv, const char *trace_path, double speed) {
+    if (trace_reader_open(&replay, trace_path) != 0)
+        return -1;
+    const TraceFileHeader *h = replay.header;
+    if (h->num_teams != NUM_TEAMS || replay.count == 0) {
+        fprintf(stderr, "%s: no %d-team match recorded\n", trace_path, NUM_TEAMS);
+        trace_reader_close(&replay);
+        return -1;
     }
-}
 
+    // The snapshot layout of a live match of the same shape
+    config_rope_threshold = (float)h->rope_threshold;
+    shared_state = shared_state_create(h->num_teams, h->players_per_team);
+    if (shared_state == NULL)
+        return -1;
+
+    replaying = 1;
+    replay_speed = speed;
+    replay_tick = (double)trace_reader_record(&replay, replay.first)->tick;
+    replay_wall = clock_seconds(CLOCK_MONOTONIC);
+
+    init_visualization(argc, argv);
+    glutSetWindowTitle("Tug of War Visualization - Replay");
+    glutKeyboardFunc(replay_keyboard);
+    glutSpecialFunc(replay_special);
+    replay_advance(frame);
+    visualization_loop(argc, argv);
+    return 0;
+}
 
 // ---------------------------------------------------------------------
-// draw_player
-//  Draws a standing stick figure
+// spectate_visualization
+//  Follows a match over its spectator feed, from any process: the
+//  frame is the referee's state mapped read-only, kept current by the
+//  deltas of every publish.
 // ---------------------------------------------------------------------
-static void draw_player(float x, float y, float scale) {
-    float head_radius = 10.0f * scale;
-    float body_height = 40.0f * scale;
-    float limb_length = 20.0f * scale;
-
-    // Head (circle)
-    glBegin(GL_TRIANGLE_FAN);
-    for (int i = 0; i < 20; i++) {
-        float theta = 2.0f * 3.14159f * i / 20.0f;
-        glVertex2f(x + cosf(theta)*head_radius,
-                   y + body_height + sinf(theta)*head_radius);
+int spectate_visualization(int argc, char **argv, const char *socket_path) {
+    if (spectator_connect(&spectator, socket_path) != 0)
+        return -1;
+    if (spectator.ss->num_teams != NUM_TEAMS) {
+        fprintf(stderr, "%s: not a %d-team match\n", socket_path, NUM_TEAMS);
+        spectator_disconnect(&spectator);
+        return -1;
     }
-    glEnd();
-
-    // Body line
-    glBegin(GL_LINES);
-        glVertex2f(x, y + body_height);
-        glVertex2f(x, y);
-    glEnd();
-
-    // Arms
-    glBegin(GL_LINES);
-        glVertex2f(x, y + body_height*0.7f);
-        glVertex2f(x - limb_length, y + body_height*0.5f);
-        glVertex2f(x, y + body_height*0.7f);
-        glVertex2f(x + limb_length, y + body_height*0.5f);
-    glEnd();
-
-    // Legs
-    glBegin(GL_LINES);
-        glVertex2f(x, y);
-        glVertex2f(x - limb_length*0.8f, y - limb_length);
-        glVertex2f(x, y);
-        glVertex2f(x + limb_length*0.8f, y - limb_length);
-    glEnd();
+    shared_state = spectator.ss;
+    config_rope_threshold = spectator.rope_threshold;
+    spectating = 1;
+
+    init_visualization(argc, argv);
+    glutSetWindowTitle("Tug of War Visualization - Spectator");
+    visualization_loop(argc, argv);
+    return 0;
+}
+
+// Unpack record k into the snapshot the viewer draws
+static void replay_load(StateSnapshot *snap, uint64_t k) {
+    const TraceFileHeader *h = replay.header;
+    const TraceRecord *rec = trace_reader_record(&replay, k);
+    const char *base = (const char *)rec;
+
+    snap->change_seq = (uint32_t)(k + 1);
+    snap->rope_position = rec->rope_position;
+    snap->round_number = rec->round_number;
+    snap->game_ended = (rec->events & TRACE_EV_MATCH_END) && rec->match_winner >= 0;
+    snap->final_winner = snap->game_ended ? rec->match_winner : -1;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        snap->team_round_wins[t] = rec->team_round_wins[t];
+        snap->team_efforts[t] = rec->team_efforts[t];
+    }
+
+    const float   *energy   = (const float *)(base + h->energy_offset);
+    const float   *effort   = (const float *)(base + h->effort_offset);
+    const int32_t *position = (const int32_t *)(base + h->position_offset);
+    const uint8_t *state    = (const uint8_t *)(base + h->state_offset);
+    Roster r;
+    snapshot_roster(shared_state, snap, &r);
+    int n = r.players_per_team;
+    for (int t = 0; t < r.num_teams; t++) {
+        memcpy(r.energy + t * r.stride, energy + t * n, n * sizeof(float));
+        memcpy(r.effort + t * r.stride, effort + t * n, n * sizeof(float));
+        memcpy(r.position + t * r.stride, position + t * n, n * sizeof(int32_t));
+        for (int p = 0; p < n; p++) {
+            r.state[t * r.stride + p] = state[t * n + p] & (PLAYER_ACTIVE | PLAYER_RECOVERING);
+        }
+    }
+}
+
+static void replay_seek(uint64_t k) {
+    const TraceRecord *rec = trace_reader_record(&replay, k);
+    if (rec)
+        replay_tick = (double)rec->tick;
+}
+
+// Move the play position on by the wall time since the last call and show
+// the record it lands on
+static void replay_advance(StateSnapshot *snap) {
+    const TraceFileHeader *h = replay.header;
+    double wall = clock_seconds(CLOCK_MONOTONIC);
+    if (!replay_paused)
+        replay_tick += (wall - replay_wall) * replay_speed * h->ticks_per_second;
+    replay_wall = wall;
+
+    // A trace still being written keeps growing under us
+    trace_reader_refresh(&replay);
+    const TraceRecord *first = trace_reader_record(&replay, replay.first);
+    const TraceRecord *last = trace_reader_record(&replay, replay.count - 1);
+    if (replay_tick < first->tick)
+        replay_tick = (double)first->tick;
+    if (replay_tick >= last->tick) {
+        replay_tick = (double)last->tick;
+        if (__atomic_load_n(&h->closed, __ATOMIC_ACQUIRE))
+            replay_paused = 1;
+    }
+
+    uint64_t k = trace_reader_at_tick(&replay, (int64_t)replay_tick);
+    if (k != replay_shown) {
+        replay_load(snap, k);
+        replay_shown = k;
+    }
+
+    // The clock keeps running through countdowns, which have no records
+    const TraceRecord *rec = trace_reader_record(&replay, k);
+    snap->game_seconds = rec->game_seconds +
+                         (float)((replay_tick - rec->tick) / h->ticks_per_second);
+    snprintf(replay_status, sizeof(replay_status), "Replay: %s x%g | Tick %lld/%lld",
+             replay_paused ? "paused" : "playing", replay_speed,
+             (long long)replay_tick, (long long)last->tick);
 }
 
 // ---------------------------------------------------------------------
-// draw_player_fallen
-//  Draws a "fallen" player with a gray circle + red cross
+// Replay controls
 // ---------------------------------------------------------------------
-static void draw_player_fallen(float x, float y, float scale, int team) {
-    (void)team; // could vary color by team if desired
-
-    float head_radius = 10.0f * scale;
-    float body_height = 40.0f * scale;
-
-    // Gray head
-    glColor3f(0.5f, 0.5f, 0.5f);
-    glBegin(GL_TRIANGLE_FAN);
-    for (int i = 0; i < 20; i++) {
-        float theta = 2.0f * 3.14159f * ((float)i / 20.0f);
-        glVertex2f(x + cosf(theta)*head_radius,
-                   y + body_height + sinf(theta)*head_radius);
+static void replay_keyboard(unsigned char key, int x, int y) {
+    (void)x;
+    (void)y;
+    int round = frame->round_number;
+
+    switch (key) {
+    case ' ':
+        // Play again from the start once the end was reached
+        if (replay_paused && replay_shown + 1 >= replay.count)
+            replay_seek(replay.first);
+        replay_paused = !replay_paused;
+        break;
+    case '+':
+    case '=':
+        replay_speed = replay_speed * 2.0 > REPLAY_MAX_SPEED ? REPLAY_MAX_SPEED : replay_speed * 2.0;
+        break;
+    case '-':
+        replay_speed = replay_speed * 0.5 < REPLAY_MIN_SPEED ? REPLAY_MIN_SPEED : replay_speed * 0.5;
+        break;
+    case '[':
+        if (trace_reader_round_start(&replay, round - 1) != TRACE_NO_RECORD)
+            replay_seek(trace_reader_round_start(&replay, round - 1));
+        break;
+    case ']':
+        if (trace_reader_round_start(&replay, round + 1) != TRACE_NO_RECORD)
+            replay_seek(trace_reader_round_start(&replay, round + 1));
+        break;
+    case 'q':
+    case 27:    // Escape
+        exit(0);
+    default:
+        if (key >= '1' && key <= '9' &&
+            trace_reader_round_start(&replay, key - '0') != TRACE_NO_RECORD)
+            replay_seek(trace_reader_round_start(&replay, key - '0'));
+        break;
     }
-    glEnd();
-
-    // Red cross on head
-    glColor3f(1.0f, 0.0f, 0.0f);
-    glBegin(GL_LINES);
-        glVertex2f(x - head_radius, y + body_height + head_radius);
-        glVertex2f(x + head_radius, y + body_height - head_radius);
-
-        glVertex2f(x - head_radius, y + body_height - head_radius);
-        glVertex2f(x + head_radius, y + body_height + head_radius);
-    glEnd();
-
-    // Short horizontal line for the body (lying down)
-    glColor3f(0.5f, 0.5f, 0.5f);
-    glBegin(GL_LINES);
-        glVertex2f(x - 10.0f * scale, y + body_height * 0.5f);
-        glVertex2f(x + 10.0f * scale, y + body_height * 0.5f);
-    glEnd();
+    replay_advance(frame);
+    glutPostRedisplay();
+}
+
+static void replay_special(int key, int x, int y) {
+    (void)x;
+    (void)y;
+    double step = (double)REPLAY_SEEK_SECONDS * replay.header->ticks_per_second;
+
+    // replay_advance() finds the record through the keyframe index
+    switch (key) {
+    case GLUT_KEY_LEFT:
+        replay_tick -= step;
+        break;
+    case GLUT_KEY_RIGHT:
+        replay_tick += step;
+        break;
+    case GLUT_KEY_HOME:
+        replay_seek(replay.first);
+        break;
+    case GLUT_KEY_END:
+        replay_seek(replay.count - 1);
+        break;
+    }
+    replay_advance(frame);
+    glutPostRedisplay();
 }
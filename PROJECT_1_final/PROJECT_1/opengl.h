@@ -3,42 +3,10 @@
 
 #include <GL/glut.h>   // For OpenGL/GLUT calls
 #include <time.h>      // For time_t
+#include "shared_state.h" // SharedState and its player roster
 
-// Forward-declare the structures and external variables
-// so openGL.c can see them.
-
-// Number of teams / players (must match main.c)
-#define NUM_TEAMS 2
-#define PLAYERS_PER_TEAM 4
-
-// ----------------------------------------------------------
-// Player structure matches what you have in main.c
-// (We replicate it here for the sake of the visualization code.)
-// ----------------------------------------------------------
-typedef struct {
-    float energy;
-    float effort;
-    float decay_rate;
-    int   position;
-    int   active;
-    int   recovering;
-    time_t recover_time;
-    pid_t pid;
-} Player;
-
-// ----------------------------------------------------------
-// The SharedState structure from main.c
-// (We only replicate the fields the child needs to read.)
-// ----------------------------------------------------------
-typedef struct {
-    float rope_position;             // Real-time rope displacement
-    int   team_round_wins[NUM_TEAMS];
-    Player players[NUM_TEAMS][PLAYERS_PER_TEAM];
-    int   round_number;              // Current round
-    int   game_ended;                // 0 while running, 1 once the match is done
-    int   final_winner;              // -1 if no winner yet, else 0 or 1 for which team won
-    float team_efforts[NUM_TEAMS];   // Total effort per team
-} SharedState;
+// Forward-declare the external variables so openGL.c can see them.
+// The SharedState layout itself lives in shared_state.h.
 
 // ----------------------------------------------------------
 // External references (variables declared in main.c)
@@ -47,7 +15,7 @@ extern SharedState *shared_state;        // Shared memory
 extern int window_width;
 extern int window_height;
 extern float config_rope_threshold;      // For rope range
-extern time_t game_start_time;           // Start time for stats
+extern int viewer_fps;                   // Target frame rate of the viewer
 
 
 // ----------------------------------------------------------
@@ -55,6 +23,20 @@ extern time_t game_start_time;           // Start time for stats
 // ----------------------------------------------------------
 void init_visualization(int argc, char **argv);
 void visualization_loop(int argc, char **argv);
-void update_visualization();
+void update_visualization(int value);
+
+// Render a snapshot into the current GL context (window or offscreen)
+void visualization_draw(StateSnapshot *snap);
+
+// Play a recorded tick trace in the window instead of a live match
+// (--replay) at speed x REPLAY_MIN_SPEED..REPLAY_MAX_SPEED, which '+'
+// and '-' double and halve within the same bounds; returns only on error
+#define REPLAY_MIN_SPEED 0.25
+#define REPLAY_MAX_SPEED 64.0
+int replay_visualization(int argc, char **argv, const char *trace_path, double speed);
+
+// Follow a running match over its spectator feed (--spectate); returns
+// only on error
+int spectate_visualization(int argc, char **argv, const char *socket_path);
 
 #endif /* OPENGL_H */
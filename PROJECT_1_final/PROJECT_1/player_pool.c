@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>     // For sysconf
+
+#include "player_pool.h"
+
+static void post_reply(PlayerTask *task, int type, int arg) {
+    MailboxMsg msg = { type, arg };
+    mailbox_push(&task->outbox, msg);   // At most two replies, never full
+}
+
+// A player reacting to a result the referee announced
+static void player_handle(PlayerTask *task, const MatchResult *res) {
+    int won = (task->team == res->winning_team);
+    if (res->kind == RESULT_ROUND) {
+        if (won)
+            task->rounds_won++;
+        else
+            task->rounds_lost++;
+    } else if (res->kind == RESULT_MATCH) {
+        task->match_won = won ? 1 : -1;
+        post_reply(task, PLAYER_MSG_DONE, task->rounds_won + task->rounds_lost);
+    }
+}
+
+// --------------------------------------------------------------------
+// Worker thread: plays posted ticks for its chunks and hands results to
+// the tasks [first, last) whenever the bell rings
+// --------------------------------------------------------------------
+static void *player_worker(void *arg) {
+    PlayerWorker *w = arg;
+    PlayerPool *pool = w->pool;
+    uint32_t done = 0;             // Last tick generation played
+    uint32_t seen = 0;             // Last result generation handed out
+    uint64_t missed = 0;
+
+    for (int i = w->first; i < w->last; i++) {
+        post_reply(&pool->tasks[i], PLAYER_MSG_READY, 0);
+    }
+    pthread_mutex_lock(&pool->start_lock);
+    pool->started++;
+    pthread_cond_signal(&pool->started_cond);
+    pthread_mutex_unlock(&pool->start_lock);
+
+    for (;;) {
+        uint32_t bell = energy_reports_bell(pool->reports);
+        int stop = __atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE);
+
+        if (energy_reports_pending(pool->reports, &done)) {
+            energy_reports_produce(pool->reports, &pool->match->roster, pool->match->kernel,
+                                   w->index, done);
+        }
+        MatchResult res;
+        while (energy_reports_next_result(pool->reports, &seen, &res, &missed)) {
+            for (int i = w->first; i < w->last; i++) {
+                player_handle(&pool->tasks[i], &res);
+            }
+        }
+        if (stop)
+            break;
+        energy_reports_sleep(pool->reports, bell);
+    }
+    __atomic_add_fetch(&pool->missed, missed, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// --------------------------------------------------------------------
+// Referee side
+// --------------------------------------------------------------------
+int player_pool_default_workers(int max_workers) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int n = cpus > 0 ? (int)cpus : 1;
+    if (n > max_workers)
+        n = max_workers > 0 ? max_workers : 1;
+    return n;
+}
+
+int player_pool_start(PlayerPool *pool, Match *m, EnergyReports *reports) {
+    memset(pool, 0, sizeof(*pool));
+    pool->num_players = reports->num_teams * reports->players_per_team;
+    pool->players_per_team = reports->players_per_team;
+    pool->match = m;
+    pool->reports = reports;
+    int num_workers = reports->num_producers;
+    int players_per_team = pool->players_per_team;
+
+    void *tasks = NULL;
+    if (posix_memalign(&tasks, 64, (size_t)pool->num_players * sizeof(PlayerTask)) != 0)
+        return -1;
+    pool->tasks = tasks;
+    pool->workers = calloc(num_workers, sizeof(PlayerWorker));
+    if (!pool->workers) {
+        free(pool->tasks);
+        return -1;
+    }
+    pthread_mutex_init(&pool->start_lock, NULL);
+    pthread_cond_init(&pool->started_cond, NULL);
+    for (int i = 0; i < pool->num_players; i++) {
+        PlayerTask *task = &pool->tasks[i];
+        memset(task, 0, sizeof(*task));
+        mailbox_init(&task->outbox);
+        task->team = i / players_per_team;
+        task->player = i % players_per_team;
+    }
+
+    // A worker's tasks are the players of its report chunks: contiguous,
+    // so it walks them in memory order
+    for (int w = 0; w < num_workers; w++) {
+        PlayerWorker *worker = &pool->workers[w];
+        int first_chunk, last_chunk;
+        energy_reports_range(reports, w, &first_chunk, &last_chunk);
+        worker->pool = pool;
+        worker->index = w;
+        energy_reports_players(reports, first_chunk, last_chunk, &worker->first, &worker->last);
+        if (pthread_create(&worker->thread, NULL, player_worker, worker) != 0) {
+            perror("pthread_create");
+            pool->num_workers = w;
+            player_pool_stop(pool);
+            return -1;
+        }
+        pool->num_workers = w + 1;
+    }
+    return 0;
+}
+
+// Sleep until every worker has started, then collect the READY replies
+// its tasks posted before it counted itself in
+int player_pool_wait_ready(PlayerPool *pool) {
+    pthread_mutex_lock(&pool->start_lock);
+    while (pool->started < pool->num_workers)
+        pthread_cond_wait(&pool->started_cond, &pool->start_lock);
+    pthread_mutex_unlock(&pool->start_lock);
+
+    for (int i = 0; i < pool->num_players; i++) {
+        MailboxMsg msg;
+        if (mailbox_pop(&pool->tasks[i].outbox, &msg) && msg.type == PLAYER_MSG_READY)
+            pool->ready++;
+    }
+    return pool->ready == pool->num_players ? 0 : -1;
+}
+
+void player_pool_stop(PlayerPool *pool) {
+    __atomic_store_n(&pool->stop, 1, __ATOMIC_RELEASE);
+    energy_reports_ring(pool->reports);
+    for (int w = 0; w < pool->num_workers; w++) {
+        pthread_join(pool->workers[w].thread, NULL);
+    }
+
+    // Every player that heard the match result has said so
+    for (int i = 0; i < pool->num_players; i++) {
+        MailboxMsg msg;
+        while (mailbox_pop(&pool->tasks[i].outbox, &msg)) {
+            if (msg.type == PLAYER_MSG_DONE)
+                pool->done++;
+        }
+    }
+    printf("Player tasks: %d of %d heard the match result, %llu results missed\n",
+           pool->done, pool->num_players, (unsigned long long)pool->missed);
+
+    pthread_cond_destroy(&pool->started_cond);
+    pthread_mutex_destroy(&pool->start_lock);
+    free(pool->workers);
+    free(pool->tasks);
+    pool->workers = NULL;
+    pool->tasks = NULL;
+}
@@ -0,0 +1,85 @@
+#ifndef PLAYER_POOL_H
+#define PLAYER_POOL_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include "engine.h"
+#include "energy_reports.h"
+#include "mailbox.h"
+
+// ----------------------------------------------------------
+// Players as pooled tasks
+//  Instead of one forked process per player, every player is
+//  a small task owned by one of a few worker threads (one per
+//  online CPU). A player answers the referee through an SPSC
+//  mailbox of its own: the player's worker is the only
+//  producer, the referee the only consumer.
+//
+//  Each worker is also the energy producer for its players:
+//  its slice of tasks is a run of energy report chunks, played
+//  whenever the referee posts a tick (see energy_reports.h).
+//  Round and match results are read once per worker from the
+//  shared result ring and handed to each of its tasks.
+//
+//  Workers sleep on the energy reports bell, which the referee
+//  rings once per tick and once per result.
+// ----------------------------------------------------------
+
+// Player -> referee
+#define PLAYER_MSG_READY      16   // Task is running
+#define PLAYER_MSG_DONE       17   // Saw the match result; arg = round results seen
+
+typedef struct {
+    Mailbox outbox;                // Player -> referee
+    int team;
+    int player;
+    int rounds_won;                // What the player has been told so far
+    int rounds_lost;
+    int match_won;                 // 1 won, -1 lost, 0 while playing
+} __attribute__((aligned(64))) PlayerTask;
+
+typedef struct PlayerPool PlayerPool;
+
+typedef struct {
+    PlayerPool *pool;
+    pthread_t thread;
+    int index;                     // Energy report producer
+    int first, last;               // Tasks [first, last)
+} PlayerWorker;
+
+struct PlayerPool {
+    PlayerTask *tasks;             // num_players, team-major
+    int num_players;
+    int players_per_team;
+    PlayerWorker *workers;
+    int num_workers;
+
+    Match *match;                  // Roster the workers play ticks on
+    EnergyReports *reports;        // Bell, tick posts and report rings
+    int stop;
+
+    uint64_t missed;               // Results overwritten before a worker read them
+
+    // A worker has posted READY for all its tasks once it counts itself here
+    pthread_mutex_t start_lock;
+    pthread_cond_t  started_cond;
+    int started;                   // Workers started, under start_lock
+
+    int ready;                     // READY messages collected
+    int done;                      // DONE messages collected
+};
+
+// Workers to use for at most max_workers: one per online CPU
+int  player_pool_default_workers(int max_workers);
+
+// Create the tasks and start one worker per energy report producer
+int  player_pool_start(PlayerPool *pool, Match *m, EnergyReports *reports);
+
+// Wait for the workers to start and collect READY from every player;
+// returns 0 once all are running
+int  player_pool_wait_ready(PlayerPool *pool);
+
+// Stop the workers, collect the DONE replies and free the pool
+void player_pool_stop(PlayerPool *pool);
+
+#endif /* PLAYER_POOL_H */
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "profiler.h"
+#include "game_clock.h"     // monotonic_ns()
+
+#ifdef PROFILER
+
+static const char *phase_names[PROF_PHASE_COUNT] = {
+    [PROF_TICK]          = "tick",
+    [PROF_FALLS]         = "falls",
+    [PROF_RECOVERIES]    = "recoveries",
+    [PROF_ENERGY]        = "energy",
+    [PROF_ROPE]          = "rope",
+    [PROF_TRACE]         = "trace_record",
+    [PROF_MIRROR]        = "mirror",
+    [PROF_RECORDER_WAIT] = "recorder_wait",
+    [PROF_TICK_WAIT]     = "tick_wait",
+    [PROF_ROUND_CHECK]   = "round_check",
+    [PROF_ALIGN]         = "align_all_teams",
+    [PROF_COUNTDOWN]     = "countdown",
+    [PROF_NOTIFY_ROUND]  = "notify_round",
+    [PROF_NOTIFY_MATCH]  = "notify_match",
+    [PROF_ESTIMATE]      = "estimate_post",
+    [PROF_STATS]         = "match_stats",
+    [PROF_SPECTATORS]    = "spectators",
+};
+
+int profiler_active = 0;
+
+// Spans are stored in the order their scopes end, so nested ones come
+// before the scope around them; the viewers sort by timestamp anyway
+ProfEvent *profiler_ring = NULL;
+uint64_t   profiler_count = 0;
+uint64_t   profiler_mask = 0;
+
+static ProfEvent *events = NULL;        // At export: the spans kept, oldest first
+static int event_count = 0;
+static uint64_t events_dropped = 0;     // Overwritten by newer ones
+static double scope_cost_ns = 0.0;      // Measured cost of one recorded scope
+
+// Stamp and CLOCK_MONOTONIC read together at start and export: their
+// ratio converts stamps to nanoseconds
+static uint64_t base_stamp, base_ns;
+
+int profiler_start(int max_events, int detail) {
+    uint64_t capacity = 1;
+    while (capacity < (uint64_t)max_events)
+        capacity <<= 1;
+    profiler_ring = malloc(capacity * sizeof(ProfEvent));
+    if (!profiler_ring) {
+        perror("Profiler buffer");
+        return -1;
+    }
+    memset(profiler_ring, 0, capacity * sizeof(ProfEvent));   // No page faults mid-match
+    profiler_mask = capacity - 1;
+    profiler_count = 0;
+    profiler_active = detail ? 2 : 1;
+    base_ns = (uint64_t)monotonic_ns();
+    base_stamp = profiler_stamp();
+
+    // What a scope costs on this machine, for the overhead estimate
+    enum { CALIBRATION_SCOPES = 1000 };
+    uint64_t t0 = (uint64_t)monotonic_ns();
+    for (int i = 0; i < CALIBRATION_SCOPES; i++) {
+        PROFILE_SCOPE(PROF_TICK);
+        __asm__ __volatile__("" ::: "memory");
+    }
+    scope_cost_ns = (double)((uint64_t)monotonic_ns() - t0) / CALIBRATION_SCOPES;
+    profiler_count = 0;
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Export
+// --------------------------------------------------------------------
+static void print_summary(double ns_per_stamp, int detail) {
+    uint64_t count[PROF_PHASE_COUNT] = { 0 };
+    uint64_t total[PROF_PHASE_COUNT] = { 0 };
+    uint64_t max[PROF_PHASE_COUNT] = { 0 };
+    for (int i = 0; i < event_count; i++) {
+        const ProfEvent *e = &events[i];
+        uint64_t d = (uint64_t)((e->end - e->start) * ns_per_stamp);
+        count[e->phase]++;
+        total[e->phase] += d;
+        if (d > max[e->phase])
+            max[e->phase] = d;
+    }
+
+    printf("\n=== PROFILE ===\n");
+    printf("Phase            | Calls  | Total ms  | Mean us   | Max us\n");
+    printf("-----------------|--------|-----------|-----------|----------\n");
+    for (int p = 0; p < PROF_PHASE_COUNT; p++) {
+        if (count[p] == 0)
+            continue;
+        printf("%-16s | %6llu | %9.3f | %9.3f | %9.3f\n", phase_names[p],
+               (unsigned long long)count[p], total[p] / 1e6,
+               total[p] / 1e3 / count[p], max[p] / 1e3);
+    }
+
+    // What the spans cost against the work they cover. Spans nest or are
+    // disjoint and are stored by end, so walking back from the newest a
+    // span ending before the last outer one started is an outer one too;
+    // the waits inside them are not work
+    uint64_t busy = 0, outer_start = UINT64_MAX;
+    for (int i = event_count - 1; i >= 0; i--) {
+        if (events[i].end <= outer_start) {
+            busy += (uint64_t)((events[i].end - events[i].start) * ns_per_stamp);
+            outer_start = events[i].start;
+        }
+    }
+    uint64_t waits = total[PROF_TICK_WAIT] + total[PROF_RECORDER_WAIT] + total[PROF_COUNTDOWN];
+    busy = busy > waits ? busy - waits : 0;
+    double overhead = scope_cost_ns * event_count;
+    printf("Spans: %d kept, %llu overwritten; ~%.0f ns each, %.3f%% of the work profiled%s\n",
+           event_count, (unsigned long long)events_dropped, scope_cost_ns,
+           busy > 0 ? 100.0 * overhead / busy : 0.0, detail ? " (detail phases on)" : "");
+}
+
+int profiler_export(const char *path) {
+    if (!profiler_active)
+        return -1;
+    int detail = profiler_active > 1;
+    profiler_active = 0;
+
+    // Oldest span first: once the ring has wrapped that is the slot
+    // after the newest
+    uint64_t capacity = profiler_mask + 1;
+    uint64_t kept = profiler_count < capacity ? profiler_count : capacity;
+    events_dropped = profiler_count - kept;
+    event_count = (int)kept;
+    events = malloc((kept + 1) * sizeof(ProfEvent));
+    if (!events) {
+        perror("Profiler export");
+        return -1;
+    }
+    for (uint64_t i = 0; i < kept; i++) {
+        events[i] = profiler_ring[(profiler_count - kept + i) & profiler_mask];
+    }
+    free(profiler_ring);
+    profiler_ring = NULL;
+
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        free(events);
+        events = NULL;
+        return -1;
+    }
+
+    // Stamp rate over the whole recording
+    uint64_t elapsed_ns = (uint64_t)monotonic_ns() - base_ns;
+    uint64_t elapsed_stamps = profiler_stamp() - base_stamp;
+    double ns_per_stamp = elapsed_stamps > 0 ? (double)elapsed_ns / elapsed_stamps : 1.0;
+
+    // Timestamps count from the earliest span
+    uint64_t origin = UINT64_MAX;
+    for (int i = 0; i < event_count; i++) {
+        if (events[i].start < origin)
+            origin = events[i].start;
+    }
+
+    int pid = (int)getpid();
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                 "\"args\":{\"name\":\"referee\"}}", pid, pid);
+    for (int i = 0; i < event_count; i++) {
+        const ProfEvent *e = &events[i];
+        uint64_t ts = (uint64_t)((e->start - origin) * ns_per_stamp);
+        uint64_t dur = (uint64_t)((e->end - e->start) * ns_per_stamp);
+        fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"referee\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                     "\"ts\":%llu.%03u,\"dur\":%llu.%03u}",
+                phase_names[e->phase], pid, pid,
+                (unsigned long long)(ts / 1000), (unsigned)(ts % 1000),
+                (unsigned long long)(dur / 1000), (unsigned)(dur % 1000));
+    }
+    fprintf(out, "\n],\"otherData\":{\"dropped_spans\":%llu,\"scope_cost_ns\":%.1f}}\n",
+            (unsigned long long)events_dropped, scope_cost_ns);
+    int failed = ferror(out);
+    if (fclose(out) != 0 || failed) {
+        perror(path);
+        free(events);
+        events = NULL;
+        return -1;
+    }
+
+    print_summary(ns_per_stamp, detail);
+    free(events);
+    events = NULL;
+    event_count = 0;
+    return 0;
+}
+
+#else
+
+int profiler_start(int max_events, int detail) {
+    (void)max_events;
+    (void)detail;
+    fprintf(stderr, "Profiler not compiled in (build with PROFILER=1)\n");
+    return -1;
+}
+
+int profiler_export(const char *path) {
+    (void)path;
+    return -1;
+}
+
+#endif /* PROFILER */
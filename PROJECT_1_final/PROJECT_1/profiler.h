@@ -0,0 +1,127 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// ----------------------------------------------------------
+// Phase profiler
+//  PROFILE_SCOPE(phase) at the top of a block times the block:
+//  the start is taken where the macro stands and the span is
+//  stored in a preallocated ring when the block is left (GCC's
+//  cleanup attribute), so early returns and breaks are covered.
+//  Nested scopes nest in the output. A span is two stamps and
+//  one store, inline; once the ring is full the oldest spans
+//  are overwritten.
+//
+//  PROFILE_DETAIL(phase) marks the phases inside a tick. They
+//  are only recorded when asked for (--profile-detail): a tick
+//  of the default match is a few microseconds of work, and a
+//  span per phase would cost several percent of it.
+//
+//  Stamps are raw TSC reads on x86 (constant rate on anything
+//  recent), CLOCK_MONOTONIC elsewhere; they are converted to
+//  nanoseconds against CLOCK_MONOTONIC at export.
+//
+//  profiler_export() writes the buffer as Chrome trace-event
+//  JSON ("X" complete events, microsecond timestamps with ns
+//  precision), which ui.perfetto.dev and chrome://tracing
+//  open directly.
+//
+//  Build with PROFILER=0 (make PROFILER=0) and every scope
+//  compiles to nothing. Compiled in but not started, a scope
+//  costs one predictable branch.
+// ----------------------------------------------------------
+
+typedef enum {
+    PROF_TICK = 0,          // One iteration of the referee loop
+    PROF_FALLS,
+    PROF_RECOVERIES,
+    PROF_ENERGY,
+    PROF_ROPE,
+    PROF_TRACE,             // Tick trace record
+    PROF_MIRROR,            // Publish to shared memory
+    PROF_RECORDER_WAIT,     // Waiting for the offscreen recorder
+    PROF_TICK_WAIT,         // Sleeping until the next tick deadline
+    PROF_ROUND_CHECK,
+    PROF_ALIGN,
+    PROF_COUNTDOWN,
+    PROF_NOTIFY_ROUND,
+    PROF_NOTIFY_MATCH,
+    PROF_ESTIMATE,          // Handing the state to the win estimator
+    PROF_STATS,             // Folding the tick into the match statistics
+    PROF_SPECTATORS,        // Deltas and keyframes for the spectator feed
+    PROF_PHASE_COUNT
+} ProfPhase;
+
+#define PROFILER_DEFAULT_EVENTS (1 << 18)
+
+// Start recording into a ring of max_events spans (rounded up to a power
+// of two), with the PROFILE_DETAIL phases if detail is set. Returns 0 on
+// success.
+int  profiler_start(int max_events, int detail);
+
+// Write the recorded spans as trace-event JSON and print a per-phase
+// summary. Returns 0 on success.
+int  profiler_export(const char *path);
+
+#ifdef PROFILER
+
+extern int profiler_active;             // 1 recording, 2 with the detail phases
+
+typedef struct {
+    uint64_t start;         // Stamps
+    uint64_t end;
+    int      phase;
+} ProfEvent;
+
+extern ProfEvent *profiler_ring;
+extern uint64_t   profiler_count;       // Spans stored so far; slot is count & mask
+extern uint64_t   profiler_mask;
+
+typedef struct {
+    int      phase;
+    uint64_t start;         // Stamp, 0 when the profiler is not recording
+} ProfScope;
+
+static inline uint64_t profiler_stamp(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline void profiler_scope_end(ProfScope *s) {
+    if (s->start) {
+        ProfEvent *e = &profiler_ring[profiler_count++ & profiler_mask];
+        e->end = profiler_stamp();
+        e->start = s->start;
+        e->phase = s->phase;
+    }
+}
+
+#define PROF_CONCAT2(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT2(a, b)
+#define PROFILE_SCOPE(phase)                                                  \
+    ProfScope PROF_CONCAT(prof_scope_, __LINE__)                              \
+        __attribute__((cleanup(profiler_scope_end))) =                        \
+        { (phase), __builtin_expect(profiler_active, 0) ? profiler_stamp() : 0 }
+#define PROFILE_DETAIL(phase)                                                 \
+    ProfScope PROF_CONCAT(prof_scope_, __LINE__)                              \
+        __attribute__((cleanup(profiler_scope_end))) =                        \
+        { (phase), __builtin_expect(profiler_active > 1, 0) ? profiler_stamp() : 0 }
+
+#else
+
+#define PROFILE_SCOPE(phase) do { } while (0)
+#define PROFILE_DETAIL(phase) do { } while (0)
+
+#endif /* PROFILER */
+
+#endif /* PROFILER_H */
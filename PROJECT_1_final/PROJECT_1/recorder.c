@@ -0,0 +1,213 @@
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "opengl.h"
+#include "renderer.h"
+#include "recorder.h"
+
+// How long to wait between polls of the shared state
+#define RECORD_POLL_NSEC 50000L
+
+// The original stdout, kept for a "-" stream
+static int stream_fd = -1;
+
+int record_claim_stdout(void) {
+    fflush(stdout);
+    stream_fd = dup(STDOUT_FILENO);
+    if (stream_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        perror("Recorder stdout");
+        return -1;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+// EGL context on an offscreen pbuffer
+// ---------------------------------------------------------------------
+static int create_offscreen_context(int width, int height) {
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // Prefer Mesa's surfaceless platform: it needs no X server or DRM device
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+        fprintf(stderr, "Recorder: no EGL display (0x%x)\n", eglGetError());
+        return -1;
+    }
+
+    static const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE,   8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE,  8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint count = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) ||
+        !eglChooseConfig(display, config_attribs, &config, 1, &count) || count == 0) {
+        fprintf(stderr, "Recorder: no desktop OpenGL pbuffer config (0x%x)\n", eglGetError());
+        return -1;
+    }
+
+    EGLint surface_attribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attribs);
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+    if (surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(display, surface, surface, context)) {
+        fprintf(stderr, "Recorder: cannot create the offscreen context (0x%x)\n", eglGetError());
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+// Frame output
+// ---------------------------------------------------------------------
+typedef struct {
+    const char *pattern;    // PPM file name pattern, or NULL for a stream
+    FILE *stream;
+    int width, height;
+    long frames;
+} FrameSink;
+
+static int sink_write(FrameSink *sink, const unsigned char *rgb) {
+    FILE *out = sink->stream;
+    if (sink->pattern) {
+        char path[1024];
+        snprintf(path, sizeof(path), sink->pattern, (int)sink->frames);
+        out = fopen(path, "wb");
+        if (!out) {
+            perror(path);
+            return -1;
+        }
+        fprintf(out, "P6\n%d %d\n255\n", sink->width, sink->height);
+    }
+
+    size_t row = (size_t)sink->width * 3;
+    if (fwrite(rgb, row, sink->height, out) != (size_t)sink->height) {
+        perror("Recorder: write failed");
+        if (sink->pattern)
+            fclose(out);
+        return -1;
+    }
+    if (sink->pattern)
+        fclose(out);
+    sink->frames++;
+    return 0;
+}
+
+// Read the rendered frame back, top row first
+static void read_frame(unsigned char *rgb, unsigned char *scratch, int width, int height) {
+    size_t row = (size_t)width * 3;
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, scratch);
+    for (int y = 0; y < height; y++) {
+        memcpy(rgb + (size_t)y * row, scratch + (size_t)(height - 1 - y) * row, row);
+    }
+}
+
+static void poll_sleep(void) {
+    struct timespec ts = { 0, RECORD_POLL_NSEC };
+    nanosleep(&ts, NULL);
+}
+
+// ---------------------------------------------------------------------
+// record_visualization
+// ---------------------------------------------------------------------
+int record_visualization(const char *out_path, int fps) {
+    int width = window_width, height = window_height;
+    FrameSink sink = { NULL, NULL, width, height, 0 };
+    if (strchr(out_path, '%')) {
+        sink.pattern = out_path;
+    } else if (strcmp(out_path, "-") == 0) {
+        sink.stream = stream_fd >= 0 ? fdopen(stream_fd, "wb") : NULL;
+        if (!sink.stream) {
+            fprintf(stderr, "Recorder: stdout was not claimed for the stream\n");
+            return -1;
+        }
+    } else {
+        sink.stream = fopen(out_path, "wb");
+        if (!sink.stream) {
+            perror(out_path);
+            return -1;
+        }
+    }
+
+    if (create_offscreen_context(width, height) != 0 || renderer_init() != 0)
+        return -1;
+
+    StateSnapshot *snap = shared_state_alloc_snapshot(shared_state);
+    unsigned char *image = malloc((size_t)width * height * 3);
+    unsigned char *scratch = malloc((size_t)width * height * 3);
+    if (!snap || !image || !scratch) {
+        fprintf(stderr, "Recorder: out of memory\n");
+        return -1;
+    }
+
+    uint32_t seen = 0;
+    uint32_t rendered_change = 0;
+    int have_image = 0;
+    int ended = 0;
+    int status = 0;
+
+    while (status == 0) {
+        uint32_t published = __atomic_load_n(&shared_state->publish_count, __ATOMIC_ACQUIRE);
+        if (published == seen) {
+            if (__atomic_load_n(&shared_state->closed, __ATOMIC_ACQUIRE))
+                break;
+            poll_sleep();
+            continue;
+        }
+        shared_state_read(shared_state, snap);
+
+        // Frames before this snapshot's game time still show the last one
+        double now = snap->game_seconds;
+        while (have_image && status == 0 && (double)sink.frames / fps < now) {
+            status = sink_write(&sink, image);
+        }
+
+        if (!have_image || snap->change_seq != rendered_change || snap->game_ended) {
+            visualization_draw(snap);
+            read_frame(image, scratch, width, height);
+            rendered_change = snap->change_seq;
+            have_image = 1;
+        }
+
+        // Let the referee publish the next one
+        seen = published;
+        __atomic_store_n(&shared_state->recorder_seen, seen, __ATOMIC_RELEASE);
+
+        if (snap->game_ended) {
+            ended = 1;
+            break;
+        }
+    }
+
+    // Hold the last picture: the winner screen for a few seconds, or one
+    // closing frame when the match ran out of time
+    long tail = ended ? (long)RECORD_END_SECONDS * fps : 1;
+    for (long k = 0; k < tail && have_image && status == 0; k++) {
+        status = sink_write(&sink, image);
+    }
+
+    if (sink.stream)
+        fclose(sink.stream);
+    fprintf(stderr, "Recorder: %ld frames of %dx%d at %d fps\n", sink.frames, width, height, fps);
+    free(snap);
+    free(image);
+    free(scratch);
+    return status;
+}
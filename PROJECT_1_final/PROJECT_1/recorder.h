@@ -0,0 +1,33 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+// ----------------------------------------------------------
+// Offscreen recorder
+//  Runs in place of the GLUT visualizer when no display is
+//  available. It renders through an EGL pbuffer (Mesa's
+//  llvmpipe works without any X server or GPU) and writes
+//  frames at a fixed rate of *game* time: frame k shows the
+//  state published at or before k / fps seconds. The referee
+//  waits for the recorder to take each snapshot, so with a
+//  non-wall clock (afap, xN) a match is recorded faster than
+//  real time and without gaps.
+//
+//  Output: a path containing a printf %d (e.g. out/f%05d.ppm)
+//  gets one binary PPM per frame; any other path (or "-" for
+//  stdout) gets a raw RGB24 stream, top row first. With "-"
+//  the stream has stdout to itself: the game's own output goes
+//  to stderr (record_claim_stdout()).
+// ----------------------------------------------------------
+
+#define RECORD_DEFAULT_FPS 30
+#define RECORD_END_SECONDS 5    // The winner screen stays up this long
+
+// Keep the stdout fd for the "-" stream and point stdout at stderr for
+// everything else. Call before anything is printed or forked.
+// Returns 0 on success.
+int record_claim_stdout(void);
+
+// Record until the referee closes the shared state; returns 0 on success
+int record_visualization(const char *out_path, int fps);
+
+#endif /* RECORDER_H */
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+#include "game_clock.h"   // monotonic_ns
+#include "referee_loop.h"
+
+// epoll data of the loop's own fds; channels use their id (>= 0)
+#define LOOP_SIGNAL_KEY (-1)
+#define LOOP_TIMER_KEY  (-2)
+
+int referee_loop_block(RefereeLoop *l, const int *signals, int count) {
+    memset(l, 0, sizeof(*l));
+    l->epoll_fd = l->signal_fd = l->timer_fd = -1;
+    sigemptyset(&l->signals);
+    for (int i = 0; i < count; i++) {
+        sigaddset(&l->signals, signals[i]);
+    }
+    if (sigprocmask(SIG_BLOCK, &l->signals, &l->saved_mask) != 0) {
+        perror("sigprocmask");
+        return -1;
+    }
+    return 0;
+}
+
+void referee_loop_unblock_child(const RefereeLoop *l) {
+    sigprocmask(SIG_SETMASK, &l->saved_mask, NULL);
+}
+
+static int loop_watch(RefereeLoop *l, int fd, int key) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)key;
+    return epoll_ctl(l->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+void referee_loop_pause_channel(RefereeLoop *l, int fd, int channel, int paused) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = paused ? 0 : EPOLLIN;
+    ev.data.u32 = (uint32_t)channel;
+    epoll_ctl(l->epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+int referee_loop_open(RefereeLoop *l) {
+    l->epoll_fd  = epoll_create1(EPOLL_CLOEXEC);
+    l->signal_fd = signalfd(-1, &l->signals, SFD_CLOEXEC | SFD_NONBLOCK);
+    l->timer_fd  = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (l->epoll_fd < 0 || l->signal_fd < 0 || l->timer_fd < 0 ||
+        loop_watch(l, l->signal_fd, LOOP_SIGNAL_KEY) != 0 ||
+        loop_watch(l, l->timer_fd, LOOP_TIMER_KEY) != 0) {
+        perror("referee loop");
+        referee_loop_close(l);
+        return -1;
+    }
+    l->last_return_ns = monotonic_ns();
+    return 0;
+}
+
+int referee_loop_add_channel(RefereeLoop *l, int fd, int channel) {
+    if (loop_watch(l, fd, channel) != 0) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    return 0;
+}
+
+void referee_loop_close(RefereeLoop *l) {
+    if (l->epoll_fd >= 0)  close(l->epoll_fd);
+    if (l->signal_fd >= 0) close(l->signal_fd);
+    if (l->timer_fd >= 0)  close(l->timer_fd);
+    l->epoll_fd = l->signal_fd = l->timer_fd = -1;
+}
+
+void referee_loop_arm(RefereeLoop *l, int64_t wall_deadline_ns) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    // A zero it_value would disarm; a deadline already past fires at once
+    if (wall_deadline_ns <= 0)
+        wall_deadline_ns = 1;
+    its.it_value.tv_sec  = (time_t)(wall_deadline_ns / NSEC_PER_SEC);
+    its.it_value.tv_nsec = (long)(wall_deadline_ns % NSEC_PER_SEC);
+    timerfd_settime(l->timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+// Turn one ready fd into an event; 0 if it had nothing after all
+static int loop_take(RefereeLoop *l, int key, LoopEvent *ev, int was_pending) {
+    memset(ev, 0, sizeof(*ev));
+    if (key == LOOP_SIGNAL_KEY) {
+        struct signalfd_siginfo si;
+        if (read(l->signal_fd, &si, sizeof(si)) != (ssize_t)sizeof(si))
+            return 0;
+        ev->type = LOOP_EV_SIGNAL;
+        ev->signo = (int)si.ssi_signo;
+        ev->pid = (pid_t)si.ssi_pid;
+        if (ev->signo < LOOP_MAX_SIGNALS)
+            l->signal_count[ev->signo]++;
+
+        // Queued while the referee was busy: it waited for that work at most
+        if (was_pending) {
+            int64_t waited = monotonic_ns() - l->last_return_ns;
+            if (waited > l->max_signal_wait_ns)
+                l->max_signal_wait_ns = waited;
+        }
+        return 1;
+    }
+    if (key == LOOP_TIMER_KEY) {
+        uint64_t expirations;
+        if (read(l->timer_fd, &expirations, sizeof(expirations)) != (ssize_t)sizeof(expirations))
+            return 0;
+        ev->type = LOOP_EV_TIMER;
+        l->timer_wakes++;
+        return 1;
+    }
+    ev->type = LOOP_EV_CHANNEL;
+    ev->channel = key;
+    l->channel_wakes++;
+    return 1;
+}
+
+int referee_loop_next(RefereeLoop *l, LoopEvent *ev, int block) {
+    // Whatever is ready right away piled up while the referee was busy
+    int was_pending = 1;
+    for (;;) {
+        struct epoll_event ready;
+        int n = epoll_wait(l->epoll_fd, &ready, 1, was_pending ? 0 : -1);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            return 0;
+        }
+        if (n > 0 && loop_take(l, (int)ready.data.u32, ev, was_pending)) {
+            l->last_return_ns = monotonic_ns();
+            return 1;
+        }
+        if (n == 0) {
+            if (!block) {
+                l->last_return_ns = monotonic_ns();
+                return 0;
+            }
+            was_pending = 0;
+        }
+    }
+}
+
+void referee_loop_print(const RefereeLoop *l) {
+    printf("\n=== EVENT LOOP ===\n");
+    printf("Timer wakes: %llu, channel wakes: %llu\n",
+           (unsigned long long)l->timer_wakes, (unsigned long long)l->channel_wakes);
+    int any = 0;
+    for (int s = 1; s < LOOP_MAX_SIGNALS; s++) {
+        if (l->signal_count[s] == 0)
+            continue;
+        printf("%s%s %llu", any ? ", " : "Signals: ", strsignal(s),
+               (unsigned long long)l->signal_count[s]);
+        any = 1;
+    }
+    if (any)
+        printf("\nWorst wait of a signal behind tick work: %.1f us\n", l->max_signal_wait_ns / 1000.0);
+    else
+        printf("Signals: none\n");
+}
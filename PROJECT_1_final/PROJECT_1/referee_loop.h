@@ -0,0 +1,78 @@
+#ifndef REFEREE_LOOP_H
+#define REFEREE_LOOP_H
+
+#include <signal.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// ----------------------------------------------------------
+// Referee event loop
+//  The referee never runs code from an async signal handler.
+//  Its signals stay blocked from before the first fork and are
+//  read from a signalfd; tick and countdown deadlines come
+//  from a timerfd; player channels are plain fds. All of them
+//  sit in one epoll set, and events are only picked up where
+//  the referee waits, between ticks, so no phase of a tick is
+//  ever interrupted.
+//
+//  A signal that arrives while a tick is being worked on
+//  waits at most until that work is done; the loop keeps the
+//  worst such wait (an upper bound: the busy time before the
+//  signal was picked up).
+// ----------------------------------------------------------
+
+typedef enum {
+    LOOP_EV_TIMER = 1,          // The armed deadline passed
+    LOOP_EV_SIGNAL,             // signo / pid filled in
+    LOOP_EV_CHANNEL             // channel filled in; the owner drains the fd
+} LoopEventType;
+
+typedef struct {
+    LoopEventType type;
+    int   signo;
+    pid_t pid;                  // Sender, for signals
+    int   channel;
+} LoopEvent;
+
+#define LOOP_MAX_SIGNALS 65
+
+typedef struct {
+    int epoll_fd;
+    int signal_fd;
+    int timer_fd;
+    sigset_t signals;           // Consumed through signal_fd
+    sigset_t saved_mask;        // Mask before blocking, for forked children
+
+    int64_t  last_return_ns;    // When the loop last handed control back
+    uint64_t signal_count[LOOP_MAX_SIGNALS];
+    uint64_t channel_wakes;
+    uint64_t timer_wakes;
+    int64_t  max_signal_wait_ns;
+} RefereeLoop;
+
+// Block the signals the loop will consume. Call before forking or
+// starting threads, so none of them can take the signals instead.
+int  referee_loop_block(RefereeLoop *l, const int *signals, int count);
+
+// In a forked child: restore the signal mask from before blocking
+void referee_loop_unblock_child(const RefereeLoop *l);
+
+// Create the epoll set with the signalfd and the timerfd
+int  referee_loop_open(RefereeLoop *l);
+int  referee_loop_add_channel(RefereeLoop *l, int fd, int channel);
+
+// Stop or resume reporting a channel, e.g. while its events have to
+// wait for the end of a tick (the fd stays ready meanwhile)
+void referee_loop_pause_channel(RefereeLoop *l, int fd, int channel, int paused);
+void referee_loop_close(RefereeLoop *l);
+
+// Arm the one-shot timer for an absolute CLOCK_MONOTONIC time
+void referee_loop_arm(RefereeLoop *l, int64_t wall_deadline_ns);
+
+// Next event: returns 1 with *ev filled, 0 if none is ready (only
+// when block is 0)
+int  referee_loop_next(RefereeLoop *l, LoopEvent *ev, int block);
+
+void referee_loop_print(const RefereeLoop *l);
+
+#endif /* REFEREE_LOOP_H */
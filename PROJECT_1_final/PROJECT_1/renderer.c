@@ -0,0 +1,454 @@
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "renderer.h"
+#include "font5x7.h"
+
+// ---------------------------------------------------------------------
+// Attribute slots shared by both programs
+// ---------------------------------------------------------------------
+#define ATTR_POS    0   // Template / batch vertex position
+#define ATTR_COLOR  1   // Template color (figures) or uv (batches)
+#define ATTR_PLACE  2   // Per instance: x, y, scale
+#define ATTR_TINT   3   // Per instance: team color; per batch vertex: color
+
+#define LINE_WIDTH 5.0f
+#define HEAD_DIAMETER 20.0f
+
+// Figure program: template vertices scaled and moved per instance.
+// A template vertex with alpha 1 takes the instance's tint. Heads are
+// single points drawn as round sprites: one primitive instead of a fan.
+static const char *figure_vs =
+    "#version 120\n"
+    "attribute vec2 a_pos;\n"
+    "attribute vec4 a_color;\n"
+    "attribute vec3 a_place;\n"
+    "attribute vec3 a_tint;\n"
+    "uniform vec2 u_view;\n"
+    "uniform float u_head_size;\n"
+    "varying vec3 v_color;\n"
+    "void main() {\n"
+    "    vec2 p = a_place.xy + a_pos * a_place.z;\n"
+    "    gl_Position = vec4(p / u_view * 2.0 - 1.0, 0.0, 1.0);\n"
+    "    v_color = mix(a_color.rgb, a_tint, a_color.a);\n"
+    "    gl_PointSize = u_head_size * a_place.z;\n"
+    "}\n";
+
+static const char *figure_fs =
+    "#version 120\n"
+    "uniform bool u_round;\n"
+    "varying vec3 v_color;\n"
+    "void main() {\n"
+    "    if (u_round && length(gl_PointCoord - 0.5) > 0.5)\n"
+    "        discard;\n"
+    "    gl_FragColor = vec4(v_color, 1.0);\n"
+    "}\n";
+
+// Batch program: lines and text, colored and masked by the atlas
+static const char *batch_vs =
+    "#version 120\n"
+    "attribute vec2 a_pos;\n"
+    "attribute vec2 a_uv;\n"
+    "attribute vec3 a_color;\n"
+    "uniform vec2 u_view;\n"
+    "varying vec2 v_uv;\n"
+    "varying vec3 v_color;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(a_pos / u_view * 2.0 - 1.0, 0.0, 1.0);\n"
+    "    v_uv = a_uv;\n"
+    "    v_color = a_color;\n"
+    "}\n";
+
+static const char *batch_fs =
+    "#version 120\n"
+    "uniform sampler2D u_atlas;\n"
+    "varying vec2 v_uv;\n"
+    "varying vec3 v_color;\n"
+    "void main() {\n"
+    "    gl_FragColor = vec4(v_color, texture2D(u_atlas, v_uv).r);\n"
+    "}\n";
+
+// ---------------------------------------------------------------------
+// Glyph atlas: 16 x 6 cells of 8 x 8 texels. Cells 0..94 hold ' '..'~',
+// cell 95 is solid and gives lines a texel to sample.
+// ---------------------------------------------------------------------
+#define ATLAS_COLS   16
+#define ATLAS_ROWS   6
+#define ATLAS_CELL   8
+#define ATLAS_WIDTH  (ATLAS_COLS * ATLAS_CELL)
+#define ATLAS_HEIGHT (ATLAS_ROWS * ATLAS_CELL)
+#define ATLAS_SOLID  95
+#define GLYPH_SCALE  2.0f
+
+// ---------------------------------------------------------------------
+// Figure templates, in figure units (scaled by the instance)
+// ---------------------------------------------------------------------
+typedef struct {
+    float x, y;
+    float r, g, b, a;
+} TemplateVertex;
+
+typedef struct {
+    GLint first;
+    GLsizei count;
+} TemplateRange;
+
+static TemplateRange standing_head, standing_lines, fallen_head, fallen_lines;
+
+// Growable float arrays for the per-frame batches
+typedef struct {
+    float *data;
+    size_t count;      // Floats in use
+    size_t capacity;
+} FloatBatch;
+
+static GLuint figure_program, batch_program;
+static GLint figure_view_loc, figure_head_loc, figure_round_loc;
+static GLint batch_view_loc, batch_atlas_loc;
+static GLuint template_vbo, instance_vbo, batch_vbo, atlas_texture;
+static FloatBatch standing, fallen;            // x, y, scale, r, g, b
+static FloatBatch lines, glyphs;               // x, y, u, v, r, g, b
+static float view_width, view_height;
+
+#define INSTANCE_FLOATS 6
+#define BATCH_FLOATS    7
+
+// ---------------------------------------------------------------------
+// Setup
+// ---------------------------------------------------------------------
+static GLuint compile_shader(GLenum type, const char *source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "Shader compile failed: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint link_program(const char *vs, const char *fs, const char *attr1, const char *attr3) {
+    GLuint v = compile_shader(GL_VERTEX_SHADER, vs);
+    GLuint f = compile_shader(GL_FRAGMENT_SHADER, fs);
+    if (!v || !f)
+        return 0;
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, v);
+    glAttachShader(program, f);
+    glBindAttribLocation(program, ATTR_POS, "a_pos");
+    glBindAttribLocation(program, ATTR_COLOR, attr1);
+    glBindAttribLocation(program, ATTR_PLACE, "a_place");
+    glBindAttribLocation(program, ATTR_TINT, attr3);
+    glLinkProgram(program);
+    glDeleteShader(v);
+    glDeleteShader(f);
+
+    GLint ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        fprintf(stderr, "Shader link failed: %s\n", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static int push_vertex(TemplateVertex *v, int n, float x, float y, const float rgba[4]) {
+    v[n].x = x;
+    v[n].y = y;
+    v[n].r = rgba[0];
+    v[n].g = rgba[1];
+    v[n].b = rgba[2];
+    v[n].a = rgba[3];
+    return n + 1;
+}
+
+static void upload_templates(void) {
+    static const float tint[4] = {0.0f, 0.0f, 0.0f, 1.0f};   // Instance color
+    static const float gray[4] = {0.5f, 0.5f, 0.5f, 0.0f};
+    static const float red[4]  = {1.0f, 0.0f, 0.0f, 0.0f};
+    TemplateVertex v[32];
+    int n = 0;
+
+    // Standing: head, body, arms and legs
+    standing_head.first = n;
+    n = push_vertex(v, n, 0.0f, 40.0f, tint);
+    standing_head.count = n - standing_head.first;
+
+    standing_lines.first = n;
+    n = push_vertex(v, n, 0.0f, 40.0f, tint);    // Body
+    n = push_vertex(v, n, 0.0f, 0.0f, tint);
+    n = push_vertex(v, n, 0.0f, 28.0f, tint);    // Arms
+    n = push_vertex(v, n, -20.0f, 20.0f, tint);
+    n = push_vertex(v, n, 0.0f, 28.0f, tint);
+    n = push_vertex(v, n, 20.0f, 20.0f, tint);
+    n = push_vertex(v, n, 0.0f, 0.0f, tint);     // Legs
+    n = push_vertex(v, n, -16.0f, -20.0f, tint);
+    n = push_vertex(v, n, 0.0f, 0.0f, tint);
+    n = push_vertex(v, n, 16.0f, -20.0f, tint);
+    standing_lines.count = n - standing_lines.first;
+
+    // Fallen: gray head with a red cross, short body lying down
+    fallen_head.first = n;
+    n = push_vertex(v, n, 0.0f, 40.0f, gray);
+    fallen_head.count = n - fallen_head.first;
+
+    fallen_lines.first = n;
+    n = push_vertex(v, n, -10.0f, 50.0f, red);
+    n = push_vertex(v, n, 10.0f, 30.0f, red);
+    n = push_vertex(v, n, -10.0f, 30.0f, red);
+    n = push_vertex(v, n, 10.0f, 50.0f, red);
+    n = push_vertex(v, n, -10.0f, 20.0f, gray);
+    n = push_vertex(v, n, 10.0f, 20.0f, gray);
+    fallen_lines.count = n - fallen_lines.first;
+
+    glGenBuffers(1, &template_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, template_vbo);
+    glBufferData(GL_ARRAY_BUFFER, n * sizeof(TemplateVertex), v, GL_STATIC_DRAW);
+}
+
+static void upload_atlas(void) {
+    static uint8_t texels[ATLAS_HEIGHT][ATLAS_WIDTH];
+    memset(texels, 0, sizeof(texels));
+
+    // Texture row 0 is the bottom, font row 0 the top of a glyph
+    for (int c = 0; c <= FONT_LAST_CHAR - FONT_FIRST_CHAR; c++) {
+        int cx = (c % ATLAS_COLS) * ATLAS_CELL;
+        int cy = (c / ATLAS_COLS) * ATLAS_CELL;
+        for (int row = 0; row < FONT_HEIGHT; row++) {
+            for (int col = 0; col < FONT_WIDTH; col++) {
+                if (font5x7[c][row] & (0x10 >> col))
+                    texels[cy + FONT_HEIGHT - 1 - row][cx + col] = 255;
+            }
+        }
+    }
+    int sx = (ATLAS_SOLID % ATLAS_COLS) * ATLAS_CELL;
+    int sy = (ATLAS_SOLID / ATLAS_COLS) * ATLAS_CELL;
+    for (int y = 0; y < ATLAS_CELL; y++) {
+        memset(&texels[sy + y][sx], 255, ATLAS_CELL);
+    }
+
+    glGenTextures(1, &atlas_texture);
+    glBindTexture(GL_TEXTURE_2D, atlas_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT, 0,
+                 GL_RED, GL_UNSIGNED_BYTE, texels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+int renderer_init(void) {
+    // Instanced arrays are core in 3.3
+    int major = 0, minor = 0;
+    const char *version = (const char *)glGetString(GL_VERSION);
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 ||
+        major * 10 + minor < 33) {
+        fprintf(stderr, "Renderer needs OpenGL 3.3, got %s\n", version ? version : "none");
+        return -1;
+    }
+
+    figure_program = link_program(figure_vs, figure_fs, "a_color", "a_tint");
+    batch_program = link_program(batch_vs, batch_fs, "a_uv", "a_color");
+    if (!figure_program || !batch_program)
+        return -1;
+    figure_view_loc = glGetUniformLocation(figure_program, "u_view");
+    figure_head_loc = glGetUniformLocation(figure_program, "u_head_size");
+    figure_round_loc = glGetUniformLocation(figure_program, "u_round");
+    batch_view_loc = glGetUniformLocation(batch_program, "u_view");
+    batch_atlas_loc = glGetUniformLocation(batch_program, "u_atlas");
+
+    upload_templates();
+    upload_atlas();
+    glGenBuffers(1, &instance_vbo);
+    glGenBuffers(1, &batch_vbo);
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+// Per-frame batches
+// ---------------------------------------------------------------------
+static float *batch_reserve(FloatBatch *b, size_t floats) {
+    if (b->count + floats > b->capacity) {
+        size_t capacity = b->capacity ? b->capacity * 2 : 1024;
+        while (capacity < b->count + floats)
+            capacity *= 2;
+        float *data = realloc(b->data, capacity * sizeof(float));
+        if (!data) {
+            perror("realloc failed");
+            exit(1);
+        }
+        b->data = data;
+        b->capacity = capacity;
+    }
+    float *out = b->data + b->count;
+    b->count += floats;
+    return out;
+}
+
+static void batch_vertex(FloatBatch *b, float x, float y, float u, float v, const float color[3]) {
+    float *out = batch_reserve(b, BATCH_FLOATS);
+    out[0] = x;
+    out[1] = y;
+    out[2] = u;
+    out[3] = v;
+    out[4] = color[0];
+    out[5] = color[1];
+    out[6] = color[2];
+}
+
+void renderer_begin_frame(int width, int height) {
+    view_width = (float)width;
+    view_height = (float)height;
+    standing.count = fallen.count = lines.count = glyphs.count = 0;
+
+    glViewport(0, 0, width, height);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void renderer_figure(float x, float y, float scale, const float color[3], int is_fallen) {
+    float *out = batch_reserve(is_fallen ? &fallen : &standing, INSTANCE_FLOATS);
+    out[0] = x;
+    out[1] = y;
+    out[2] = scale;
+    out[3] = color[0];
+    out[4] = color[1];
+    out[5] = color[2];
+}
+
+void renderer_line(float x0, float y0, float x1, float y1, const float color[3]) {
+    float u = ((ATLAS_SOLID % ATLAS_COLS) * ATLAS_CELL + ATLAS_CELL * 0.5f) / ATLAS_WIDTH;
+    float v = ((ATLAS_SOLID / ATLAS_COLS) * ATLAS_CELL + ATLAS_CELL * 0.5f) / ATLAS_HEIGHT;
+    batch_vertex(&lines, x0, y0, u, v, color);
+    batch_vertex(&lines, x1, y1, u, v, color);
+}
+
+void renderer_text(float x, float y, const char *text, const float color[3]) {
+    const float w = ATLAS_CELL * GLYPH_SCALE;
+    for (; *text; text++, x += TEXT_ADVANCE) {
+        int c = (unsigned char)*text;
+        if (c <= FONT_FIRST_CHAR || c > FONT_LAST_CHAR)
+            continue;   // Blank or not in the font
+        c -= FONT_FIRST_CHAR;
+        float u0 = (float)((c % ATLAS_COLS) * ATLAS_CELL) / ATLAS_WIDTH;
+        float v0 = (float)((c / ATLAS_COLS) * ATLAS_CELL) / ATLAS_HEIGHT;
+        float u1 = u0 + (float)ATLAS_CELL / ATLAS_WIDTH;
+        float v1 = v0 + (float)ATLAS_CELL / ATLAS_HEIGHT;
+
+        // Two triangles covering the whole cell; the glyph sits on its bottom row
+        batch_vertex(&glyphs, x, y, u0, v0, color);
+        batch_vertex(&glyphs, x + w, y, u1, v0, color);
+        batch_vertex(&glyphs, x + w, y + w, u1, v1, color);
+        batch_vertex(&glyphs, x, y, u0, v0, color);
+        batch_vertex(&glyphs, x + w, y + w, u1, v1, color);
+        batch_vertex(&glyphs, x, y + w, u0, v1, color);
+    }
+}
+
+// ---------------------------------------------------------------------
+// Drawing
+// ---------------------------------------------------------------------
+static void draw_figures(GLintptr offset, GLsizei instances,
+                         const TemplateRange *head, const TemplateRange *body) {
+    if (instances == 0)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    glVertexAttribPointer(ATTR_PLACE, 3, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(float),
+                          (const void *)offset);
+    glVertexAttribPointer(ATTR_TINT, 3, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(float),
+                          (const void *)(offset + 3 * sizeof(float)));
+    glUniform1i(figure_round_loc, 1);
+    glDrawArraysInstanced(GL_POINTS, head->first, head->count, instances);
+    glUniform1i(figure_round_loc, 0);
+    glDrawArraysInstanced(GL_LINES, body->first, body->count, instances);
+}
+
+static void draw_batch(GLenum mode, GLintptr offset, size_t floats) {
+    if (floats == 0)
+        return;
+    glVertexAttribPointer(ATTR_POS, 2, GL_FLOAT, GL_FALSE, BATCH_FLOATS * sizeof(float),
+                          (const void *)offset);
+    glVertexAttribPointer(ATTR_COLOR, 2, GL_FLOAT, GL_FALSE, BATCH_FLOATS * sizeof(float),
+                          (const void *)(offset + 2 * sizeof(float)));
+    glVertexAttribPointer(ATTR_TINT, 3, GL_FLOAT, GL_FALSE, BATCH_FLOATS * sizeof(float),
+                          (const void *)(offset + 4 * sizeof(float)));
+    glDrawArrays(mode, 0, (GLsizei)(floats / BATCH_FLOATS));
+}
+
+void renderer_end_frame(void) {
+    size_t standing_bytes = standing.count * sizeof(float);
+    size_t fallen_bytes = fallen.count * sizeof(float);
+    size_t lines_bytes = lines.count * sizeof(float);
+    size_t glyphs_bytes = glyphs.count * sizeof(float);
+
+    glLineWidth(LINE_WIDTH);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnableVertexAttribArray(ATTR_POS);
+    glEnableVertexAttribArray(ATTR_COLOR);
+    glEnableVertexAttribArray(ATTR_TINT);
+
+    // Batches: rope and marks first, text last (on top of the figures)
+    glBindBuffer(GL_ARRAY_BUFFER, batch_vbo);
+    glBufferData(GL_ARRAY_BUFFER, lines_bytes + glyphs_bytes, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, lines_bytes, lines.data);
+    glBufferSubData(GL_ARRAY_BUFFER, lines_bytes, glyphs_bytes, glyphs.data);
+
+    glUseProgram(batch_program);
+    glUniform2f(batch_view_loc, view_width, view_height);
+    glUniform1i(batch_atlas_loc, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas_texture);
+    draw_batch(GL_LINES, 0, lines.count);
+
+    // Players: every standing and every fallen figure in two instanced passes each
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, standing_bytes + fallen_bytes, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, standing_bytes, standing.data);
+    glBufferSubData(GL_ARRAY_BUFFER, standing_bytes, fallen_bytes, fallen.data);
+
+    glUseProgram(figure_program);
+    glUniform2f(figure_view_loc, view_width, view_height);
+    glUniform1f(figure_head_loc, HEAD_DIAMETER);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glEnable(GL_POINT_SPRITE);
+    glBindBuffer(GL_ARRAY_BUFFER, template_vbo);
+    glVertexAttribPointer(ATTR_POS, 2, GL_FLOAT, GL_FALSE, sizeof(TemplateVertex), (const void *)0);
+    glVertexAttribPointer(ATTR_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(TemplateVertex),
+                          (const void *)(2 * sizeof(float)));
+    glEnableVertexAttribArray(ATTR_PLACE);
+    glVertexAttribDivisor(ATTR_PLACE, 1);
+    glVertexAttribDivisor(ATTR_TINT, 1);
+    draw_figures(0, (GLsizei)(standing.count / INSTANCE_FLOATS), &standing_head, &standing_lines);
+    draw_figures((GLintptr)standing_bytes, (GLsizei)(fallen.count / INSTANCE_FLOATS),
+                 &fallen_head, &fallen_lines);
+    glVertexAttribDivisor(ATTR_PLACE, 0);
+    glVertexAttribDivisor(ATTR_TINT, 0);
+    glDisableVertexAttribArray(ATTR_PLACE);
+
+    // Text
+    glUseProgram(batch_program);
+    glBindBuffer(GL_ARRAY_BUFFER, batch_vbo);
+    draw_batch(GL_TRIANGLES, (GLintptr)lines_bytes, glyphs.count);
+
+    glDisableVertexAttribArray(ATTR_POS);
+    glDisableVertexAttribArray(ATTR_COLOR);
+    glDisableVertexAttribArray(ATTR_TINT);
+    glUseProgram(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,42 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+// ----------------------------------------------------------
+// Retained-mode renderer for the visualizer
+//  Everything that never changes is uploaded once: the stick
+//  figure templates live in a vertex buffer and the glyphs in
+//  a texture atlas. A frame only appends instances (one per
+//  player), line segments and text quads to CPU-side batches;
+//  renderer_end_frame() uploads them and draws every player
+//  with four instanced calls, whatever the roster size.
+//
+//  Needs an OpenGL 3.3 compatibility context (instanced
+//  arrays); it does not care whether that context belongs to
+//  a GLUT window or an offscreen surface.
+// ----------------------------------------------------------
+
+// Glyph cell on screen: the 5x7 font drawn at 2x with spacing
+#define TEXT_ADVANCE 12.0f
+#define TEXT_HEIGHT  14.0f
+
+// Compile shaders and upload the static geometry and glyph atlas into
+// the current context. Returns 0 on success.
+int  renderer_init(void);
+
+// Start a frame of the given size; clears to white
+void renderer_begin_frame(int width, int height);
+
+// Players: standing figures take the given color, fallen ones are drawn
+// gray with a red cross
+void renderer_figure(float x, float y, float scale, const float color[3], int fallen);
+
+// A wide line segment (rope, center mark)
+void renderer_line(float x0, float y0, float x1, float y1, const float color[3]);
+
+// Text with its baseline at y
+void renderer_text(float x, float y, const char *text, const float color[3]);
+
+// Upload this frame's batches and draw them
+void renderer_end_frame(void);
+
+#endif /* RENDERER_H */
@@ -0,0 +1,90 @@
+#include <string.h>
+
+#include "roster.h"
+
+// Round n up to a multiple of a (a power of two)
+static size_t round_up(size_t n, size_t a) {
+    return (n + a - 1) & ~(a - 1);
+}
+
+// Lay the arrays out one after another; with block == NULL only the size
+// is computed
+static size_t roster_layout(Roster *r, char *block, int num_teams, int players_per_team) {
+    int stride = (int)round_up((size_t)players_per_team, ROSTER_LANES);
+    size_t n = (size_t)num_teams * (size_t)stride;
+    size_t off = 0;
+
+#define ROSTER_CARVE(field, type)                                   \
+    do {                                                            \
+        if (r) r->field = (type *)(block + off);                    \
+        off = round_up(off + n * sizeof(type), ROSTER_ALIGN);       \
+    } while (0)
+
+    ROSTER_CARVE(energy,       float);
+    ROSTER_CARVE(effort,       float);
+    ROSTER_CARVE(decay_rate,   float);
+    ROSTER_CARVE(position,     int32_t);
+    ROSTER_CARVE(state,        uint8_t);
+    ROSTER_CARVE(recover_tick, int64_t);
+    ROSTER_CARVE(pid,          pid_t);
+
+#undef ROSTER_CARVE
+
+    if (r) {
+        r->num_teams = num_teams;
+        r->players_per_team = players_per_team;
+        r->stride = stride;
+    }
+    return off;
+}
+
+size_t roster_block_size(int num_teams, int players_per_team) {
+    return roster_layout(NULL, NULL, num_teams, players_per_team);
+}
+
+void roster_bind(Roster *r, void *block, int num_teams, int players_per_team) {
+    roster_layout(r, (char *)block, num_teams, players_per_team);
+}
+
+void roster_view(Roster *view, const Roster *r, int first_team, int num_teams) {
+    size_t off = (size_t)first_team * r->stride;
+    view->num_teams        = num_teams;
+    view->players_per_team = r->players_per_team;
+    view->stride           = r->stride;
+    view->energy           = r->energy + off;
+    view->effort           = r->effort + off;
+    view->decay_rate       = r->decay_rate + off;
+    view->position         = r->position + off;
+    view->state            = r->state + off;
+    view->recover_tick     = r->recover_tick + off;
+    view->pid              = r->pid + off;
+}
+
+void roster_copy_slot(Roster *dst, const Roster *src, int i) {
+    dst->energy[i]       = src->energy[i];
+    dst->effort[i]       = src->effort[i];
+    dst->decay_rate[i]   = src->decay_rate[i];
+    dst->position[i]     = src->position[i];
+    dst->state[i]        = src->state[i];
+    dst->recover_tick[i] = src->recover_tick[i];
+    dst->pid[i]          = src->pid[i];
+}
+
+void roster_copy_hot(Roster *dst, const Roster *src, int team) {
+    size_t off = (size_t)team * src->stride;
+    size_t len = (size_t)src->players_per_team * sizeof(float);
+    memcpy(dst->energy + off, src->energy + off, len);
+    memcpy(dst->effort + off, src->effort + off, len);
+}
+
+void roster_copy_team(Roster *dst, const Roster *src, int team) {
+    size_t off = (size_t)team * src->stride;
+    size_t n = (size_t)src->players_per_team;
+    memcpy(dst->energy + off,       src->energy + off,       n * sizeof(float));
+    memcpy(dst->effort + off,       src->effort + off,       n * sizeof(float));
+    memcpy(dst->decay_rate + off,   src->decay_rate + off,   n * sizeof(float));
+    memcpy(dst->position + off,     src->position + off,     n * sizeof(int32_t));
+    memcpy(dst->state + off,        src->state + off,        n * sizeof(uint8_t));
+    memcpy(dst->recover_tick + off, src->recover_tick + off, n * sizeof(int64_t));
+    memcpy(dst->pid + off,          src->pid + off,          n * sizeof(pid_t));
+}
@@ -0,0 +1,71 @@
+#ifndef ROSTER_H
+#define ROSTER_H
+
+#include <stddef.h>    // For size_t
+#include <stdint.h>
+#include <sys/types.h> // For pid_t
+
+// ----------------------------------------------------------
+// Player roster in structure-of-arrays form
+//  Every field is one contiguous array covering all teams.
+//  Team t owns the slice [t * stride, t * stride + players_per_team)
+//  of each array; stride is players_per_team rounded up to
+//  ROSTER_LANES so every team slice starts on a cache line.
+//  Padding lanes are kept zeroed (inactive, no energy).
+//
+//  The arrays live in one block whose layout depends only on
+//  (num_teams, players_per_team), so a match and the shared
+//  memory copy of it can be synchronized with a single memcpy.
+// ----------------------------------------------------------
+
+#define ROSTER_LANES 16        // Players per 64-byte line of floats
+#define ROSTER_ALIGN 64        // Alignment of every array in the block
+
+// Player state bits
+#define PLAYER_ACTIVE     0x01
+#define PLAYER_RECOVERING 0x02
+
+typedef struct {
+    int num_teams;
+    int players_per_team;
+    int stride;                // Distance between team slices
+
+    // Hot fields, touched every tick
+    float   *energy;
+    float   *effort;
+    float   *decay_rate;
+    int32_t *position;         // 1..players_per_team
+    uint8_t *state;            // PLAYER_* bits
+
+    // Cold fields
+    int64_t *recover_tick;     // Tick a fallen player gets back up
+    pid_t   *pid;
+} Roster;
+
+// Index of player p of team t in the roster arrays
+#define ROSTER_INDEX(r, t, p) ((t) * (r)->stride + (p))
+
+// Player is standing and pulling
+#define PLAYER_PULLING(st) (((st) & (PLAYER_ACTIVE | PLAYER_RECOVERING)) == PLAYER_ACTIVE)
+
+// Size in bytes of a roster block for the given shape
+size_t roster_block_size(int num_teams, int players_per_team);
+
+// Point the arrays of r into block (which must be ROSTER_ALIGN aligned
+// and roster_block_size() bytes long)
+void roster_bind(Roster *r, void *block, int num_teams, int players_per_team);
+
+// Point view at teams [first_team, first_team + num_teams) of r; the
+// view shares r's arrays and stride
+void roster_view(Roster *view, const Roster *r, int first_team, int num_teams);
+
+// Copy every field of slot i between two rosters of the same shape
+void roster_copy_slot(Roster *dst, const Roster *src, int i);
+
+// Copy the hot columns (energy, effort) of one team
+void roster_copy_hot(Roster *dst, const Roster *src, int team);
+
+// Copy every column of one team
+void roster_copy_team(Roster *dst, const Roster *src, int team);
+
+#endif /* ROSTER_H */
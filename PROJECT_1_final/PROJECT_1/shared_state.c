@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>   // For memory mapping (shared memory)
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+// memfd_create(2) and file seals are only declared for _GNU_SOURCE; go
+// through syscall() and the kernel's values
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#endif
+#ifndef F_SEAL_SHRINK
+#define F_SEAL_SHRINK 0x0002
+#endif
+#ifndef F_SEAL_GROW
+#define F_SEAL_GROW 0x0004
+#endif
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+#include "shared_state.h"
+
+#define ALIGN_UP(n) (((n) + ROSTER_ALIGN - 1) & ~(size_t)(ROSTER_ALIGN - 1))
+
+static StateSnapshot *snapshot_at(const SharedState *ss, uint32_t index) {
+    return (StateSnapshot *)((char *)ss + ss->snapshot_offset + index * ss->snapshot_size);
+}
+
+size_t shared_state_size(int num_teams, int players_per_team) {
+    size_t roster_offset   = ALIGN_UP(sizeof(StateSnapshot));
+    size_t snapshot_size   = ALIGN_UP(roster_offset + roster_block_size(num_teams, players_per_team));
+    size_t snapshot_offset = ALIGN_UP(sizeof(SharedState));
+    size_t stats_offset    = snapshot_offset + 2 * snapshot_size;
+    return ALIGN_UP(stats_offset + match_stats_size(num_teams, players_per_team));
+}
+
+SharedState *shared_state_init(void *block, int num_teams, int players_per_team) {
+    size_t roster_offset   = ALIGN_UP(sizeof(StateSnapshot));
+    size_t snapshot_size   = ALIGN_UP(roster_offset + roster_block_size(num_teams, players_per_team));
+    size_t snapshot_offset = ALIGN_UP(sizeof(SharedState));
+    size_t map_size        = shared_state_size(num_teams, players_per_team);
+
+    SharedState *ss = block;
+    memset(ss, 0, map_size);
+    ss->num_teams        = num_teams;
+    ss->players_per_team = players_per_team;
+    ss->roster_offset    = roster_offset;
+    ss->snapshot_size    = snapshot_size;
+    ss->snapshot_offset  = snapshot_offset;
+    ss->stats_offset     = snapshot_offset + 2 * snapshot_size;
+    ss->map_size         = map_size;
+    ss->memfd            = -1;
+    for (uint32_t i = 0; i < 2; i++) {
+        snapshot_at(ss, i)->final_winner = -1;
+    }
+    match_stats_init(shared_state_stats(ss), num_teams, players_per_team);
+    return ss;
+}
+
+int shared_state_memfd(const char *name, size_t size) {
+#ifdef SYS_memfd_create
+    int fd = (int)syscall(SYS_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+        return -1;
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    (void)name;
+    (void)size;
+    return -1;
+#endif
+}
+
+int shared_state_seal(int fd) {
+    // Kernels before 5.1 know no F_SEAL_FUTURE_WRITE: the size is still
+    // fixed, and the read-only fd is what keeps readers out
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE) != 0 &&
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) != 0)
+        perror("Sealing the shared state");
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    int ro = open(path, O_RDONLY | O_CLOEXEC);
+    if (ro < 0)
+        return fd;      // No /proc: the sealed fd itself
+    close(fd);
+    return ro;
+}
+
+SharedState *shared_state_create(int num_teams, int players_per_team) {
+    size_t map_size = shared_state_size(num_teams, players_per_team);
+    int fd = shared_state_memfd("tug_of_war_state", map_size);
+    void *map_ptr = mmap(NULL, map_size,
+                         PROT_READ | PROT_WRITE,
+                         fd >= 0 ? MAP_SHARED : MAP_SHARED | MAP_ANONYMOUS,
+                         fd, 0);
+    if (map_ptr == MAP_FAILED) {
+        perror("mmap failed");
+        if (fd >= 0)
+            close(fd);
+        return NULL;
+    }
+    SharedState *ss = shared_state_init(map_ptr, num_teams, players_per_team);
+    ss->memfd = fd >= 0 ? shared_state_seal(fd) : -1;
+    return ss;
+}
+
+void shared_state_destroy(SharedState *ss) {
+    if (ss) {
+        if (ss->memfd >= 0)
+            close(ss->memfd);
+        munmap(ss, ss->map_size);
+    }
+}
+
+SharedState *shared_state_attach(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SharedState)) {
+        fprintf(stderr, "Shared state: not a state block\n");
+        return NULL;
+    }
+    void *map_ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map_ptr == MAP_FAILED) {
+        perror("mmap failed");
+        return NULL;
+    }
+    SharedState *ss = map_ptr;
+    if (ss->map_size != (size_t)st.st_size) {
+        fprintf(stderr, "Shared state: size does not match its header\n");
+        munmap(map_ptr, (size_t)st.st_size);
+        return NULL;
+    }
+    return ss;
+}
+
+void shared_state_detach(SharedState *ss) {
+    if (ss) {
+        munmap(ss, ss->map_size);
+    }
+}
+
+// ----------------------------------------------------------
+// Writer side (referee only)
+// ----------------------------------------------------------
+StateSnapshot *shared_state_begin_write(SharedState *ss) {
+    uint32_t back = __atomic_load_n(&ss->front, __ATOMIC_RELAXED) ^ 1;
+    StateSnapshot *snap = snapshot_at(ss, back);
+
+    // Odd seq first, so a reader still copying this buffer notices
+    __atomic_store_n(&snap->seq, snap->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return snap;
+}
+
+void shared_state_end_write(SharedState *ss, StateSnapshot *snap) {
+    uint32_t index = (uint32_t)(((char *)snap - ((char *)ss + ss->snapshot_offset)) / ss->snapshot_size);
+    snap->publish_count = ss->publish_count + 1;
+    __atomic_store_n(&snap->seq, snap->seq + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ss->front, index, __ATOMIC_RELEASE);
+    __atomic_store_n(&ss->publish_count, ss->publish_count + 1, __ATOMIC_RELEASE);
+}
+
+// ----------------------------------------------------------
+// Reader side
+// ----------------------------------------------------------
+int shared_state_read(const SharedState *ss, StateSnapshot *out) {
+    for (int retries = 0; ; retries++) {
+        const StateSnapshot *snap = snapshot_at(ss, __atomic_load_n(&ss->front, __ATOMIC_ACQUIRE));
+        uint32_t before = __atomic_load_n(&snap->seq, __ATOMIC_ACQUIRE);
+        if (before & 1)
+            continue;
+
+        memcpy(out, snap, ss->snapshot_size);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&snap->seq, __ATOMIC_RELAXED) == before)
+            return retries;
+    }
+}
+
+StateSnapshot *shared_state_alloc_snapshot(const SharedState *ss) {
+    void *snap = NULL;
+    if (posix_memalign(&snap, ROSTER_ALIGN, ss->snapshot_size) != 0)
+        return NULL;
+    memset(snap, 0, ss->snapshot_size);
+    return snap;
+}
+
+// ----------------------------------------------------------
+// Win estimate
+// ----------------------------------------------------------
+void shared_state_write_estimate(SharedState *ss, const WinEstimate *est) {
+    WinEstimate *w = &ss->win_estimate;
+    uint32_t seq = w->seq;
+    __atomic_store_n(&w->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    w->rollouts = est->rollouts;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        w->p_win[t] = est->p_win[t];
+    }
+    w->p_tie                 = est->p_tie;
+    w->ci_low                = est->ci_low;
+    w->ci_high               = est->ci_high;
+    w->game_seconds          = est->game_seconds;
+    w->rollouts_per_core_sec = est->rollouts_per_core_sec;
+    __atomic_store_n(&w->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void shared_state_read_estimate(const SharedState *ss, WinEstimate *out) {
+    const WinEstimate *w = &ss->win_estimate;
+    for (;;) {
+        uint32_t before = __atomic_load_n(&w->seq, __ATOMIC_ACQUIRE);
+        if (before & 1)
+            continue;
+        memcpy(out, w, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&w->seq, __ATOMIC_RELAXED) == before)
+            return;
+    }
+}
+
+MatchStats *shared_state_stats(const SharedState *ss) {
+    return (MatchStats *)((char *)ss + ss->stats_offset);
+}
+
+void snapshot_roster(const SharedState *ss, StateSnapshot *snap, Roster *view) {
+    roster_bind(view, (char *)snap + ss->roster_offset, ss->num_teams, ss->players_per_team);
+}
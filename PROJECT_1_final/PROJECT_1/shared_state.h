@@ -0,0 +1,121 @@
+#ifndef SHARED_STATE_H
+#define SHARED_STATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"    // NUM_TEAMS, Roster
+#include "tick_scheduler.h"
+#include "match_stats.h"
+
+// ----------------------------------------------------------
+// The SharedState block the referee publishes and the
+// visualizer reads.
+//
+// The header is followed by two snapshot buffers. Each
+// snapshot holds the summary fields below and, at
+// roster_offset, a roster block with the same layout as the
+// referee's Match roster (see roster.h). The streaming match
+// statistics (match_stats.h) come after the snapshots.
+//
+// Publishing is a seqlock over a double buffer: the referee
+// fills the buffer readers are not pointed at, bumping its
+// seq to odd before and back to even after, then flips
+// 'front'. Readers copy the front buffer and retry if its
+// seq was odd or changed under them. Nobody blocks.
+// ----------------------------------------------------------
+typedef struct {
+    uint32_t seq;                    // Odd while the referee is writing this buffer
+    uint32_t change_seq;             // Moves only when something besides the clock changed
+    uint32_t publish_count;          // SharedState publish_count once this snapshot was out
+    float rope_position;             // Real-time rope displacement
+    int   team_round_wins[NUM_TEAMS];
+    int   round_number;              // Current round
+    int   game_ended;                // 0 while running, 1 once the match is done
+    int   final_winner;              // -1 if no winner yet, else 0 or 1 for which team won
+    float team_efforts[NUM_TEAMS];   // Total effort per team
+    float game_seconds;              // Game clock at the publish
+} StateSnapshot;
+
+// Live win probability from the estimator's rollouts. It has its own
+// seqlock: estimator threads write it, not the referee's publish.
+typedef struct {
+    uint32_t seq;                    // Odd while being written
+    uint32_t rollouts;               // Rollouts behind the estimate, 0 = none yet
+    float p_win[NUM_TEAMS];          // Chance each team wins the match
+    float p_tie;
+    float ci_low, ci_high;           // 95% interval for p_win[0]
+    float game_seconds;              // Game clock of the state rolled out from
+    float rollouts_per_core_sec;     // Estimator throughput
+} WinEstimate;
+
+typedef struct {
+    // Shape of the snapshots that follow the header
+    int    num_teams;
+    int    players_per_team;
+    size_t roster_offset;            // Byte offset of the roster block in a snapshot
+    size_t snapshot_size;            // Size of one snapshot including its roster
+    size_t snapshot_offset;          // Byte offset of snapshot 0; snapshot 1 follows it
+    size_t stats_offset;             // Byte offset of the MatchStats block
+    size_t map_size;                 // Size of the whole mapping
+    int    memfd;                    // Read-only fd of the sealed memfd behind the mapping,
+                                     // -1 if anonymous (meaningless to an attached reader)
+
+    uint32_t front;                  // Index of the last complete snapshot
+    uint32_t publish_count;          // Snapshots published so far
+
+    // Offscreen recorder handshake: while attached, the referee does not
+    // publish again before the recorder has seen the last snapshot
+    uint32_t recorder_attached;
+    uint32_t recorder_seen;          // publish_count the recorder has rendered
+    int      closed;                 // Referee is done publishing
+    TickStats tick_stats;            // Tick scheduler counters, updated live
+    WinEstimate win_estimate;
+} SharedState;
+
+// Map a shared block sized for the roster. It is backed by a memfd, so
+// besides being inherited across fork it can be handed to another
+// process (SCM_RIGHTS) and attached there; without memfds it is anonymous.
+// Once mapped the memfd is sealed and only a read-only fd of it is kept.
+SharedState *shared_state_create(int num_teams, int players_per_team);
+
+// A memfd of size bytes that can be sealed; -1 without memfds
+int shared_state_memfd(const char *name, size_t size);
+
+// Once the writer has mapped fd: seal its size and further writable
+// mappings or writes (F_SEAL_FUTURE_WRITE), and trade it for a read-only
+// fd of the same memfd. Returns the fd to hand out; fd is closed if
+// that is not fd itself.
+int shared_state_seal(int fd);
+
+// Reader in another process: map the block behind a passed memfd
+// read-only. shared_state_detach() unmaps it again.
+SharedState *shared_state_attach(int fd);
+void shared_state_detach(SharedState *ss);
+
+// Lay a SharedState out in a block of shared_state_size() bytes (aligned
+// to ROSTER_ALIGN) that the caller mapped, e.g. a slot of an arena
+size_t shared_state_size(int num_teams, int players_per_team);
+SharedState *shared_state_init(void *block, int num_teams, int players_per_team);
+void shared_state_destroy(SharedState *ss);
+
+// Writer: get the back buffer, fill every field and its roster, then publish it
+// (publish_count moves on)
+StateSnapshot *shared_state_begin_write(SharedState *ss);
+void shared_state_end_write(SharedState *ss, StateSnapshot *snap);
+
+// Reader: copy a consistent snapshot into 'out' (snapshot_size bytes,
+// e.g. from shared_state_alloc_snapshot). Returns the number of retries.
+int shared_state_read(const SharedState *ss, StateSnapshot *out);
+StateSnapshot *shared_state_alloc_snapshot(const SharedState *ss);
+
+// Win estimate: one writer at a time; readers copy it like a snapshot
+void shared_state_write_estimate(SharedState *ss, const WinEstimate *est);
+void shared_state_read_estimate(const SharedState *ss, WinEstimate *out);
+
+// Streaming statistics of the match, updated by the referee every tick
+MatchStats *shared_state_stats(const SharedState *ss);
+
+// Bind a view of the roster stored in a snapshot
+void snapshot_roster(const SharedState *ss, StateSnapshot *snap, Roster *view);
+
+#endif /* SHARED_STATE_H */
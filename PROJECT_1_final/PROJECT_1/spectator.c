@@ -0,0 +1,469 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "game_clock.h"
+#include "spectator.h"
+
+// Player records that fit in one delta
+#define DELTA_MAX_PLAYERS ((SPECTATOR_MAX_DELTA - sizeof(FeedMessage)) / sizeof(PlayerDelta))
+
+static int fill_address(struct sockaddr_un *addr, const char *path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+static void fill_summary(FeedMessage *h, uint32_t type, const StateSnapshot *snap) {
+    memset(h, 0, sizeof(*h));
+    h->type          = type;
+    h->publish_count = snap->publish_count;
+    h->change_seq    = snap->change_seq;
+    h->rope_position = snap->rope_position;
+    h->round_number  = snap->round_number;
+    h->game_ended    = snap->game_ended;
+    h->final_winner  = snap->final_winner;
+    h->game_seconds  = snap->game_seconds;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        h->team_round_wins[t] = snap->team_round_wins[t];
+        h->team_efforts[t]    = snap->team_efforts[t];
+    }
+}
+
+// ----------------------------------------------------------
+// Referee side
+// ----------------------------------------------------------
+int spectator_feed_open(SpectatorFeed *f, const char *path, SharedState *ss, float rope_threshold) {
+    memset(f, 0, sizeof(*f));
+    f->listen_fd = -1;
+    if (ss->memfd < 0) {
+        fprintf(stderr, "Spectators: the shared state has no memfd to hand out\n");
+        return -1;
+    }
+    struct sockaddr_un addr;
+    if (fill_address(&addr, path) != 0)
+        return -1;
+
+    size_t block = roster_block_size(ss->num_teams, ss->players_per_team);
+    if (posix_memalign(&f->last_block, ROSTER_ALIGN, block) != 0 ||
+        (f->msg = malloc(SPECTATOR_MAX_DELTA)) == NULL) {
+        perror("Spectators");
+        free(f->last_block);
+        f->last_block = NULL;
+        return -1;
+    }
+    roster_bind(&f->last, f->last_block, ss->num_teams, ss->players_per_team);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        spectator_feed_close(f);
+        return -1;
+    }
+    // A socket left over from a referee that did not clean up; anything
+    // else at the path is not ours to remove, and bind() reports it
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        perror("bind/listen");
+        close(fd);
+        spectator_feed_close(f);
+        return -1;
+    }
+    for (int v = 0; v < SPECTATOR_MAX_VIEWERS; v++) {
+        f->viewers[v].fd = -1;
+    }
+    f->listen_fd = fd;
+    f->path = path;
+    f->ss = ss;
+    f->rope_threshold = rope_threshold;
+    return 0;
+}
+
+// HELLO with the read-only fd of the sealed memfd attached
+static int send_hello(const SpectatorFeed *f, int fd) {
+    FeedMessage h;
+    memset(&h, 0, sizeof(h));
+    h.type           = FEED_HELLO;
+    h.publish_count  = f->ss->publish_count;
+    h.rope_threshold = f->rope_threshold;
+
+    struct iovec iov = { &h, sizeof(h) };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cm), &f->ss->memfd, sizeof(int));
+    return sendmsg(fd, &msg, MSG_NOSIGNAL) == (ssize_t)sizeof(h) ? 0 : -1;
+}
+
+void spectator_feed_accept(SpectatorFeed *f) {
+    int fd;
+    while ((fd = accept(f->listen_fd, NULL, NULL)) >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        int v = 0;
+        while (v < SPECTATOR_MAX_VIEWERS && f->viewers[v].fd >= 0)
+            v++;
+        if (v == SPECTATOR_MAX_VIEWERS || send_hello(f, fd) != 0) {
+            close(fd);
+            continue;
+        }
+        f->viewers[v].fd = fd;
+        f->viewers[v].keyframes_only = 0;
+        f->num_viewers++;
+        f->viewers_total++;
+    }
+}
+
+static void drop_viewer(SpectatorFeed *f, int v) {
+    close(f->viewers[v].fd);
+    f->viewers[v].fd = -1;
+    f->num_viewers--;
+}
+
+// Send without waiting: 1 if sent, 0 if the socket is full, -1 if
+// the viewer is gone (and has been dropped)
+static int send_to(SpectatorFeed *f, int v, const void *msg, size_t len) {
+    ssize_t n = send(f->viewers[v].fd, msg, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n == (ssize_t)len)
+        return 1;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    drop_viewer(f, v);
+    return -1;
+}
+
+// Build this publish's delta against the feed's copy of the drawn
+// fields, bringing the copy up to date. Returns the message length,
+// or 0 if it does not fit in a delta.
+static size_t build_delta(SpectatorFeed *f, const StateSnapshot *snap) {
+    const SharedState *ss = f->ss;
+    Roster cur;
+    snapshot_roster(ss, (StateSnapshot *)snap, &cur);
+    Roster *last = &f->last;
+
+    FeedMessage *h = (FeedMessage *)f->msg;
+    fill_summary(h, FEED_DELTA, snap);
+    PlayerDelta *out = (PlayerDelta *)(f->msg + sizeof(FeedMessage));
+    size_t count = 0;
+    for (int t = 0; t < ss->num_teams; t++) {
+        int base = t * cur.stride;
+        for (int p = 0; p < ss->players_per_team; p++) {
+            int i = base + p;
+            if (cur.energy[i] == last->energy[i] && cur.effort[i] == last->effort[i] &&
+                cur.position[i] == last->position[i] && cur.state[i] == last->state[i])
+                continue;
+            last->energy[i]   = cur.energy[i];
+            last->effort[i]   = cur.effort[i];
+            last->position[i] = cur.position[i];
+            last->state[i]    = cur.state[i];
+            if (count < DELTA_MAX_PLAYERS) {
+                out[count].index    = (uint32_t)i;
+                out[count].state    = cur.state[i];
+                out[count].position = cur.position[i];
+                out[count].energy   = cur.energy[i];
+                out[count].effort   = cur.effort[i];
+            }
+            count++;
+        }
+    }
+    if (count > DELTA_MAX_PLAYERS)
+        return 0;
+    h->count = (uint32_t)count;
+    return sizeof(FeedMessage) + count * sizeof(PlayerDelta);
+}
+
+void spectator_feed_publish(SpectatorFeed *f, const StateSnapshot *snap) {
+    if (f->num_viewers == 0)
+        return;     // The next viewer starts from a keyframe: last_publish is behind
+    int64_t start = monotonic_ns();
+    int live = 0;
+    for (int v = 0; v < SPECTATOR_MAX_VIEWERS; v++) {
+        live += f->viewers[v].fd >= 0 && !f->viewers[v].keyframes_only;
+    }
+
+    FeedMessage key;
+    fill_summary(&key, FEED_KEYFRAME, snap);
+
+    // Live viewers: the delta, or a keyframe if there is none to send
+    const void *msg = &key;
+    size_t len = sizeof(key);
+    if (live > 0) {
+        size_t delta_len = 0;
+        if (f->last_valid && snap->publish_count == f->last_publish + 1) {
+            delta_len = build_delta(f, snap);
+        } else {
+            memcpy(f->last_block, (const char *)snap + f->ss->roster_offset,
+                   roster_block_size(f->ss->num_teams, f->ss->players_per_team));
+            f->last_valid = 1;
+        }
+        f->last_publish = snap->publish_count;
+        if (delta_len > 0) {
+            msg = f->msg;
+            len = delta_len;
+        }
+    }
+
+    // Keyframe-only viewers: one keyframe a second, and the final state
+    int keyframe_due = snap->game_ended || snap->publish_count % SPECTATOR_KEYFRAME_TICKS == 0;
+    FeedMessage key_only = key;
+    key_only.flags = FEED_KEYFRAMES_ONLY;
+
+    for (int v = 0; v < SPECTATOR_MAX_VIEWERS; v++) {
+        SpectatorViewer *sv = &f->viewers[v];
+        if (sv->fd < 0)
+            continue;
+        if (!sv->keyframes_only) {
+            int sent = send_to(f, v, msg, len);
+            if (sent > 0) {
+                if (msg == f->msg) {
+                    f->deltas++;
+                    f->delta_bytes += len;
+                } else {
+                    f->keyframes++;
+                }
+            } else if (sent == 0) {
+                sv->keyframes_only = 1;     // Fell behind: never hold up the tick for it
+                f->viewers_dropped++;
+            }
+        } else if (keyframe_due && send_to(f, v, &key_only, sizeof(key_only)) > 0) {
+            f->keyframes++;
+        }
+    }
+
+    int64_t cost = monotonic_ns() - start;
+    f->publishes++;
+    f->cost_ns += cost;
+    if (cost > f->max_cost_ns)
+        f->max_cost_ns = cost;
+}
+
+void spectator_feed_print(const SpectatorFeed *f) {
+    if (f->path == NULL)
+        return;
+    printf("\n=== SPECTATORS ===\n");
+    printf("Viewers: %llu attached, %llu dropped to keyframes, %d still connected\n",
+           (unsigned long long)f->viewers_total, (unsigned long long)f->viewers_dropped,
+           f->num_viewers);
+    printf("Messages: %llu deltas (mean %.0f bytes), %llu keyframes\n",
+           (unsigned long long)f->deltas,
+           f->deltas ? (double)f->delta_bytes / (double)f->deltas : 0.0,
+           (unsigned long long)f->keyframes);
+    printf("Feed cost: mean %.1f us per publish with viewers, worst %.1f us\n",
+           f->publishes ? (double)f->cost_ns / 1000.0 / (double)f->publishes : 0.0,
+           f->max_cost_ns / 1000.0);
+}
+
+void spectator_feed_close(SpectatorFeed *f) {
+    for (int v = 0; v < SPECTATOR_MAX_VIEWERS; v++) {
+        if (f->path && f->viewers[v].fd >= 0)
+            drop_viewer(f, v);
+    }
+    if (f->listen_fd >= 0) {
+        close(f->listen_fd);
+        unlink(f->path);
+        f->listen_fd = -1;
+    }
+    free(f->last_block);
+    free(f->msg);
+    f->last_block = NULL;
+    f->msg = NULL;
+    f->path = NULL;
+}
+
+// ----------------------------------------------------------
+// Viewer side
+// ----------------------------------------------------------
+int spectator_connect(SpectatorClient *c, const char *path) {
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+    struct sockaddr_un addr;
+    if (fill_address(&addr, path) != 0)
+        return -1;
+    c->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (c->fd < 0 || connect(c->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("Spectator feed");
+        spectator_disconnect(c);
+        return -1;
+    }
+
+    // The HELLO and the memfd behind the referee's state
+    FeedMessage h;
+    struct iovec iov = { &h, sizeof(h) };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    ssize_t n = recvmsg(c->fd, &msg, MSG_CMSG_CLOEXEC);
+    struct cmsghdr *cm = n == (ssize_t)sizeof(h) ? CMSG_FIRSTHDR(&msg) : NULL;
+    if (cm == NULL || h.type != FEED_HELLO ||
+        cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) {
+        fprintf(stderr, "Spectator feed: no match state offered (full?)\n");
+        spectator_disconnect(c);
+        return -1;
+    }
+    int memfd;
+    memcpy(&memfd, CMSG_DATA(cm), sizeof(int));
+    c->ss = shared_state_attach(memfd);
+    close(memfd);       // The mapping keeps the state alive
+    c->buf = malloc(SPECTATOR_MAX_DELTA);
+    if (c->ss == NULL || c->buf == NULL) {
+        spectator_disconnect(c);
+        return -1;
+    }
+    c->rope_threshold = h.rope_threshold;
+    return 0;
+}
+
+static void apply_delta(SpectatorClient *c, const FeedMessage *h, StateSnapshot *frame) {
+    Roster view;
+    snapshot_roster(c->ss, frame, &view);
+    const PlayerDelta *d = (const PlayerDelta *)(h + 1);
+    int players = c->ss->num_teams * view.stride;
+    for (uint32_t k = 0; k < h->count; k++) {
+        int i = (int)d[k].index;
+        if (i >= players)
+            continue;
+        view.energy[i]   = d[k].energy;
+        view.effort[i]   = d[k].effort;
+        view.position[i] = d[k].position;
+        view.state[i]    = (uint8_t)d[k].state;
+    }
+    frame->change_seq    = h->change_seq;
+    frame->rope_position = h->rope_position;
+    frame->round_number  = h->round_number;
+    frame->game_ended    = h->game_ended;
+    frame->final_winner  = h->final_winner;
+    frame->game_seconds  = h->game_seconds;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        frame->team_round_wins[t] = h->team_round_wins[t];
+        frame->team_efforts[t]    = h->team_efforts[t];
+    }
+    frame->publish_count = h->publish_count;
+}
+
+int spectator_poll(SpectatorClient *c, StateSnapshot *frame) {
+    if (c->have == 0) {
+        shared_state_read(c->ss, frame);
+        c->have = frame->publish_count;
+    }
+    int taken = 0;
+    for (;;) {
+        ssize_t n = recv(c->fd, c->buf, SPECTATOR_MAX_DELTA, MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            break;
+        if (n <= 0) {
+            // The mapping outlives the feed: take the last state published
+            if (!c->hung_up) {
+                c->hung_up = 1;
+                shared_state_read(c->ss, frame);
+                c->have = frame->publish_count;
+            }
+            break;
+        }
+        const FeedMessage *h = (const FeedMessage *)c->buf;
+        if ((size_t)n < sizeof(*h))
+            continue;
+        taken++;
+        if (h->flags & FEED_KEYFRAMES_ONLY)
+            c->keyframes_only = 1;
+        if (h->publish_count <= c->have)
+            continue;       // The frame read from the mapping is already past it
+
+        if (h->type == FEED_DELTA && h->publish_count == c->have + 1 &&
+            (size_t)n == sizeof(*h) + h->count * sizeof(PlayerDelta)) {
+            apply_delta(c, h, frame);
+            c->deltas++;
+        } else {
+            if (h->type == FEED_DELTA)
+                c->gaps++;
+            else
+                c->keyframes++;
+            shared_state_read(c->ss, frame);
+        }
+        c->have = frame->publish_count;
+    }
+    return (taken == 0 && c->hung_up) ? -1 : taken;
+}
+
+void spectator_disconnect(SpectatorClient *c) {
+    if (c->fd >= 0)
+        close(c->fd);
+    shared_state_detach(c->ss);
+    free(c->buf);
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+}
+
+int spectate_text(const char *path) {
+    SpectatorClient c;
+    if (spectator_connect(&c, path) != 0)
+        return -1;
+    StateSnapshot *frame = shared_state_alloc_snapshot(c.ss);
+    if (frame == NULL) {
+        spectator_disconnect(&c);
+        return -1;
+    }
+    printf("Spectating %s: %d teams of %d players\n", path, c.ss->num_teams, c.ss->players_per_team);
+
+    int shown = -1;
+    while (spectator_poll(&c, frame) >= 0 && !frame->game_ended) {
+        if ((int)frame->game_seconds != shown) {
+            shown = (int)frame->game_seconds;
+            printf("[%4d s] Round %d | Rope %7.2f | Wins %d-%d | Effort %.1f vs %.1f%s\n",
+                   shown, frame->round_number, frame->rope_position,
+                   frame->team_round_wins[0], frame->team_round_wins[1],
+                   frame->team_efforts[0], frame->team_efforts[1],
+                   c.keyframes_only ? " | keyframes only" : "");
+            fflush(stdout);
+        }
+        struct pollfd pfd = { c.fd, POLLIN, 0 };
+        poll(&pfd, 1, 1000);
+    }
+
+    int ended = frame->game_ended;
+    if (!ended)
+        printf("Referee closed the feed before the end of the match\n");
+    else if (frame->final_winner >= 0)
+        printf("Match over: Team %d wins (%d-%d)\n", frame->final_winner + 1,
+               frame->team_round_wins[0], frame->team_round_wins[1]);
+    else
+        printf("Match over: tie (%d-%d)\n", frame->team_round_wins[0], frame->team_round_wins[1]);
+    printf("Feed: %llu deltas, %llu keyframes, %llu gaps caught up from the mapping%s\n",
+           (unsigned long long)c.deltas, (unsigned long long)c.keyframes,
+           (unsigned long long)c.gaps, c.keyframes_only ? ", dropped to keyframes only" : "");
+    free(frame);
+    spectator_disconnect(&c);
+    return ended ? 0 : -1;
+}
@@ -0,0 +1,145 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "shared_state.h"
+
+// ----------------------------------------------------------
+// Spectator feed
+//  Viewers in processes of their own attach to a running match
+//  over a Unix seqpacket socket (--spectators PATH). A viewer
+//  is first sent a HELLO carrying a read-only fd of the
+//  sealed memfd behind the referee's SharedState (SCM_RIGHTS);
+//  it maps it and takes its full frames from there, the same seqlock reads the
+//  forked viewer does. Nothing of the full state is copied per
+//  viewer.
+//
+//  After every publish the referee sends live viewers one
+//  DELTA: the summary (rope, scores, clock) and the players
+//  whose drawn fields (energy, effort, position, state) changed
+//  since the previous publish. It is built once, against the
+//  feed's own copy of those fields, and the same bytes go to
+//  every viewer. A KEYFRAME asks the viewer to read its frame
+//  from the mapping instead: sent when a delta would be larger
+//  than SPECTATOR_MAX_DELTA, and every SPECTATOR_KEYFRAME_TICKS
+//  publishes (and at the end of the match) to keyframe-only
+//  viewers.
+//
+//  Sends never wait. A live viewer whose socket is full is
+//  dropped to keyframe-only mode for good (it may reconnect),
+//  so a slow viewer never holds up a tick. A viewer that sees a
+//  gap in the publish counts reads the mapping to catch up.
+// ----------------------------------------------------------
+
+#define SPECTATOR_MAX_VIEWERS    64
+#define SPECTATOR_KEYFRAME_TICKS TICKS_PER_SECOND   // Keyframe-only viewers: one per game second
+#define SPECTATOR_MAX_DELTA      (64 * 1024)        // Largest delta message in bytes
+
+// Message types
+#define FEED_HELLO    1
+#define FEED_KEYFRAME 2
+#define FEED_DELTA    3
+
+// Message flags
+#define FEED_KEYFRAMES_ONLY 0x1   // The viewer has been dropped to keyframes
+
+// Every message starts with this header; a DELTA is followed by
+// 'count' PlayerDelta records
+typedef struct {
+    uint32_t type;
+    uint32_t flags;
+    uint32_t publish_count;          // Publish the message brings the viewer to
+    uint32_t count;                  // DELTA: player records that follow
+    uint32_t change_seq;
+    float    rope_position;
+    int32_t  team_round_wins[NUM_TEAMS];
+    int32_t  round_number;
+    int32_t  game_ended;
+    int32_t  final_winner;
+    float    team_efforts[NUM_TEAMS];
+    float    game_seconds;
+    float    rope_threshold;         // HELLO: the match's rope threshold
+} FeedMessage;
+
+typedef struct {
+    uint32_t index;                  // ROSTER_INDEX of the player
+    uint32_t state;
+    int32_t  position;
+    float    energy;
+    float    effort;
+} PlayerDelta;
+
+// ----------------------------------------------------------
+// Referee side
+// ----------------------------------------------------------
+typedef struct {
+    int fd;                          // -1 when free
+    int keyframes_only;
+} SpectatorViewer;
+
+typedef struct {
+    int listen_fd;                   // -1 when the feed is off
+    const char *path;
+    SharedState *ss;
+    float rope_threshold;
+    SpectatorViewer viewers[SPECTATOR_MAX_VIEWERS];
+    int num_viewers;
+
+    // The drawn fields as of the last publish deltas were built for
+    void    *last_block;
+    Roster   last;
+    int      last_valid;
+    uint32_t last_publish;
+    char    *msg;                    // The delta being built
+
+    uint64_t viewers_total;
+    uint64_t viewers_dropped;        // Dropped to keyframe-only
+    uint64_t deltas, delta_bytes, keyframes;
+    uint64_t publishes;
+    int64_t  cost_ns, max_cost_ns;   // Time spent in spectator_feed_publish()
+} SpectatorFeed;
+
+// Listen for viewers on path. The SharedState must come from
+// shared_state_create() with a memfd. Returns 0 on success.
+int  spectator_feed_open(SpectatorFeed *f, const char *path, SharedState *ss, float rope_threshold);
+
+// The listening socket became readable: take the waiting viewers
+void spectator_feed_accept(SpectatorFeed *f);
+
+// After shared_state_end_write(): send the publish snap to the viewers
+void spectator_feed_publish(SpectatorFeed *f, const StateSnapshot *snap);
+
+void spectator_feed_print(const SpectatorFeed *f);
+void spectator_feed_close(SpectatorFeed *f);
+
+// ----------------------------------------------------------
+// Viewer side
+// ----------------------------------------------------------
+typedef struct {
+    int fd;
+    SharedState *ss;                 // The referee's state, mapped read-only
+    float rope_threshold;
+    char *buf;                       // One message
+    uint32_t have;                   // Publish the viewer's frame is at
+    int keyframes_only;
+    int hung_up;                     // The referee closed the feed
+
+    uint64_t deltas, keyframes, gaps;
+} SpectatorClient;
+
+// Connect to a feed and map the referee's state. Returns 0 on success.
+int  spectator_connect(SpectatorClient *c, const char *path);
+
+// Bring frame (snapshot_size bytes) up to date with what has arrived;
+// never blocks. Returns the messages taken, or -1 once the referee has
+// hung up and nothing is left.
+int  spectator_poll(SpectatorClient *c, StateSnapshot *frame);
+
+void spectator_disconnect(SpectatorClient *c);
+
+// Follow a match in the terminal: one line per game second until the
+// match ends. Returns 0 if the end of the match was seen.
+int  spectate_text(const char *path);
+
+#endif /* SPECTATOR_H */
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats_printer.h"
+
+// Players' status as the old table showed it
+static const char *status_name(uint8_t st) {
+    if (st & PLAYER_RECOVERING)
+        return "Recovering";
+    return (st & PLAYER_ACTIVE) ? "Active" : "Inactive";
+}
+
+// Format a stats table of the latest publish into f
+static void format_table(StatsPrinter *sp, FILE *f, StateSnapshot *snap, MatchStats *ms) {
+    const SharedState *ss = sp->ss;
+    int n = ss->players_per_team;
+    shared_state_read(ss, snap);
+    match_stats_read(shared_state_stats(ss), ms, sp->max_rows);
+    Roster r;
+    snapshot_roster(ss, snap, &r);
+
+    fprintf(f, "\n=== Game Stats at %d seconds (Round %d) ===\n", (int)snap->game_seconds,
+            snap->round_number);
+    fprintf(f, "Rope Position: %.2f/%.2f\n", snap->rope_position, sp->cfg->rope_threshold);
+    fprintf(f, "Scores: Team 1: %d, Team 2: %d\n", snap->team_round_wins[0], snap->team_round_wins[1]);
+    WinEstimate odds;
+    shared_state_read_estimate(ss, &odds);
+    if (odds.rollouts > 0)
+        fprintf(f, "Win odds at %.1f s: Team 1 %.1f%% (95%% %.1f-%.1f%%), Team 2 %.1f%%, tie %.1f%% (%u rollouts)\n",
+                odds.game_seconds, 100.0f * odds.p_win[0], 100.0f * odds.ci_low,
+                100.0f * odds.ci_high, 100.0f * odds.p_win[1], 100.0f * odds.p_tie, odds.rollouts);
+    for (int t = 0; t < ss->num_teams; t++) {
+        fprintf(f, "\nTeam %d Players:\n", t + 1);
+        fprintf(f, "ID  | Energy | Effort | Status     | Position | Mean Eff | SD Eff | Falls | Down s\n");
+        fprintf(f, "----|--------|--------|------------|----------|----------|--------|-------|-------\n");
+        for (int p = 0; p < n && p < sp->max_rows; p++) {
+            int i = ROSTER_INDEX(&r, t, p);
+            const PlayerStats *ps = &ms->player[t * n + p];
+            fprintf(f, "%2d  | %6.1f | %6.1f | %-10s | %8d | %8.1f | %6.1f | %5u | %6.1f\n",
+                    p + 1, r.energy[i], r.effort[i], status_name(r.state[i]), r.position[i],
+                    ps->mean, match_stats_sd(ps->samples, ps->m2), ps->falls,
+                    (double)ps->recovering_ticks / TICKS_PER_SECOND);
+        }
+        if (n > sp->max_rows)
+            fprintf(f, "... %d more players\n", n - sp->max_rows);
+        const TeamStats *ts = &ms->team[t];
+        fprintf(f, "Total Team Effort: %.2f (per tick mean %.2f, sd %.2f; player effort p50 %.1f, p90 %.1f, p99 %.1f)\n",
+                snap->team_efforts[t], ts->total_mean, match_stats_sd(ts->ticks, ts->total_m2),
+                match_stats_quantile(ts, 0.5), match_stats_quantile(ts, 0.9),
+                match_stats_quantile(ts, 0.99));
+    }
+    fprintf(f, "\n");
+}
+
+// Format into memory, then hand stdout the whole table at once
+static void print_table(StatsPrinter *sp, StateSnapshot *snap, MatchStats *ms) {
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *f = open_memstream(&buf, &len);
+    if (!f)
+        return;
+    format_table(sp, f, snap, ms);
+    fclose(f);
+    fwrite(buf, 1, len, stdout);
+    fflush(stdout);
+    free(buf);
+}
+
+// End of the match: every team's totals, from all of its players
+static void print_summary(const MatchStats *ms) {
+    printf("\n=== MATCH STATS ===\n");
+    printf("Ticks played: %llu (%.1f s of game time)\n", (unsigned long long)ms->ticks,
+           ms->game_seconds);
+    for (int t = 0; t < ms->num_teams; t++) {
+        const TeamStats *ts = &ms->team[t];
+        double mean, sd;
+        match_stats_team_effort(ms, t, &mean, &sd);
+        printf("Team %d: team effort %.2f +/- %.2f per tick; player effort %.2f +/- %.2f, "
+               "p50 %.1f, p90 %.1f, p99 %.1f; %llu falls, %.1f s spent recovering\n",
+               t + 1, ts->total_mean, match_stats_sd(ts->ticks, ts->total_m2), mean, sd,
+               match_stats_quantile(ts, 0.5), match_stats_quantile(ts, 0.9),
+               match_stats_quantile(ts, 0.99), (unsigned long long)ts->falls,
+               (double)ts->recovering_ticks / TICKS_PER_SECOND);
+    }
+}
+
+// The referee is done: the block holds the whole match
+static void finish(StatsPrinter *sp) {
+    const MatchStats *ms = shared_state_stats(sp->ss);
+    print_summary(ms);
+    if (sp->export_path && match_stats_export(ms, sp->export_path) == 0)
+        printf("Match stats written to %s\n", sp->export_path);
+    fflush(stdout);
+}
+
+// Buffers sized for the shared block's shape
+static int alloc_buffers(const SharedState *ss, StateSnapshot **snap, MatchStats **ms) {
+    *snap = shared_state_alloc_snapshot(ss);
+    *ms = calloc(1, match_stats_size(ss->num_teams, ss->players_per_team));
+    if (!*snap || !*ms) {
+        free(*snap);
+        free(*ms);
+        return -1;
+    }
+    return 0;
+}
+
+static void *printer_thread(void *arg) {
+    StatsPrinter *sp = arg;
+    StateSnapshot *snap = NULL;
+    MatchStats *ms = NULL;
+    int have_buffers = alloc_buffers(sp->ss, &snap, &ms) == 0;   // Tables need them
+
+    pthread_mutex_lock(&sp->lock);
+    for (;;) {
+        while (!sp->closed && sp->printed == sp->requested) {
+            pthread_cond_wait(&sp->wake, &sp->lock);
+        }
+        if (sp->printed == sp->requested)
+            break;
+        // Tables that piled up show the same state; print one
+        sp->printed = sp->requested;
+        pthread_mutex_unlock(&sp->lock);
+        if (have_buffers)
+            print_table(sp, snap, ms);
+        pthread_mutex_lock(&sp->lock);
+    }
+    pthread_mutex_unlock(&sp->lock);
+
+    if (have_buffers) {
+        free(snap);
+        free(ms);
+    }
+    finish(sp);
+    return NULL;
+}
+
+int stats_printer_start(StatsPrinter *sp, SharedState *ss, const GameConfig *cfg,
+                        int max_rows, const char *export_path) {
+    memset(sp, 0, sizeof(*sp));
+    sp->ss = ss;
+    sp->cfg = cfg;
+    sp->max_rows = max_rows;
+    sp->export_path = export_path;
+    pthread_mutex_init(&sp->lock, NULL);
+    pthread_cond_init(&sp->wake, NULL);
+    if (pthread_create(&sp->thread, NULL, printer_thread, sp) != 0) {
+        fprintf(stderr, "Stats printer: no thread, the referee prints the tables\n");
+        return -1;
+    }
+    sp->running = 1;
+    return 0;
+}
+
+void stats_printer_post(StatsPrinter *sp) {
+    if (!sp->ss)
+        return;
+    if (!sp->running) {
+        StateSnapshot *snap;
+        MatchStats *ms;
+        if (alloc_buffers(sp->ss, &snap, &ms) == 0) {
+            print_table(sp, snap, ms);
+            free(snap);
+            free(ms);
+        }
+        return;
+    }
+    if (pthread_mutex_trylock(&sp->lock) != 0) {
+        sp->posts_skipped++;
+        return;
+    }
+    sp->requested++;
+    pthread_cond_signal(&sp->wake);
+    pthread_mutex_unlock(&sp->lock);
+}
+
+void stats_printer_stop(StatsPrinter *sp) {
+    if (!sp->ss)
+        return;
+    if (sp->running) {
+        // The thread prints the summary on its way out
+        pthread_mutex_lock(&sp->lock);
+        sp->closed = 1;
+        pthread_cond_signal(&sp->wake);
+        pthread_mutex_unlock(&sp->lock);
+        pthread_join(sp->thread, NULL);
+        sp->running = 0;
+    } else {
+        finish(sp);
+    }
+
+    pthread_mutex_destroy(&sp->lock);
+    pthread_cond_destroy(&sp->wake);
+    sp->ss = NULL;
+}
@@ -0,0 +1,49 @@
+#ifndef STATS_PRINTER_H
+#define STATS_PRINTER_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "config.h"
+#include "shared_state.h"
+
+// ----------------------------------------------------------
+// Stats printer
+//  The periodic stats table and the end-of-match statistics
+//  are formatted on a thread of their own from what the
+//  referee publishes (the latest snapshot, the streaming
+//  statistics and the win estimate), so the referee only
+//  posts a request. A table goes to stdout with one write,
+//  whole, between the referee's own lines.
+//
+//  At stop the printer prints the match statistics and, if
+//  asked, exports them (match_stats_export()).
+// ----------------------------------------------------------
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;               // Table requested or closing
+    pthread_t thread;
+    int       running;                  // Thread started
+    int       closed;
+    uint32_t  requested;                // Tables asked for
+    uint32_t  printed;                  // ... and printed
+    uint64_t  posts_skipped;            // Lock busy when the referee came by
+
+    SharedState *ss;
+    const GameConfig *cfg;
+    int         max_rows;               // Players listed per team
+    const char *export_path;            // NULL for no export
+} StatsPrinter;
+
+// Start the printer thread. Without it the tables are printed by the
+// caller of stats_printer_post(). Returns 0 if the thread runs.
+int  stats_printer_start(StatsPrinter *sp, SharedState *ss, const GameConfig *cfg,
+                         int max_rows, const char *export_path);
+
+// Referee side: ask for a stats table. Never blocks.
+void stats_printer_post(StatsPrinter *sp);
+
+// Print the match statistics, export them and stop the thread
+void stats_printer_stop(StatsPrinter *sp);
+
+#endif /* STATS_PRINTER_H */
@@ -0,0 +1,653 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>     // For sysconf
+#include <pthread.h>
+#include <time.h>
+
+#include "engine.h"
+#include "batch.h"      // batch_match_seed
+#include "sweep.h"
+
+// Matches handed to a worker at a time
+#define SWEEP_CHUNK 64
+#define SWEEP_MAX_POINTS 1000000
+
+// --------------------------------------------------------------------
+// Swept parameters
+// --------------------------------------------------------------------
+enum {
+    P_FALL_PROBABILITY = 0,
+    P_FALL_RECOVERY_MIN,
+    P_FALL_RECOVERY_MAX,
+    P_MINIMUM_ENERGY,
+    P_RANGE,
+    P_ROUND_WIN_THRESHOLD,
+    SWEEP_PARAMS
+};
+
+static const char *param_names[SWEEP_PARAMS] = {
+    "fall_probability", "fall_recovery_min", "fall_recovery_max",
+    "minimum_energy", "range", "round_win_threshold"
+};
+
+static double get_param(const GameConfig *c, int k) {
+    switch (k) {
+    case P_FALL_PROBABILITY:    return c->fall_probability;
+    case P_FALL_RECOVERY_MIN:   return c->fall_recovery_min;
+    case P_FALL_RECOVERY_MAX:   return c->fall_recovery_max;
+    case P_MINIMUM_ENERGY:      return c->minimum_energy;
+    case P_RANGE:               return c->range;
+    default:                    return c->round_win_threshold;
+    }
+}
+
+static void set_param(GameConfig *c, int k, double v) {
+    switch (k) {
+    case P_FALL_PROBABILITY:    c->fall_probability = (float)v; break;
+    case P_FALL_RECOVERY_MIN:   c->fall_recovery_min = (int)lround(v); break;
+    case P_FALL_RECOVERY_MAX:   c->fall_recovery_max = (int)lround(v); break;
+    case P_MINIMUM_ENERGY:      c->minimum_energy = (int)lround(v); break;
+    case P_RANGE:               c->range = (int)lround(v); break;
+    default:                    c->round_win_threshold = v; break;
+    }
+}
+
+typedef struct {
+    double lo, hi;
+    int    steps;                   // Grid values, 0 = the spec's default
+} SweepRange;
+
+typedef struct {
+    int    lhs;                     // Latin hypercube instead of a grid
+    int    steps;
+    int    points;
+    int    matches;
+    unsigned int seed;
+    char   cache_path[256];
+    SweepRange range[SWEEP_PARAMS];
+} SweepSpec;
+
+// Same key=value format as config.txt
+static int read_spec(const char *path, SweepSpec *spec) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror("Error opening sweep spec");
+        return -1;
+    }
+    memset(spec, 0, sizeof(*spec));
+    spec->steps   = 3;
+    spec->points  = 20;
+    spec->matches = 100;
+    spec->seed    = 1;
+    strcpy(spec->cache_path, "sweep_cache.bin");
+    for (int k = 0; k < SWEEP_PARAMS; k++) {
+        spec->range[k].lo = spec->range[k].hi = get_param(&config, k);
+        spec->range[k].steps = 1;
+    }
+
+    char line[256];
+    int ok = 1;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        char key[64], value[192];
+        if (sscanf(line, "%63[^=]=%191s", key, value) != 2)
+            continue;
+        if (strcmp(key, "sampling") == 0) {
+            if (strcmp(value, "lhs") == 0)
+                spec->lhs = 1;
+            else if (strcmp(value, "grid") != 0)
+                ok = 0;
+        } else if (strcmp(key, "steps") == 0) {
+            spec->steps = atoi(value);
+        } else if (strcmp(key, "points") == 0) {
+            spec->points = atoi(value);
+        } else if (strcmp(key, "matches") == 0) {
+            spec->matches = atoi(value);
+        } else if (strcmp(key, "seed") == 0) {
+            spec->seed = (unsigned int)strtoul(value, NULL, 10);
+        } else if (strcmp(key, "cache") == 0) {
+            snprintf(spec->cache_path, sizeof(spec->cache_path), "%s", value);
+        } else {
+            int k = 0;
+            while (k < SWEEP_PARAMS && strcmp(key, param_names[k]) != 0)
+                k++;
+            if (k == SWEEP_PARAMS) {
+                fprintf(stderr, "%s: unknown key %s\n", path, key);
+                ok = 0;
+                continue;
+            }
+            // min:max[:steps], or a single value
+            SweepRange *r = &spec->range[k];
+            int n = sscanf(value, "%lf:%lf:%d", &r->lo, &r->hi, &r->steps);
+            if (n == 1) {
+                r->hi = r->lo;
+                r->steps = 1;
+            } else if (n == 2) {
+                r->steps = 0;
+            } else if (n != 3 || r->steps < 1) {
+                ok = 0;
+            }
+        }
+    }
+    fclose(file);
+
+    if (!ok || spec->steps < 1 || spec->points < 1 || spec->matches < 1) {
+        fprintf(stderr, "Invalid sweep spec in %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Points
+// --------------------------------------------------------------------
+
+static int integer_param(int k) {
+    return k != P_FALL_PROBABILITY && k != P_ROUND_WIN_THRESHOLD;
+}
+
+// Every combination of the ranges' values. An integer range runs between
+// its rounded ends with at most one value per integer, so no two points
+// are the same configuration
+static GameConfig *grid_points(const SweepSpec *spec, int *count) {
+    int steps[SWEEP_PARAMS];
+    double lo[SWEEP_PARAMS], hi[SWEEP_PARAMS];
+    long total = 1;
+    for (int k = 0; k < SWEEP_PARAMS; k++) {
+        const SweepRange *r = &spec->range[k];
+        lo[k] = integer_param(k) ? (double)lround(r->lo) : r->lo;
+        hi[k] = integer_param(k) ? (double)lround(r->hi) : r->hi;
+        steps[k] = lo[k] == hi[k] ? 1 : (r->steps > 0 ? r->steps : spec->steps);
+        if (integer_param(k) && steps[k] > fabs(hi[k] - lo[k]) + 1)
+            steps[k] = (int)fabs(hi[k] - lo[k]) + 1;
+        total *= steps[k];
+        if (total > SWEEP_MAX_POINTS) {
+            fprintf(stderr, "Sweep grid has more than %d points\n", SWEEP_MAX_POINTS);
+            return NULL;
+        }
+    }
+
+    GameConfig *points = malloc(total * sizeof(GameConfig));
+    if (!points) {
+        perror("malloc failed");
+        return NULL;
+    }
+    for (long i = 0; i < total; i++) {
+        points[i] = config;
+        long rest = i;
+        for (int k = SWEEP_PARAMS - 1; k >= 0; k--) {
+            int s = (int)(rest % steps[k]);
+            rest /= steps[k];
+            double v = steps[k] == 1 ? lo[k] : lo[k] + (hi[k] - lo[k]) * s / (steps[k] - 1);
+            set_param(&points[i], k, v);
+        }
+    }
+    *count = (int)total;
+    return points;
+}
+
+// Every range is cut into 'points' strata and each stratum is used by
+// exactly one point, in a random order per parameter
+static GameConfig *lhs_points(const SweepSpec *spec, int *count) {
+    int n = spec->points;
+    if (n > SWEEP_MAX_POINTS) {
+        fprintf(stderr, "Sweep has more than %d points\n", SWEEP_MAX_POINTS);
+        return NULL;
+    }
+    GameConfig *points = malloc(n * sizeof(GameConfig));
+    int *strata = malloc(n * sizeof(int));
+    if (!points || !strata) {
+        perror("malloc failed");
+        free(points);
+        free(strata);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        points[i] = config;
+    }
+
+    unsigned int rng = spec->seed;
+    for (int k = 0; k < SWEEP_PARAMS; k++) {
+        const SweepRange *r = &spec->range[k];
+        for (int i = 0; i < n; i++) {
+            strata[i] = i;
+        }
+        for (int i = n - 1; i > 0; i--) {
+            int j = rand_r(&rng) % (i + 1);
+            int swap = strata[i]; strata[i] = strata[j]; strata[j] = swap;
+        }
+        for (int i = 0; i < n; i++) {
+            double u = (strata[i] + rand_r(&rng) / ((double)RAND_MAX + 1.0)) / n;
+            set_param(&points[i], k, r->lo + (r->hi - r->lo) * u);
+        }
+    }
+    free(strata);
+    *count = n;
+    return points;
+}
+
+static int playable(const GameConfig *c) {
+    return c->range >= 1 && c->fall_recovery_min >= 0 &&
+           c->fall_recovery_max >= c->fall_recovery_min;
+}
+
+// --------------------------------------------------------------------
+// Cache
+// --------------------------------------------------------------------
+
+// FNV-1a over every field by value, so padding never matters
+static uint64_t fnv(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+uint64_t sweep_key(const GameConfig *cfg, unsigned int seed) {
+    int32_t ints[] = {
+        cfg->num_teams, cfg->players_per_team, cfg->game_duration,
+        cfg->energy_report_interval, cfg->fall_recovery_min, cfg->fall_recovery_max,
+        cfg->total_rounds, cfg->consecutive_rounds_to_win, cfg->minimum_energy,
+        cfg->range, (int32_t)seed
+    };
+    double reals[] = { cfg->rope_threshold, cfg->round_win_threshold };
+    float probability = cfg->fall_probability;
+
+    uint64_t h = 14695981039346656037ull;
+    h = fnv(h, ints, sizeof(ints));
+    h = fnv(h, reals, sizeof(reals));
+    h = fnv(h, &probability, sizeof(probability));
+    return h ? h : 1;           // 0 marks a free table slot
+}
+
+typedef struct {
+    SweepEntry *entries;        // Cached first, then the ones to play
+    int      count;
+    int      capacity;
+    int32_t *table;             // Open addressing: entry index + 1, 0 = free
+    uint32_t mask;
+    FILE    *file;              // Appended to as matches finish
+} SweepCache;
+
+static int cache_find(const SweepCache *c, uint64_t key) {
+    for (uint32_t i = (uint32_t)key & c->mask; c->table[i]; i = (i + 1) & c->mask) {
+        if (c->entries[c->table[i] - 1].key == key)
+            return c->table[i] - 1;
+    }
+    return -1;
+}
+
+static int cache_reserve(SweepCache *c, int count) {
+    if (count > c->capacity) {
+        int cap = c->capacity ? c->capacity : 1024;
+        while (cap < count)
+            cap *= 2;
+        SweepEntry *e = realloc(c->entries, cap * sizeof(SweepEntry));
+        if (!e)
+            return -1;
+        c->entries = e;
+        c->capacity = cap;
+    }
+
+    // Keep the table at most half full
+    if ((uint32_t)count * 2 > c->mask + 1 || !c->table) {
+        uint32_t size = 2048;
+        while (size < (uint32_t)count * 2)
+            size *= 2;
+        int32_t *table = calloc(size, sizeof(int32_t));
+        if (!table)
+            return -1;
+        free(c->table);
+        c->table = table;
+        c->mask = size - 1;
+        for (int n = 0; n < c->count; n++) {
+            uint32_t i = (uint32_t)c->entries[n].key & c->mask;
+            while (c->table[i])
+                i = (i + 1) & c->mask;
+            c->table[i] = n + 1;
+        }
+    }
+    return 0;
+}
+
+// Returns the index of a new entry for key (not played yet)
+static int cache_add(SweepCache *c, uint64_t key) {
+    if (cache_reserve(c, c->count + 1) != 0)
+        return -1;
+    int n = c->count++;
+    memset(&c->entries[n], 0, sizeof(SweepEntry));
+    c->entries[n].key = key;
+    uint32_t i = (uint32_t)key & c->mask;
+    while (c->table[i])
+        i = (i + 1) & c->mask;
+    c->table[i] = n + 1;
+    return n;
+}
+
+// Load what earlier sweeps played and open the file for appending
+static int cache_open(SweepCache *c, const char *path) {
+    memset(c, 0, sizeof(*c));
+    if (cache_reserve(c, 0) != 0)
+        return -1;
+
+    SweepCacheHeader hdr;
+    FILE *in = fopen(path, "rb");
+    if (in) {
+        if (fread(&hdr, sizeof(hdr), 1, in) != 1 ||
+            memcmp(hdr.magic, SWEEP_CACHE_MAGIC, sizeof(hdr.magic)) != 0 ||
+            hdr.version != SWEEP_CACHE_VERSION || hdr.entry_size != sizeof(SweepEntry)) {
+            fprintf(stderr, "%s is not a sweep cache of this version\n", path);
+            fclose(in);
+            return -1;
+        }
+        SweepEntry e;
+        while (fread(&e, sizeof(e), 1, in) == 1) {
+            if (cache_find(c, e.key) >= 0)
+                continue;
+            int n = cache_add(c, e.key);
+            if (n < 0) {
+                fclose(in);
+                return -1;
+            }
+            c->entries[n] = e;
+        }
+        fclose(in);
+    }
+
+    c->file = fopen(path, in ? "ab" : "wb");
+    if (!c->file) {
+        perror("Error opening sweep cache");
+        return -1;
+    }
+    if (!in) {
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, SWEEP_CACHE_MAGIC, sizeof(hdr.magic));
+        hdr.version = SWEEP_CACHE_VERSION;
+        hdr.entry_size = sizeof(SweepEntry);
+        fwrite(&hdr, sizeof(hdr), 1, c->file);
+    }
+    return 0;
+}
+
+static void cache_close(SweepCache *c) {
+    if (c->file && fclose(c->file) != 0)
+        perror("Error writing sweep cache");
+    free(c->entries);
+    free(c->table);
+}
+
+// --------------------------------------------------------------------
+// Playing
+// --------------------------------------------------------------------
+typedef struct {
+    int point;
+    unsigned int seed;
+    int entry;                  // Cache entry the result goes to
+} SweepJob;
+
+typedef struct {
+    pthread_mutex_t lock;
+    const GameConfig *points;
+    SweepCache *cache;
+    SweepJob *jobs;
+    int num_jobs;
+    int next_job;               // Next job nobody has claimed yet
+    int done;
+    int next_report;
+} SweepRun;
+
+// Times every decided round of a match
+typedef struct {
+    SweepEntry *e;
+    int64_t round_start;        // First tick of the round, -1 between rounds
+} RoundTimer;
+
+static void time_rounds(void *ctx, const Match *m, unsigned events) {
+    RoundTimer *rt = ctx;
+    if ((events & ENGINE_EV_TICK) && rt->round_start < 0)
+        rt->round_start = m->ticks - 1;
+    if ((events & ENGINE_EV_ROUND) && rt->round_start >= 0) {
+        uint32_t len = (uint32_t)(m->ticks - rt->round_start);
+        SweepEntry *e = rt->e;
+        if (e->rounds == 0 || len < e->round_ticks_min)
+            e->round_ticks_min = len;
+        if (len > e->round_ticks_max)
+            e->round_ticks_max = len;
+        e->round_ticks_sum   += len;
+        e->round_ticks_sumsq += (uint64_t)len * len;
+        e->rounds++;
+        rt->round_start = -1;
+    }
+}
+
+// Append finished results to the cache file; called with the lock held
+static void save_results(SweepRun *run, int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        fwrite(&run->cache->entries[run->jobs[i].entry], sizeof(SweepEntry), 1, run->cache->file);
+    }
+    if (count > 0)
+        fflush(run->cache->file);
+    run->done += count;
+    if (count > 0 && run->done >= run->next_report) {
+        printf("[%3d%%] %d/%d matches played\n", (int)(100L * run->done / run->num_jobs),
+               run->done, run->num_jobs);
+        fflush(stdout);
+        while (run->next_report <= run->done)
+            run->next_report += (run->num_jobs + 9) / 10;
+    }
+}
+
+static void *sweep_worker(void *arg) {
+    SweepRun *run = arg;
+    Match m;
+
+    if (engine_init_match(&m, &run->points[run->jobs[0].point], 0, 0) != 0)
+        return (void*)1;
+
+    int first = 0, count = 0;
+    for (;;) {
+        pthread_mutex_lock(&run->lock);
+        save_results(run, first, count);
+        first = run->next_job;
+        count = run->num_jobs - run->next_job;
+        if (count > SWEEP_CHUNK)
+            count = SWEEP_CHUNK;
+        run->next_job += count;
+        pthread_mutex_unlock(&run->lock);
+        if (count == 0)
+            break;
+
+        for (int i = first; i < first + count; i++) {
+            const SweepJob *job = &run->jobs[i];
+            // The rosters only depend on the team sizes, which a sweep keeps
+            m.cfg = &run->points[job->point];
+            engine_reset_match(&m, job->seed, (int)(job->seed % 20));
+
+            RoundTimer rt = { &run->cache->entries[job->entry], -1 };
+            int winner = engine_run_match_observed(&m, time_rounds, &rt);
+            rt.e->winner = (int16_t)winner;
+            rt.e->ticks  = (uint32_t)m.ticks;
+        }
+    }
+
+    engine_free_match(&m);
+    return NULL;
+}
+
+static int play_jobs(SweepRun *run) {
+    long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_workers < 1)
+        num_workers = 1;
+    pthread_t workers[num_workers];
+
+    int started = 0;
+    for (long i = 0; i < num_workers; i++) {
+        if (pthread_create(&workers[i], NULL, sweep_worker, run) != 0)
+            break;
+        started++;
+    }
+    if (started == 0) {
+        // Fall back to playing everything on this thread
+        sweep_worker(run);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < started; i++) {
+        void *ret;
+        pthread_join(workers[i], &ret);
+        if (ret != NULL)
+            failed = 1;
+    }
+    if (failed || run->next_job < run->num_jobs) {
+        fprintf(stderr, "Sweep workers failed to allocate their matches\n");
+        return -1;
+    }
+    printf("Played %d matches on %d thread(s)\n", run->num_jobs, started > 0 ? started : 1);
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Results
+// --------------------------------------------------------------------
+
+// One row per point: parameters, win rates, round and match lengths in
+// game seconds
+static int write_csv(const char *out_path, const SweepSpec *spec, const GameConfig *points,
+                     int num_points, const SweepCache *cache) {
+    FILE *f = fopen(out_path, "w");
+    if (!f) {
+        perror("Error opening sweep CSV");
+        return -1;
+    }
+    fprintf(f, "point");
+    for (int k = 0; k < SWEEP_PARAMS; k++) {
+        fprintf(f, ",%s", param_names[k]);
+    }
+    fprintf(f, ",matches,team1_win_rate,team2_win_rate,tie_rate,rounds_mean,"
+               "round_len_mean,round_len_std,round_len_min,round_len_max,match_len_mean\n");
+
+    for (int p = 0; p < num_points; p++) {
+        const GameConfig *c = &points[p];
+        if (!playable(c))
+            continue;
+        int wins[NUM_TEAMS] = {0, 0}, ties = 0;
+        uint64_t rounds = 0, round_sum = 0, round_sumsq = 0, ticks = 0;
+        uint32_t round_min = UINT32_MAX, round_max = 0;
+        for (int j = 0; j < spec->matches; j++) {
+            int n = cache_find(cache, sweep_key(c, batch_match_seed(spec->seed, (uint32_t)j)));
+            const SweepEntry *e = &cache->entries[n];
+            if (e->winner < 0)
+                ties++;
+            else
+                wins[e->winner]++;
+            ticks += e->ticks;
+            if (e->rounds > 0) {
+                rounds      += e->rounds;
+                round_sum   += e->round_ticks_sum;
+                round_sumsq += e->round_ticks_sumsq;
+                if (e->round_ticks_min < round_min)
+                    round_min = e->round_ticks_min;
+                if (e->round_ticks_max > round_max)
+                    round_max = e->round_ticks_max;
+            }
+        }
+
+        double n = spec->matches, tps = TICKS_PER_SECOND;
+        double mean = rounds ? (double)round_sum / rounds : 0.0;
+        double var = rounds ? (double)round_sumsq / rounds - mean * mean : 0.0;
+        fprintf(f, "%d,%g,%d,%d,%d,%d,%g,%d,%.4f,%.4f,%.4f,%.3f,%.2f,%.2f,%.1f,%.1f,%.2f\n",
+                p, c->fall_probability, c->fall_recovery_min, c->fall_recovery_max,
+                c->minimum_energy, c->range, c->round_win_threshold, spec->matches,
+                wins[0] / n, wins[1] / n, ties / n, rounds / n,
+                mean / tps, var > 0 ? sqrt(var) / tps : 0.0,
+                rounds ? round_min / tps : 0.0, round_max / tps, ticks / n / tps);
+    }
+    if (fclose(f) != 0) {
+        perror("Error writing sweep CSV");
+        return -1;
+    }
+    return 0;
+}
+
+int run_sweep(const char *spec_path, const char *out_path) {
+    SweepSpec spec;
+    if (read_spec(spec_path, &spec) != 0)
+        return -1;
+
+    int num_points = 0;
+    GameConfig *points = spec.lhs ? lhs_points(&spec, &num_points) : grid_points(&spec, &num_points);
+    if (!points)
+        return -1;
+
+    SweepCache cache;
+    if (cache_open(&cache, spec.cache_path) != 0) {
+        cache_close(&cache);
+        free(points);
+        return -1;
+    }
+    int cached = cache.count;
+
+    // Only matches no earlier sweep has played become jobs
+    SweepRun run;
+    memset(&run, 0, sizeof(run));
+    run.points = points;
+    run.cache  = &cache;
+    run.jobs   = malloc((size_t)num_points * spec.matches * sizeof(SweepJob));
+    int skipped = 0, reused = 0, rc = run.jobs ? 0 : -1;
+    for (int p = 0; p < num_points && rc == 0; p++) {
+        if (!playable(&points[p])) {
+            skipped++;
+            continue;
+        }
+        for (int j = 0; j < spec.matches; j++) {
+            unsigned int seed = batch_match_seed(spec.seed, (uint32_t)j);
+            uint64_t key = sweep_key(&points[p], seed);
+            if (cache_find(&cache, key) >= 0) {
+                reused++;
+                continue;
+            }
+            int entry = cache_add(&cache, key);
+            if (entry < 0) {
+                rc = -1;
+                break;
+            }
+            run.jobs[run.num_jobs++] = (SweepJob){ p, seed, entry };
+        }
+    }
+    if (rc != 0)
+        fprintf(stderr, "Not enough memory for the sweep\n");
+
+    printf("=== SWEEP: %d %s points x %d matches ===\n", num_points - skipped,
+           spec.lhs ? "Latin hypercube" : "grid", spec.matches);
+    if (skipped > 0)
+        printf("Skipped %d points that cannot be played\n", skipped);
+    printf("Cache %s: %d results, %d matches reused, %d to play\n",
+           spec.cache_path, cached, reused, run.num_jobs);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (rc == 0 && run.num_jobs > 0) {
+        run.next_report = (run.num_jobs + 9) / 10;
+        pthread_mutex_init(&run.lock, NULL);
+        rc = play_jobs(&run);
+        pthread_mutex_destroy(&run.lock);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (rc == 0) {
+        double secs = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("=== SWEEP COMPLETE in %.3f s ===\n", secs);
+        rc = write_csv(out_path, &spec, points, num_points, &cache);
+        if (rc == 0)
+            printf("Results written to %s\n", out_path);
+    }
+    free(run.jobs);
+    cache_close(&cache);
+    free(points);
+    return rc;
+}
@@ -0,0 +1,70 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ----------------------------------------------------------
+// Parameter sweep
+//  Plays headless matches for many variations of config.txt
+//  and writes one CSV row per variation (a point). The sweep
+//  is described by a spec file of key=value lines:
+//
+//    sampling=grid          grid or lhs (Latin hypercube)
+//    steps=3                grid values per range without its own
+//    points=20              lhs points
+//    matches=200            matches per point
+//    seed=1                 match j of every point uses the same seed
+//    cache=sweep_cache.bin
+//    fall_probability=0.05:0.2:4      min:max[:steps], or one value
+//    minimum_energy=60:100
+//
+//  The integer parameters take at most one grid value per
+//  integer between their rounded ends (range=1:2:3 is 1, 2).
+//
+//  Swept parameters: fall_probability, fall_recovery_min,
+//  fall_recovery_max, minimum_energy, range and
+//  round_win_threshold; everything else comes from config.txt.
+//  Points the game cannot be played with (recovery max below
+//  min, range below 1) are skipped.
+//
+//  Every match result is cached under a hash of the full
+//  GameConfig and the match seed, so running a sweep again
+//  with more points or more matches only plays the new ones.
+//  Results are appended to the cache while the sweep runs.
+//
+// Cache file layout (little-endian, packed):
+//   SweepCacheHeader                      16 bytes
+//   SweepEntry[...]                       40 bytes each, in the order played
+// ----------------------------------------------------------
+
+#define SWEEP_CACHE_MAGIC   "TOWS"
+#define SWEEP_CACHE_VERSION 1
+
+typedef struct {
+    char     magic[4];              // "TOWS"
+    uint32_t version;               // SWEEP_CACHE_VERSION
+    uint32_t entry_size;            // sizeof(SweepEntry)
+    uint32_t reserved;
+} SweepCacheHeader;
+
+typedef struct {
+    uint64_t key;                   // sweep_key(config, seed)
+    int16_t  winner;                // 0 or 1, -1 for a tie
+    uint16_t rounds;                // Rounds decided
+    uint32_t ticks;                 // Match length, countdowns included
+    uint32_t round_ticks_sum;       // Length of the decided rounds, in ticks
+    uint32_t round_ticks_min;
+    uint32_t round_ticks_max;
+    uint32_t reserved;
+    uint64_t round_ticks_sumsq;
+} SweepEntry;
+
+// Cache key of one match: every GameConfig field and the seed
+uint64_t sweep_key(const GameConfig *cfg, unsigned int seed);
+
+// Run the sweep described by spec_path on top of config and write
+// the CSV to out_path. Returns 0 on success, -1 on error.
+int run_sweep(const char *spec_path, const char *out_path);
+
+#endif /* SWEEP_H */
@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"       // TICKS_PER_SECOND, PLAYER_* bits
+#include "tick_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TICK_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// --------------------------------------------------------------------
+// Scalar kernel (reference)
+// --------------------------------------------------------------------
+static float team_tick_scalar(float *energy, float *effort,
+                              const float *decay_rate, const int32_t *position,
+                              const uint8_t *state, int n) {
+    float total = 0.0f;
+    for (int i = 0; i < n; i++) {
+        if (PLAYER_PULLING(state[i])) {
+            float en = energy[i] - decay_rate[i] / (float)TICKS_PER_SECOND;
+            if (en < 0)
+                en = 0;
+            energy[i] = en;
+            effort[i] = en * (float)position[i];
+            total += effort[i];
+        }
+    }
+    return total;
+}
+
+// One call over consecutive team slices; the loop is compiled for the
+// kernel's instruction set so the team kernel inlines into it
+#define TEAMS_TICK(name, team_tick, attr)                                         \
+    attr static void name(float *energy, float *effort,                           \
+                          const float *decay_rate, const int32_t *position,       \
+                          const uint8_t *state, int stride, int teams, float *sums) { \
+        for (int t = 0; t < teams; t++) {                                         \
+            size_t off = (size_t)t * stride;                                      \
+            sums[t] = team_tick(energy + off, effort + off, decay_rate + off,     \
+                                position + off, state + off, stride);             \
+        }                                                                         \
+    }
+
+TEAMS_TICK(teams_tick_scalar, team_tick_scalar, )
+
+#ifdef TICK_KERNELS_X86
+
+// --------------------------------------------------------------------
+// SSE2 kernel: 4 players per step
+// --------------------------------------------------------------------
+__attribute__((target("sse2")))
+static float team_tick_sse2(float *energy, float *effort,
+                            const float *decay_rate, const int32_t *position,
+                            const uint8_t *state, int n) {
+    const __m128 ticks = _mm_set1_ps((float)TICKS_PER_SECOND);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i bits = _mm_set1_epi32(PLAYER_ACTIVE | PLAYER_RECOVERING);
+    const __m128i pulling = _mm_set1_epi32(PLAYER_ACTIVE);
+    __m128 sum = _mm_setzero_ps();
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        // Widen four state bytes to four 32-bit lanes and build the mask
+        int32_t packed;
+        memcpy(&packed, state + i, sizeof(packed));
+        __m128i st = _mm_cvtsi32_si128(packed);
+        st = _mm_unpacklo_epi8(st, _mm_setzero_si128());
+        st = _mm_unpacklo_epi16(st, _mm_setzero_si128());
+        __m128 mask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(st, bits), pulling));
+
+        __m128 en_old = _mm_loadu_ps(energy + i);
+        __m128 ef_old = _mm_loadu_ps(effort + i);
+        __m128 en = _mm_sub_ps(en_old, _mm_div_ps(_mm_loadu_ps(decay_rate + i), ticks));
+        en = _mm_max_ps(en, zero);
+        __m128 ef = _mm_mul_ps(en, _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(position + i))));
+
+        en = _mm_or_ps(_mm_and_ps(mask, en), _mm_andnot_ps(mask, en_old));
+        ef = _mm_or_ps(_mm_and_ps(mask, ef), _mm_andnot_ps(mask, ef_old));
+        _mm_storeu_ps(energy + i, en);
+        _mm_storeu_ps(effort + i, ef);
+        sum = _mm_add_ps(sum, _mm_and_ps(mask, ef));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    float total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    return total + team_tick_scalar(energy + i, effort + i, decay_rate + i,
+                                    position + i, state + i, n - i);
+}
+
+// --------------------------------------------------------------------
+// AVX2 kernel: 8 players per step
+// --------------------------------------------------------------------
+__attribute__((target("avx2")))
+static float team_tick_avx2(float *energy, float *effort,
+                            const float *decay_rate, const int32_t *position,
+                            const uint8_t *state, int n) {
+    const __m256 ticks = _mm256_set1_ps((float)TICKS_PER_SECOND);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i bits = _mm256_set1_epi32(PLAYER_ACTIVE | PLAYER_RECOVERING);
+    const __m256i pulling = _mm256_set1_epi32(PLAYER_ACTIVE);
+    __m256 sum = _mm256_setzero_ps();
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        // Widen eight state bytes to eight 32-bit lanes and build the mask
+        __m256i st = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(state + i)));
+        __m256 mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(st, bits), pulling));
+
+        __m256 en_old = _mm256_loadu_ps(energy + i);
+        __m256 ef_old = _mm256_loadu_ps(effort + i);
+        __m256 en = _mm256_sub_ps(en_old, _mm256_div_ps(_mm256_loadu_ps(decay_rate + i), ticks));
+        en = _mm256_max_ps(en, zero);
+        __m256 ef = _mm256_mul_ps(en, _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(position + i))));
+
+        en = _mm256_blendv_ps(en_old, en, mask);
+        ef = _mm256_blendv_ps(ef_old, ef, mask);
+        _mm256_storeu_ps(energy + i, en);
+        _mm256_storeu_ps(effort + i, ef);
+        sum = _mm256_add_ps(sum, _mm256_and_ps(mask, ef));
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, sum);
+    float total = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+                  ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+
+    // Callers are SSE code; avoid the AVX to SSE transition penalty
+    _mm256_zeroupper();
+    return total + team_tick_scalar(energy + i, effort + i, decay_rate + i,
+                                    position + i, state + i, n - i);
+}
+
+TEAMS_TICK(teams_tick_sse2, team_tick_sse2, __attribute__((target("sse2"))))
+TEAMS_TICK(teams_tick_avx2, team_tick_avx2, __attribute__((target("avx2"))))
+
+#endif /* TICK_KERNELS_X86 */
+
+// --------------------------------------------------------------------
+// Dispatch
+// --------------------------------------------------------------------
+
+// All kernels, scalar first and the fastest last
+static const TickKernel all_kernels[] = {
+    { "scalar", team_tick_scalar, teams_tick_scalar },
+#ifdef TICK_KERNELS_X86
+    { "sse2",   team_tick_sse2,   teams_tick_sse2 },
+    { "avx2",   team_tick_avx2,   teams_tick_avx2 },
+#endif
+};
+#define NUM_KERNELS ((int)(sizeof(all_kernels) / sizeof(all_kernels[0])))
+
+static int kernel_supported(const TickKernel *k) {
+#ifdef TICK_KERNELS_X86
+    __builtin_cpu_init();
+    if (strcmp(k->name, "sse2") == 0)
+        return __builtin_cpu_supports("sse2");
+    if (strcmp(k->name, "avx2") == 0)
+        return __builtin_cpu_supports("avx2");
+#endif
+    return strcmp(k->name, "scalar") == 0;
+}
+
+int tick_kernels_available(const TickKernel **list, int max) {
+    int count = 0;
+    for (int k = 0; k < NUM_KERNELS && count < max; k++) {
+        if (kernel_supported(&all_kernels[k]))
+            list[count++] = &all_kernels[k];
+    }
+    return count;
+}
+
+const TickKernel *tick_kernel_select(void) {
+    const TickKernel *list[NUM_KERNELS];
+    int count = tick_kernels_available(list, NUM_KERNELS);
+
+    const char *wanted = getenv("TOW_KERNEL");
+    if (wanted) {
+        for (int k = 0; k < count; k++) {
+            if (strcmp(list[k]->name, wanted) == 0)
+                return list[k];
+        }
+        fprintf(stderr, "TOW_KERNEL=%s is not available, using %s\n", wanted, list[count - 1]->name);
+    }
+    return list[count - 1];
+}
+
+// --------------------------------------------------------------------
+// Verification against the scalar kernel
+// --------------------------------------------------------------------
+
+#define VERIFY_MAX_PLAYERS 1037   // Odd size so the scalar tails get exercised
+#define VERIFY_TICKS 300
+#define VERIFY_STRIDE ROSTER_LANES   // Team slices for the batched entry
+
+int tick_kernels_verify(void) {
+    const TickKernel *list[NUM_KERNELS];
+    int count = tick_kernels_available(list, NUM_KERNELS);
+    int n = VERIFY_MAX_PLAYERS;
+    int failures = 0;
+
+    float   *ref_energy = malloc(n * sizeof(float)), *ref_effort = malloc(n * sizeof(float));
+    float   *energy = malloc(n * sizeof(float)), *effort = malloc(n * sizeof(float));
+    float   *init_energy = malloc(n * sizeof(float)), *init_effort = malloc(n * sizeof(float));
+    float   *decay = malloc(n * sizeof(float));
+    int32_t *position = malloc(n * sizeof(int32_t));
+    uint8_t *state = malloc(n);
+    if (!ref_energy || !ref_effort || !energy || !effort || !init_energy ||
+        !init_effort || !decay || !position || !state) {
+        fprintf(stderr, "Kernel check: out of memory\n");
+        failures = 1;
+        goto out;
+    }
+
+    // Random roster covering every state combination, with some players
+    // close enough to zero that the clamp kicks in
+    unsigned int seed = 12345;
+    for (int i = 0; i < n; i++) {
+        init_energy[i] = (i % 7 == 0) ? (float)(rand_r(&seed) % 30) / 10.0f
+                                      : 80.0f + (float)(rand_r(&seed) % 4000) / 100.0f;
+        init_effort[i] = (float)(rand_r(&seed) % 500);
+        decay[i]       = 0.5f + (float)(rand_r(&seed) % 16) / 10.0f;
+        position[i]    = 1 + rand_r(&seed) % 4;
+        state[i]       = (uint8_t)(rand_r(&seed) % 4);
+    }
+
+    for (int k = 1; k < count; k++) {
+        const TickKernel *kern = list[k];
+        int ok = 1;
+
+        // Every prefix length up to 40, then a few large ones
+        for (int len = 0; len <= n && ok; len = (len < 40) ? len + 1 : len * 2 + 1) {
+            memcpy(ref_energy, init_energy, len * sizeof(float));
+            memcpy(ref_effort, init_effort, len * sizeof(float));
+            memcpy(energy, init_energy, len * sizeof(float));
+            memcpy(effort, init_effort, len * sizeof(float));
+
+            for (int tick = 0; tick < VERIFY_TICKS && ok; tick++) {
+                float ref_sum = team_tick_scalar(ref_energy, ref_effort, decay, position, state, len);
+                float sum = kern->run(energy, effort, decay, position, state, len);
+
+                if (memcmp(ref_energy, energy, len * sizeof(float)) != 0 ||
+                    memcmp(ref_effort, effort, len * sizeof(float)) != 0) {
+                    printf("%-6s FAIL: player values differ (n=%d, tick %d)\n", kern->name, len, tick);
+                    ok = 0;
+                }
+                float tol = 1e-5f * (ref_sum > 1.0f ? ref_sum : 1.0f);
+                if (ok && (sum - ref_sum > tol || ref_sum - sum > tol)) {
+                    printf("%-6s FAIL: team sum %.6f vs %.6f (n=%d, tick %d)\n",
+                           kern->name, sum, ref_sum, len, tick);
+                    ok = 0;
+                }
+            }
+        }
+        if (ok)
+            printf("%-6s OK: matches scalar\n", kern->name);
+        else
+            failures++;
+    }
+
+    // The batched entry against team-by-team calls of the same kernel
+    int teams = n / VERIFY_STRIDE;
+    for (int k = 0; k < count; k++) {
+        const TickKernel *kern = list[k];
+        int ok = 1;
+        memcpy(ref_energy, init_energy, n * sizeof(float));
+        memcpy(ref_effort, init_effort, n * sizeof(float));
+        memcpy(energy, init_energy, n * sizeof(float));
+        memcpy(effort, init_effort, n * sizeof(float));
+        for (int tick = 0; tick < VERIFY_TICKS && ok; tick++) {
+            float sums[VERIFY_MAX_PLAYERS / VERIFY_STRIDE];
+            kern->run_teams(energy, effort, decay, position, state, VERIFY_STRIDE, teams, sums);
+            for (int t = 0; t < teams && ok; t++) {
+                int off = t * VERIFY_STRIDE;
+                float ref_sum = kern->run(ref_energy + off, ref_effort + off, decay + off,
+                                          position + off, state + off, VERIFY_STRIDE);
+                if (sums[t] != ref_sum) {
+                    printf("%-6s FAIL: batched sum of team %d differs (tick %d)\n", kern->name, t, tick);
+                    ok = 0;
+                }
+            }
+            if (ok && (memcmp(ref_energy, energy, n * sizeof(float)) != 0 ||
+                       memcmp(ref_effort, effort, n * sizeof(float)) != 0)) {
+                printf("%-6s FAIL: batched player values differ (tick %d)\n", kern->name, tick);
+                ok = 0;
+            }
+        }
+        if (ok)
+            printf("%-6s OK: batched teams match single teams\n", kern->name);
+        else
+            failures++;
+    }
+    printf("Kernel in use: %s\n", tick_kernel_select()->name);
+
+out:
+    free(ref_energy); free(ref_effort); free(energy); free(effort);
+    free(init_energy); free(init_effort); free(decay); free(position); free(state);
+    return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,50 @@
+#ifndef TICK_KERNELS_H
+#define TICK_KERNELS_H
+
+#include <stdint.h>
+
+// ----------------------------------------------------------
+// Fused per-tick kernels
+//  One pass over a team slice of the roster that, for every
+//  pulling player (active and not recovering):
+//      energy = max(energy - decay_rate / TICKS_PER_SECOND, 0)
+//      effort = energy * position
+//  and returns the sum of their efforts. Other players are
+//  left untouched and do not count towards the sum.
+//
+//  run_teams does the same over teams consecutive slices of
+//  stride players in one call (the teams of many matches laid
+//  out back to back), writing the sum of slice t to sums[t];
+//  every sum is the one run would return for that slice.
+//
+//  The AVX2 and SSE2 versions give bit-identical energy and
+//  effort to the scalar one; only the team sum may differ in
+//  the last bits because it is added up lane by lane.
+// ----------------------------------------------------------
+
+typedef float (*TeamTickKernel)(float *energy, float *effort,
+                                const float *decay_rate, const int32_t *position,
+                                const uint8_t *state, int n);
+
+typedef void (*TeamsTickKernel)(float *energy, float *effort,
+                                const float *decay_rate, const int32_t *position,
+                                const uint8_t *state, int stride, int teams, float *sums);
+
+typedef struct {
+    const char *name;
+    TeamTickKernel run;
+    TeamsTickKernel run_teams;
+} TickKernel;
+
+// Best kernel for this CPU. The TOW_KERNEL environment variable
+// (scalar, sse2 or avx2) overrides the choice if the CPU supports it.
+const TickKernel *tick_kernel_select(void);
+
+// Kernels this CPU can run, scalar first; returns how many
+int tick_kernels_available(const TickKernel **list, int max);
+
+// Compare every available kernel against the scalar one on random
+// rosters; prints a report and returns 0 if they all agree
+int tick_kernels_verify(void);
+
+#endif /* TICK_KERNELS_H */
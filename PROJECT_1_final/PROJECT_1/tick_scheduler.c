@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tick_scheduler.h"
+
+int tick_policy_parse(TickOverrunPolicy *policy, const char *spec) {
+    if (strcmp(spec, "catchup") == 0)
+        *policy = TICK_CATCH_UP;
+    else if (strcmp(spec, "skip") == 0)
+        *policy = TICK_SKIP;
+    else
+        return -1;
+    return 0;
+}
+
+static int hist_bucket(int64_t ns) {
+    int64_t us = ns / 1000;
+    int b = 0;
+    while (us > 0 && b < TICK_HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void tick_scheduler_start(TickScheduler *s, GameClock *clock, int64_t period_ns,
+                          TickOverrunPolicy policy, TickStats *stats) {
+    s->clock = clock;
+    s->period_ns = period_ns;
+    s->policy = policy;
+    s->stats = stats;
+    memset(stats, 0, sizeof(*stats));
+    tick_scheduler_resync(s);
+}
+
+void tick_scheduler_resync(TickScheduler *s) {
+    s->next_deadline = game_clock_now_ns(s->clock) + s->period_ns;
+    s->work_start = monotonic_ns();
+}
+
+int tick_scheduler_begin_wait(TickScheduler *s) {
+    TickStats *st = s->stats;
+    int dropped = 0;
+
+    // How long the tick's work took
+    int64_t work = monotonic_ns() - s->work_start;
+    st->work_hist[hist_bucket(work)]++;
+    if (work > st->max_work_ns)
+        st->max_work_ns = work;
+
+    int64_t now = game_clock_now_ns(s->clock);
+    if (now > s->next_deadline) {
+        st->overruns++;
+        if (s->policy == TICK_SKIP) {
+            // Move on to the first deadline that is still ahead
+            int64_t missed = (now - s->next_deadline) / s->period_ns + 1;
+            s->next_deadline += missed * s->period_ns;
+            st->skipped += missed;
+            dropped = (int)missed;
+        }
+    }
+    return dropped;
+}
+
+void tick_scheduler_end_wait(TickScheduler *s) {
+    TickStats *st = s->stats;
+
+    // Lateness of this wake-up (0 when catching up means "on schedule")
+    int64_t late = game_clock_now_ns(s->clock) - s->next_deadline;
+    if (late < 0)
+        late = 0;
+    st->late_hist[hist_bucket(late)]++;
+    if (late > st->max_late_ns)
+        st->max_late_ns = late;
+
+    st->ticks++;
+    s->next_deadline += s->period_ns;
+    s->work_start = monotonic_ns();
+}
+
+// Upper bound (us) of the bucket holding the q-quantile
+static long hist_quantile_us(const uint64_t *hist, uint64_t total, double q) {
+    uint64_t target = (uint64_t)(q * (double)total);
+    uint64_t seen = 0;
+    for (int b = 0; b < TICK_HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen > target)
+            return b == 0 ? 1 : 1L << b;
+    }
+    return 1L << (TICK_HIST_BUCKETS - 1);
+}
+
+static void print_hist(const char *title, const uint64_t *hist, uint64_t total, int64_t max_ns) {
+    printf("%s: p50 < %ld us, p99 < %ld us, max %.1f us\n", title,
+           hist_quantile_us(hist, total, 0.50), hist_quantile_us(hist, total, 0.99),
+           max_ns / 1000.0);
+    for (int b = 0; b < TICK_HIST_BUCKETS; b++) {
+        if (hist[b] == 0)
+            continue;
+        long lo = (b == 0) ? 0 : 1L << (b - 1);
+        printf("  [%8ld, %8ld) us: %llu\n", lo, 1L << b, (unsigned long long)hist[b]);
+    }
+}
+
+void tick_stats_print(const TickStats *stats) {
+    printf("\n=== TICK SCHEDULER ===\n");
+    printf("Ticks: %llu, Overruns: %llu, Skipped: %llu\n",
+           (unsigned long long)stats->ticks,
+           (unsigned long long)stats->overruns,
+           (unsigned long long)stats->skipped);
+    print_hist("Tick work", stats->work_hist, stats->ticks, stats->max_work_ns);
+    print_hist("Wake-up lateness", stats->late_hist, stats->ticks, stats->max_late_ns);
+}
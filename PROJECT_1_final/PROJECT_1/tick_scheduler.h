@@ -0,0 +1,71 @@
+#ifndef TICK_SCHEDULER_H
+#define TICK_SCHEDULER_H
+
+#include <stdint.h>
+#include "game_clock.h"
+
+// ----------------------------------------------------------
+// Tick scheduler
+//  Ticks are released on absolute deadlines start + k * period
+//  of the game clock, so the time spent doing a tick's work
+//  does not push the following ticks back.
+//
+//  When the work overruns past the next deadline the policy
+//  decides what happens:
+//   TICK_CATCH_UP  run the late ticks back to back until the
+//                  schedule is met again
+//   TICK_SKIP      drop the missed deadlines and wait for the
+//                  next one still ahead
+// ----------------------------------------------------------
+
+typedef enum {
+    TICK_CATCH_UP = 0,
+    TICK_SKIP
+} TickOverrunPolicy;
+
+// Log2 histogram of microseconds: bucket 0 is < 1 us, bucket b >= 1
+// holds [2^(b-1), 2^b) us and the last bucket everything above
+#define TICK_HIST_BUCKETS 24
+
+// Counters the referee keeps in SharedState for live readers
+typedef struct {
+    uint64_t ticks;                          // Deadlines waited for
+    uint64_t overruns;                       // Deadlines already past when the work was done
+    uint64_t skipped;                        // Deadlines dropped by TICK_SKIP
+    int64_t  max_work_ns;                    // Longest tick work (wall time)
+    int64_t  max_late_ns;                    // Worst wake-up lateness (game time)
+    uint64_t work_hist[TICK_HIST_BUCKETS];   // Tick work duration
+    uint64_t late_hist[TICK_HIST_BUCKETS];   // Wake-up lateness (jitter)
+} TickStats;
+
+typedef struct {
+    GameClock *clock;
+    int64_t period_ns;
+    int64_t next_deadline;                   // Game time of the next tick
+    int64_t work_start;                      // Wall time the current tick started
+    TickOverrunPolicy policy;
+    TickStats *stats;
+} TickScheduler;
+
+// Parse "catchup" or "skip"; returns 0 on success
+int tick_policy_parse(TickOverrunPolicy *policy, const char *spec);
+
+// First deadline is now + period; stats (which may live in shared
+// memory) is cleared
+void tick_scheduler_start(TickScheduler *s, GameClock *clock, int64_t period_ns,
+                          TickOverrunPolicy policy, TickStats *stats);
+
+// Around the wait for the next deadline once a tick's work is done:
+// begin accounts for the work and applies the policy (next_deadline is
+// then the deadline to wait for) and returns the number of deadlines
+// dropped under TICK_SKIP (0 otherwise); end accounts for the wake-up
+int  tick_scheduler_begin_wait(TickScheduler *s);
+void tick_scheduler_end_wait(TickScheduler *s);
+
+// Game time passed without ticks (countdowns): restart the schedule
+void tick_scheduler_resync(TickScheduler *s);
+
+// Print counters and histograms
+void tick_stats_print(const TickStats *stats);
+
+#endif /* TICK_SCHEDULER_H */
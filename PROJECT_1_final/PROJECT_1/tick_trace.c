@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "tick_trace.h"
+#include "game_clock.h"     // monotonic_ns()
+#include "profiler.h"
+
+_Static_assert(sizeof(TraceFileHeader) == 112, "trace file header layout");
+_Static_assert(sizeof(TraceRecord) == 56, "trace record layout");
+
+// Columns follow the TraceRecord in a record
+static void record_layout(TraceFileHeader *h, int n) {
+    uint32_t off = sizeof(TraceRecord);
+    h->energy_offset   = off;  off += n * sizeof(float);
+    h->effort_offset   = off;  off += n * sizeof(float);
+    h->position_offset = off;  off += n * sizeof(int32_t);
+    h->state_offset    = off;  off += n * sizeof(uint8_t);
+    h->record_size     = (off + 7) & ~7u;
+}
+
+// The index follows the header page, the records start on the next page.
+// Ticks stop at game_duration seconds (the closing record may land just
+// after), and a round lasts at least a second.
+static void file_layout(TraceFileHeader *h, int game_duration) {
+    uint32_t off = TRACE_HEADER_SIZE;
+    h->second_count = (uint32_t)game_duration + 2;
+    h->round_count = (uint32_t)game_duration + 2;
+    h->second_index_offset = off;  off += h->second_count * sizeof(uint64_t);
+    h->round_index_offset  = off;  off += h->round_count * sizeof(uint64_t);
+    h->records_offset = (off + TRACE_HEADER_SIZE - 1) & ~(uint32_t)(TRACE_HEADER_SIZE - 1);
+}
+
+// Bytes of the file holding the header, the index and the first
+// 'slots' records
+static size_t used_size(uint32_t records_offset, uint32_t record_size, uint64_t slots) {
+    return records_offset + (size_t)slots * record_size;
+}
+
+// Make room for slot 'slot' and the rest of its extent. The blocks are
+// reserved, so only the tick that starts an extent waits on the file
+// system allocating them. Returns 0 or an errno.
+static int grow_file(TickTrace *t, uint32_t records_offset, uint32_t record_size,
+                     uint64_t capacity, uint64_t slot) {
+    uint64_t slots = (slot / TRACE_EXTENT_RECORDS + 1) * TRACE_EXTENT_RECORDS;
+    if (slots > capacity)
+        slots = capacity;
+    size_t size = used_size(records_offset, record_size, slots);
+    int err = posix_fallocate(t->fd, (off_t)t->file_size, (off_t)(size - t->file_size));
+    if (err == EOPNOTSUPP || err == EINVAL)
+        err = ftruncate(t->fd, (off_t)size) == 0 ? 0 : errno;
+    if (err == 0)
+        t->file_size = size;
+    return err;
+}
+
+// --------------------------------------------------------------------
+// Opening
+// --------------------------------------------------------------------
+int tick_trace_open(TickTrace *t, const char *path, const Match *m,
+                    uint64_t capacity, unsigned int seed) {
+    const Roster *r = &m->roster;
+    memset(t, 0, sizeof(*t));
+    t->fd = -1;
+    t->num_players = r->num_teams * r->players_per_team;
+
+    TraceFileHeader h;
+    memset(&h, 0, sizeof(h));
+    record_layout(&h, t->num_players);
+    file_layout(&h, m->cfg->game_duration > 0 ? m->cfg->game_duration : 0);
+    if (capacity == 0)
+        capacity = 1;
+    t->map_size = h.records_offset + (size_t)capacity * h.record_size;
+
+    t->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (t->fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    // The mapping spans the whole ring; the file behind it is grown an
+    // extent at a time, ahead of the records
+    int err = grow_file(t, h.records_offset, h.record_size, capacity, 0);
+    if (err != 0) {
+        fprintf(stderr, "%s: cannot size the trace: %s\n", path, strerror(err));
+        close(t->fd);
+        t->fd = -1;
+        return -1;
+    }
+
+    void *map = mmap(NULL, t->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, t->fd, 0);
+    t->last_state = calloc(t->num_players, sizeof(uint8_t));
+    t->last_position = calloc(t->num_players, sizeof(int32_t));
+    if (map == MAP_FAILED || !t->last_state || !t->last_position) {
+        perror("Trace mapping failed");
+        if (map != MAP_FAILED)
+            munmap(map, t->map_size);
+        free(t->last_state);
+        free(t->last_position);
+        close(t->fd);
+        t->fd = -1;
+        return -1;
+    }
+    madvise(map, t->map_size, MADV_SEQUENTIAL);
+
+    memcpy(h.magic, TRACE_MAGIC, 4);
+    h.version = TRACE_VERSION;
+    h.capacity = capacity;
+    h.num_teams = r->num_teams;
+    h.players_per_team = r->players_per_team;
+    h.ticks_per_second = TICKS_PER_SECOND;
+    h.seed = seed;
+    h.game_duration = m->cfg->game_duration;
+    h.consecutive_rounds_to_win = m->cfg->consecutive_rounds_to_win;
+    h.rope_threshold = m->cfg->rope_threshold;
+    h.round_win_threshold = m->cfg->round_win_threshold;
+    memcpy(map, &h, sizeof(h));
+    t->header = map;
+    t->second_index = (uint64_t *)((char *)map + h.second_index_offset);
+    t->round_index = (uint64_t *)((char *)map + h.round_index_offset);
+    for (uint32_t s = 0; s < h.second_count; s++) {
+        t->second_index[s] = TRACE_NO_RECORD;
+    }
+    for (uint32_t k = 0; k < h.round_count; k++) {
+        t->round_index[k] = TRACE_NO_RECORD;
+    }
+
+    // Nobody has moved, fallen or got up before the first record
+    for (int team = 0; team < r->num_teams; team++) {
+        for (int p = 0; p < r->players_per_team; p++) {
+            int i = ROSTER_INDEX(r, team, p);
+            int k = team * r->players_per_team + p;
+            t->last_state[k] = r->state[i];
+            t->last_position[k] = r->position[i];
+        }
+    }
+    t->round_winner = -1;
+    t->match_winner = -1;
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Recording
+// --------------------------------------------------------------------
+void tick_trace_event(TickTrace *t, unsigned event, int team) {
+    if (!t->header)
+        return;
+    t->pending_events |= (uint16_t)event;
+    if (event & TRACE_EV_ROUND)
+        t->round_winner = (int8_t)team;
+    if (event & TRACE_EV_MATCH_END)
+        t->match_winner = (int8_t)team;
+}
+
+static void write_record(TickTrace *t, const Match *m, float game_seconds, uint16_t extra) {
+    TraceFileHeader *h = t->header;
+    const Roster *r = &m->roster;
+    uint64_t index = h->count;
+    if (t->failed)
+        return;
+    if (used_size(h->records_offset, h->record_size, index % h->capacity + 1) > t->file_size) {
+        int err = grow_file(t, h->records_offset, h->record_size, h->capacity, index % h->capacity);
+        if (err != 0) {
+            fprintf(stderr, "Tick trace stopped after %llu records: %s\n",
+                    (unsigned long long)index, strerror(err));
+            t->failed = 1;
+            return;
+        }
+    }
+    char *slot = (char *)h + h->records_offset + (index % h->capacity) * h->record_size;
+
+    TraceRecord *rec = (TraceRecord *)slot;
+    rec->index = index;
+    rec->tick = m->ticks;
+    rec->game_seconds = game_seconds;
+    rec->rope_position = m->rope_position;
+    rec->round_number = (uint16_t)m->round_number;
+    for (int team = 0; team < NUM_TEAMS; team++) {
+        rec->team_efforts[team] = m->team_efforts[team];
+        rec->team_round_wins[team] = (uint16_t)m->team_round_wins[team];
+    }
+    rec->events = t->pending_events | extra;
+    rec->round_winner = t->round_winner;
+    rec->match_winner = t->match_winner;
+    rec->reserved = 0;
+
+    // Player columns: the hot ones are straight copies of each team slice,
+    // state and position are compared with the last record for events
+    float   *energy   = (float *)(slot + h->energy_offset);
+    float   *effort   = (float *)(slot + h->effort_offset);
+    int32_t *position = (int32_t *)(slot + h->position_offset);
+    uint8_t *state    = (uint8_t *)(slot + h->state_offset);
+    int n = r->players_per_team;
+    uint32_t falls = 0, recoveries = 0, moves = 0;
+    for (int team = 0; team < r->num_teams; team++) {
+        int src = team * r->stride;
+        int dst = team * n;
+        memcpy(energy + dst, r->energy + src, n * sizeof(float));
+        memcpy(effort + dst, r->effort + src, n * sizeof(float));
+        memcpy(position + dst, r->position + src, n * sizeof(int32_t));
+        for (int p = 0; p < n; p++) {
+            uint8_t st = r->state[src + p];
+            uint8_t was = t->last_state[dst + p];
+            uint8_t bits = st;
+            if ((st ^ was) & PLAYER_RECOVERING) {
+                if (st & PLAYER_RECOVERING) {
+                    bits |= TRACE_PLAYER_FELL;
+                    falls++;
+                } else {
+                    bits |= TRACE_PLAYER_RECOVERED;
+                    recoveries++;
+                }
+            }
+            if (position[dst + p] != t->last_position[dst + p]) {
+                bits |= TRACE_PLAYER_MOVED;
+                moves++;
+                t->last_position[dst + p] = position[dst + p];
+            }
+            state[dst + p] = bits;
+            t->last_state[dst + p] = st;
+        }
+    }
+    rec->falls = falls;
+    rec->recoveries = recoveries;
+    rec->moves = moves;
+
+    // Keyframes: the first record of each second and of each round
+    uint64_t second = (uint64_t)(m->ticks / TICKS_PER_SECOND);
+    if (second < h->second_count && t->second_index[second] == TRACE_NO_RECORD)
+        t->second_index[second] = index;
+    if ((uint32_t)m->round_number < h->round_count && t->round_index[m->round_number] == TRACE_NO_RECORD)
+        t->round_index[m->round_number] = index;
+
+    // Publish the record to anyone reading the file while it grows
+    __atomic_store_n(&h->count, index + 1, __ATOMIC_RELEASE);
+
+    t->pending_events = 0;
+    t->round_winner = -1;
+    t->match_winner = -1;
+}
+
+void tick_trace_record(TickTrace *t, const Match *m, float game_seconds) {
+    if (!t->header)
+        return;
+    PROFILE_DETAIL(PROF_TRACE);
+    uint64_t start = (uint64_t)monotonic_ns();
+    write_record(t, m, game_seconds, 0);
+    uint64_t cost = (uint64_t)monotonic_ns() - start;
+    t->write_ns_total += cost;
+    if (cost > t->write_ns_max)
+        t->write_ns_max = cost;
+}
+
+// --------------------------------------------------------------------
+// Closing
+// --------------------------------------------------------------------
+void tick_trace_close(TickTrace *t, const Match *m, float game_seconds) {
+    if (!t->header)
+        return;
+    TraceFileHeader *h = t->header;
+    uint64_t ticks = h->count;
+
+    // Whatever happened after the last tick (round result, match end)
+    if (t->pending_events)
+        write_record(t, m, game_seconds, TRACE_EV_FINAL);
+    __atomic_store_n(&h->closed, 1, __ATOMIC_RELEASE);
+
+    if (!t->quiet) {
+        printf("\n=== TICK TRACE ===\n");
+        printf("Records: %llu of %u bytes, ring of %llu\n",
+               (unsigned long long)h->count, h->record_size, (unsigned long long)h->capacity);
+        if (ticks > 0)
+            printf("Record cost: mean %.2f us, max %.2f us per tick\n",
+                   t->write_ns_total / 1000.0 / ticks, t->write_ns_max / 1000.0);
+    }
+
+    // Cut the file down to the slots the ring actually used
+    uint64_t used = h->count < h->capacity ? h->count : h->capacity;
+    size_t size = used_size(h->records_offset, h->record_size, used);
+    munmap(h, t->map_size);
+    if (size < t->file_size && ftruncate(t->fd, (off_t)size) != 0)
+        perror("Trace truncate failed");
+    close(t->fd);
+    free(t->last_state);
+    free(t->last_position);
+    memset(t, 0, sizeof(*t));
+    t->fd = -1;
+}
+
+// --------------------------------------------------------------------
+// Reading
+// --------------------------------------------------------------------
+int trace_reader_open(TraceReader *rd, const char *path) {
+    memset(rd, 0, sizeof(*rd));
+    rd->fd = open(path, O_RDONLY);
+    if (rd->fd < 0) {
+        perror(path);
+        return -1;
+    }
+    off_t size = lseek(rd->fd, 0, SEEK_END);
+    if (size < (off_t)sizeof(TraceFileHeader)) {
+        fprintf(stderr, "%s: not a tick trace\n", path);
+        close(rd->fd);
+        return -1;
+    }
+
+    TraceFileHeader h;
+    if (pread(rd->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) {
+        fprintf(stderr, "%s: not a tick trace\n", path);
+        close(rd->fd);
+        return -1;
+    }
+
+    // The sizes must describe this file before anything is dereferenced.
+    // The file holds the records written so far; the mapping covers the
+    // whole ring, so records appended later can be read after a refresh.
+    uint64_t used = h.count < h.capacity ? h.count : h.capacity;
+    if (memcmp(h.magic, TRACE_MAGIC, 4) != 0 || h.version != TRACE_VERSION ||
+        h.record_size < sizeof(TraceRecord) || h.capacity == 0 ||
+        h.capacity > (SIZE_MAX - h.records_offset) / h.record_size ||
+        h.second_index_offset + (uint64_t)h.second_count * sizeof(uint64_t) > h.records_offset ||
+        h.round_index_offset + (uint64_t)h.round_count * sizeof(uint64_t) > h.records_offset ||
+        h.records_offset + used * h.record_size > (uint64_t)size) {
+        fprintf(stderr, "%s: not a version %d tick trace\n", path, TRACE_VERSION);
+        close(rd->fd);
+        return -1;
+    }
+
+    rd->map_size = h.records_offset + (size_t)h.capacity * h.record_size;
+    void *map = mmap(NULL, rd->map_size, PROT_READ, MAP_SHARED, rd->fd, 0);
+    if (map == MAP_FAILED) {
+        perror("Trace mapping failed");
+        close(rd->fd);
+        return -1;
+    }
+    rd->header = map;
+    rd->second_index = (const uint64_t *)((const char *)map + h.second_index_offset);
+    rd->round_index = (const uint64_t *)((const char *)map + h.round_index_offset);
+    trace_reader_refresh(rd);
+    return 0;
+}
+
+void trace_reader_close(TraceReader *rd) {
+    if (rd->header)
+        munmap((void *)rd->header, rd->map_size);
+    if (rd->fd >= 0)
+        close(rd->fd);
+    memset(rd, 0, sizeof(*rd));
+    rd->fd = -1;
+}
+
+void trace_reader_refresh(TraceReader *rd) {
+    rd->count = __atomic_load_n(&rd->header->count, __ATOMIC_ACQUIRE);
+    rd->first = rd->count > rd->header->capacity ? rd->count - rd->header->capacity : 0;
+}
+
+const TraceRecord *trace_reader_record(const TraceReader *rd, uint64_t k) {
+    const TraceFileHeader *h = rd->header;
+    if (k < rd->first || k >= rd->count)
+        return NULL;
+    return (const TraceRecord *)((const char *)h + h->records_offset +
+                                 (k % h->capacity) * h->record_size);
+}
+
+uint64_t trace_reader_at_tick(const TraceReader *rd, int64_t tick) {
+    const TraceFileHeader *h = rd->header;
+    if (rd->count == rd->first)
+        return TRACE_NO_RECORD;
+    const TraceRecord *oldest = trace_reader_record(rd, rd->first);
+    if (tick <= oldest->tick)
+        return rd->first;
+
+    // The keyframe of that second, or of the last second before it with
+    // a record still in the ring (a countdown has none)
+    int64_t s = tick / h->ticks_per_second;
+    if (s >= (int64_t)h->second_count)
+        s = h->second_count - 1;
+    uint64_t k = TRACE_NO_RECORD;
+    for (; s >= 0 && k == TRACE_NO_RECORD; s--) {
+        uint64_t key = rd->second_index[s];
+        if (key != TRACE_NO_RECORD && key >= rd->first && key < rd->count)
+            k = key;
+        else if (key != TRACE_NO_RECORD && key < rd->first)
+            k = rd->first;
+    }
+    if (k == TRACE_NO_RECORD)
+        k = rd->first;
+
+    // At most a second's worth of ticks from the keyframe
+    while (k + 1 < rd->count && trace_reader_record(rd, k + 1)->tick <= tick) {
+        k++;
+    }
+    return k;
+}
+
+uint64_t trace_reader_round_start(const TraceReader *rd, int round) {
+    if (round < 0 || (uint32_t)round >= rd->header->round_count)
+        return TRACE_NO_RECORD;
+    uint64_t k = rd->round_index[round];
+    if (k == TRACE_NO_RECORD || k >= rd->count)
+        return TRACE_NO_RECORD;
+    return k < rd->first ? rd->first : k;
+}
@@ -0,0 +1,181 @@
+#ifndef TICK_TRACE_H
+#define TICK_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"
+
+// ----------------------------------------------------------
+// Binary tick trace
+//  The referee appends one fixed-size record per played tick
+//  to a file it keeps mapped with mmap. The records form a
+//  ring: record k lives in slot k % capacity, so a trace
+//  capped with --trace-ticks keeps the last 'capacity' ticks
+//  of a long match. Every record holds the complete state,
+//  so any record can be decoded on its own, and a keyframe
+//  index maps every game second and round to its first
+//  record: seeking is two lookups whatever the file size.
+//
+// File layout (little-endian):
+//   TraceFileHeader, padded                  TRACE_HEADER_SIZE
+//   uint64_t second_index[second_count]      at second_index_offset
+//   uint64_t round_index[round_count]        at round_index_offset
+//   slot[capacity]                           at records_offset, record_size each
+//
+// second_index[s] is the first record whose tick / ticks_per_second
+// is s, round_index[r] the first record of round r; TRACE_NO_RECORD
+// where there is none (countdowns, rounds never played).
+//
+// Record layout (n = num_teams * players_per_team, players
+// numbered t * players_per_team + p, no padding lanes):
+//   TraceRecord                              56 bytes
+//   float   energy[n]      at energy_offset
+//   float   effort[n]      at effort_offset
+//   int32_t position[n]    at position_offset (1 = furthest from the rope)
+//   uint8_t state[n]       at state_offset, PLAYER_* | TRACE_PLAYER_* bits
+//   zero padding up to record_size (a multiple of 8)
+//
+// Readers: records count - min(count, capacity) .. count - 1
+// are valid, index entries older than that point to records
+// the ring has overwritten. count is stored after the record
+// and the index are complete, so a trace can be read while
+// it is written.
+//
+// The file only holds the slots written so far: it grows by
+// TRACE_EXTENT_RECORDS slots at a time while the ring fills,
+// and is cut to the last slot used when the trace is closed.
+// ----------------------------------------------------------
+
+#define TRACE_MAGIC       "TOWT"
+#define TRACE_VERSION     2
+#define TRACE_HEADER_SIZE 4096
+#define TRACE_NO_RECORD   UINT64_MAX
+#define TRACE_EXTENT_RECORDS (10 * TICKS_PER_SECOND)   // Slots the file grows by at once
+
+// Match events since the previous record (TraceRecord.events)
+#define TRACE_EV_ALIGN     0x0001   // Teams were lined up by energy
+#define TRACE_EV_ROUND     0x0002   // A round was decided, see round_winner
+#define TRACE_EV_MATCH_END 0x0004   // The match was decided, see match_winner
+#define TRACE_EV_FINAL     0x0008   // Closing record, not a played tick
+
+// Player events since the previous record, in the state bytes next to
+// PLAYER_ACTIVE (0x01) and PLAYER_RECOVERING (0x02)
+#define TRACE_PLAYER_FELL      0x10
+#define TRACE_PLAYER_RECOVERED 0x20
+#define TRACE_PLAYER_MOVED     0x40  // Position in the line changed
+
+typedef struct {
+    char     magic[4];                 // "TOWT"
+    uint32_t version;                  // TRACE_VERSION
+    uint32_t records_offset;           // Byte offset of slot 0
+    uint32_t record_size;
+    uint64_t capacity;                 // Slots in the ring
+    uint64_t count;                    // Records written so far
+    uint32_t num_teams;
+    uint32_t players_per_team;
+    uint32_t ticks_per_second;
+    uint32_t energy_offset;            // Column offsets inside a record
+    uint32_t effort_offset;
+    uint32_t position_offset;
+    uint32_t state_offset;
+    uint32_t seed;                     // Match seed
+    uint32_t closed;                   // 1 once the referee finished the trace
+    int32_t  game_duration;            // Rules the match was played with
+    int32_t  consecutive_rounds_to_win;
+    uint32_t reserved;
+    double   rope_threshold;
+    double   round_win_threshold;
+    uint32_t second_index_offset;      // Keyframe index
+    uint32_t second_count;
+    uint32_t round_index_offset;
+    uint32_t round_count;
+} TraceFileHeader;                     // 112 bytes
+
+typedef struct {
+    uint64_t index;                    // Record number, k for slot k % capacity
+    int64_t  tick;                     // Match tick, countdowns included
+    float    game_seconds;             // Game clock when the tick was played
+    float    rope_position;
+    float    team_efforts[NUM_TEAMS];
+    uint16_t round_number;
+    uint16_t team_round_wins[NUM_TEAMS];
+    uint16_t events;                   // TRACE_EV_* bits
+    int8_t   round_winner;             // Team that won the round, else -1
+    int8_t   match_winner;             // Team that won the match, -1 for none or a tie
+    uint16_t reserved;
+    uint32_t falls;                    // Players that went down since the previous record
+    uint32_t recoveries;               // Players that got back up
+    uint32_t moves;                    // Players whose position changed
+} TraceRecord;                         // 56 bytes
+
+// Writer state; a TickTrace that was never opened ignores every call
+typedef struct {
+    int      fd;
+    TraceFileHeader *header;           // Start of the mapping
+    uint64_t *second_index;
+    uint64_t *round_index;
+    size_t   map_size;                 // The whole ring, mapped up front
+    size_t   file_size;                // Allocated so far
+    int      failed;                   // The file could not grow; no more records
+    int      num_players;              // n
+    uint8_t *last_state;               // Player state / position of the last record
+    int32_t *last_position;
+
+    // Events waiting for the next record
+    uint16_t pending_events;
+    int8_t   round_winner;
+    int8_t   match_winner;
+
+    // Cost of writing the records
+    uint64_t write_ns_total;
+    uint64_t write_ns_max;
+    int      quiet;                    // Close without printing the cost (one trace of many)
+} TickTrace;
+
+// Create (or truncate) path and map a ring of 'capacity' records sized for
+// the match's roster. Returns 0 on success.
+int  tick_trace_open(TickTrace *t, const char *path, const Match *m,
+                     uint64_t capacity, unsigned int seed);
+
+// Note a match event (TRACE_EV_*) for the next record; team is the round or
+// match winner where that applies
+void tick_trace_event(TickTrace *t, unsigned event, int team);
+
+// Append the record of the tick the match just played
+void tick_trace_record(TickTrace *t, const Match *m, float game_seconds);
+
+// Flush pending events into a closing record, mark the trace closed,
+// print what the recording cost and unmap it
+void tick_trace_close(TickTrace *t, const Match *m, float game_seconds);
+
+// ----------------------------------------------------------
+// Reading a trace
+//  The file is mapped read-only, so opening is instant and
+//  only the records actually looked at are paged in.
+// ----------------------------------------------------------
+typedef struct {
+    int      fd;
+    const TraceFileHeader *header;
+    size_t   map_size;
+    const uint64_t *second_index;
+    const uint64_t *round_index;
+    uint64_t first;                    // Valid records are [first, count)
+    uint64_t count;
+} TraceReader;
+
+// Map a trace and check its header. Returns 0 on success.
+int  trace_reader_open(TraceReader *rd, const char *path);
+void trace_reader_close(TraceReader *rd);
+
+// Pick up records written since the last call (trace still being written)
+void trace_reader_refresh(TraceReader *rd);
+
+// Record k, or NULL if it is not (or no longer) in the ring
+const TraceRecord *trace_reader_record(const TraceReader *rd, uint64_t k);
+
+// Last record played at or before the given tick, first record of a round;
+// TRACE_NO_RECORD if there is none
+uint64_t trace_reader_at_tick(const TraceReader *rd, int64_t tick);
+uint64_t trace_reader_round_start(const TraceReader *rd, int round);
+
+#endif /* TICK_TRACE_H */
@@ -0,0 +1,154 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "timer_wheel.h"
+
+#define WHEEL_MASK   (WHEEL_SLOTS - 1)
+#define WHEEL_RANGE  ((int64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))
+
+// Values of where[] besides a bucket number (level * WHEEL_SLOTS + slot)
+#define WHERE_IDLE   (-2)    // Not scheduled
+#define WHERE_FIRING (-1)    // In the list of timers being fired right now
+
+int timer_wheel_init(TimerWheel *w, int capacity) {
+    memset(w, 0, sizeof(*w));
+    w->capacity = capacity;
+    w->next   = malloc(capacity * sizeof(int32_t));
+    w->prev   = malloc(capacity * sizeof(int32_t));
+    w->where  = malloc(capacity * sizeof(int32_t));
+    w->expiry = malloc(capacity * sizeof(int64_t));
+    if (!w->next || !w->prev || !w->where || !w->expiry) {
+        timer_wheel_free(w);
+        return -1;
+    }
+    timer_wheel_reset(w, 0);
+    return 0;
+}
+
+void timer_wheel_free(TimerWheel *w) {
+    free(w->next);
+    free(w->prev);
+    free(w->where);
+    free(w->expiry);
+    memset(w, 0, sizeof(*w));
+}
+
+void timer_wheel_reset(TimerWheel *w, int64_t now) {
+    for (int i = 0; i < w->capacity; i++) {
+        w->where[i] = WHERE_IDLE;
+    }
+    for (int l = 0; l < WHEEL_LEVELS; l++) {
+        for (int s = 0; s < WHEEL_SLOTS; s++) {
+            w->head[l][s] = -1;
+        }
+    }
+    w->firing = -1;
+    w->now = now;
+    w->pending = 0;
+}
+
+// Head pointer of the list a bucket number refers to
+static int32_t *list_head(TimerWheel *w, int32_t where) {
+    if (where == WHERE_FIRING)
+        return &w->firing;
+    return &w->head[where / WHEEL_SLOTS][where % WHEEL_SLOTS];
+}
+
+static void push(TimerWheel *w, int id, int32_t where) {
+    int32_t *head = list_head(w, where);
+    w->where[id] = where;
+    w->prev[id] = -1;
+    w->next[id] = *head;
+    if (*head != -1)
+        w->prev[*head] = id;
+    *head = id;
+}
+
+static void unlink_timer(TimerWheel *w, int id) {
+    if (w->prev[id] != -1)
+        w->next[w->prev[id]] = w->next[id];
+    else
+        *list_head(w, w->where[id]) = w->next[id];
+    if (w->next[id] != -1)
+        w->prev[w->next[id]] = w->prev[id];
+    w->where[id] = WHERE_IDLE;
+}
+
+// Put a timer in the bucket matching its distance from now
+static void place(TimerWheel *w, int id) {
+    int64_t expiry = w->expiry[id];
+    if (expiry < w->now)
+        expiry = w->now;
+
+    int64_t delta = expiry - w->now;
+    if (delta >= WHEEL_RANGE) {
+        // Too far out: park it at the end of the top level, it gets
+        // placed again every time that slot cascades
+        expiry = w->now + WHEEL_RANGE - 1;
+        delta = WHEEL_RANGE - 1;
+    }
+
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= ((int64_t)1 << (WHEEL_BITS * (level + 1))))
+        level++;
+    int slot = (int)((expiry >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    push(w, id, level * WHEEL_SLOTS + slot);
+}
+
+void timer_wheel_schedule(TimerWheel *w, int id, int64_t expiry) {
+    if (w->where[id] != WHERE_IDLE)
+        unlink_timer(w, id);
+    else
+        w->pending++;
+    w->expiry[id] = expiry;
+    place(w, id);
+}
+
+// Move every timer of a higher level slot down to where it now belongs
+static void cascade(TimerWheel *w, int level, int slot) {
+    int32_t id = w->head[level][slot];
+    w->head[level][slot] = -1;
+    while (id != -1) {
+        int32_t next = w->next[id];
+        place(w, id);
+        id = next;
+    }
+}
+
+void timer_wheel_advance(TimerWheel *w, int64_t until, TimerFired fire, void *ctx) {
+    while (w->now <= until) {
+        int64_t tick = w->now;
+        int slot = (int)(tick & WHEEL_MASK);
+
+        // At the start of each level-0 lap pull the next slot of level 1
+        // down, and so on up while the upper indexes wrap as well
+        if (slot == 0) {
+            for (int l = 1; l < WHEEL_LEVELS; l++) {
+                int s = (int)((tick >> (WHEEL_BITS * l)) & WHEEL_MASK);
+                cascade(w, l, s);
+                if (s != 0)
+                    break;
+            }
+        }
+
+        // Detach this tick's slot; anything scheduled while firing lands
+        // on a later tick
+        w->firing = w->head[0][slot];
+        w->head[0][slot] = -1;
+        for (int32_t id = w->firing; id != -1; id = w->next[id]) {
+            w->where[id] = WHERE_FIRING;
+        }
+        w->now = tick + 1;
+
+        while (w->firing != -1) {
+            int id = w->firing;
+            unlink_timer(w, id);
+            if (w->expiry[id] <= tick) {
+                w->pending--;
+                fire(ctx, id, w->expiry[id]);
+            } else {
+                place(w, id);   // A parked timer that is not due yet
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// ----------------------------------------------------------
+// Hierarchical timer wheel
+//  Timers are identified by small integers (the roster index
+//  of a player) and expire on integer ticks. Level 0 has one
+//  slot per tick; each higher level covers WHEEL_SLOTS times
+//  the range of the one below and is cascaded down as time
+//  reaches it. Scheduling and cancelling are O(1); advancing
+//  costs O(1) per tick plus O(1) per expired timer.
+//
+//  Nodes are intrusive index links, so the wheel allocates
+//  once for its capacity and never again.
+// ----------------------------------------------------------
+
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1 << WHEEL_BITS)   // 64 slots per level
+#define WHEEL_LEVELS 4                    // 2^24 ticks of range (~19 days at 10 Hz)
+
+typedef struct {
+    int      capacity;
+    int32_t *next;                        // Next timer in the slot, -1 at the end
+    int32_t *prev;                        // Previous timer, -1 at the head
+    int32_t *where;                       // Bucket the timer sits in (see timer_wheel.c)
+    int64_t *expiry;                      // Tick each timer fires on
+    int32_t  head[WHEEL_LEVELS][WHEEL_SLOTS];
+    int32_t  firing;                      // Timers of the tick being processed
+    int64_t  now;                         // Next tick to be processed
+    int      pending;                     // Timers currently scheduled
+} TimerWheel;
+
+// Called for every expired timer; the callback may schedule timers again
+typedef void (*TimerFired)(void *ctx, int id, int64_t expiry);
+
+int  timer_wheel_init(TimerWheel *w, int capacity);
+void timer_wheel_free(TimerWheel *w);
+
+// Drop every timer and restart the clock at tick 'now'
+void timer_wheel_reset(TimerWheel *w, int64_t now);
+
+// Schedule (or move) timer id to fire on tick 'expiry'. Expiries in the
+// past fire on the next tick processed.
+void timer_wheel_schedule(TimerWheel *w, int id, int64_t expiry);
+
+// Process every tick up to and including 'until', firing expired timers
+// in tick order
+void timer_wheel_advance(TimerWheel *w, int64_t until, TimerFired fire, void *ctx);
+
+#endif /* TIMER_WHEEL_H */
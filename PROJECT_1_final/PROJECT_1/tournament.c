@@ -0,0 +1,498 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>     // For sysconf
+#include <pthread.h>
+#include <time.h>
+
+#include "config.h"
+#include "engine.h"
+#include "batch.h"      // batch_match_seed
+#include "tick_trace.h"
+#include "tournament.h"
+
+// Matches handed to a worker at a time, at most
+#define TOURNAMENT_CHUNK 64
+#define TOURNAMENT_MAX_TEAMS 65535
+
+typedef struct {
+    pthread_mutex_t lock;
+    GameConfig match_cfg;            // config with the two teams of one match
+    TournamentFormat format;
+    int num_teams;
+    unsigned int base_seed;
+    const char *trace_dir;
+    TournamentTeam *teams;           // Standings, by team number
+
+    // Matches being played: all of them (round robin) or one bracket round
+    TournamentMatch *phase;
+    int phase_count;
+    int next_match;                  // Next match nobody has claimed yet
+    int chunk;
+
+    // Progress
+    int total_matches;
+    int folded;                      // Matches already in the standings
+    int next_report;
+    int num_workers;
+    int traces_failed;
+} Tournament;
+
+// --------------------------------------------------------------------
+// Standings
+// --------------------------------------------------------------------
+static int compare_league(const TournamentTeam *a, const TournamentTeam *b) {
+    if (a->points != b->points)
+        return a->points > b->points ? -1 : 1;
+    long diff_a = (long)a->rounds_won - a->rounds_lost;
+    long diff_b = (long)b->rounds_won - b->rounds_lost;
+    if (diff_a != diff_b)
+        return diff_a > diff_b ? -1 : 1;
+    if (a->rounds_won != b->rounds_won)
+        return a->rounds_won > b->rounds_won ? -1 : 1;
+    return a->team < b->team ? -1 : (a->team > b->team);
+}
+
+static int compare_bracket(const TournamentTeam *a, const TournamentTeam *b) {
+    if (a->stage_reached != b->stage_reached)
+        return a->stage_reached > b->stage_reached ? -1 : 1;
+    if (a->rounds_won != b->rounds_won)
+        return a->rounds_won > b->rounds_won ? -1 : 1;
+    return a->team < b->team ? -1 : (a->team > b->team);
+}
+
+static int sort_league(const void *a, const void *b)  { return compare_league(a, b); }
+static int sort_bracket(const void *a, const void *b) { return compare_bracket(a, b); }
+
+static int ahead(const Tournament *tn, const TournamentTeam *a, const TournamentTeam *b) {
+    return (tn->format == TOURNAMENT_BRACKET ? compare_bracket(a, b) : compare_league(a, b)) < 0;
+}
+
+// Add finished matches to the standings; called with the lock held
+static void fold_matches(Tournament *tn, int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        const TournamentMatch *tm = &tn->phase[i];
+        for (int side = 0; side < 2; side++) {
+            TournamentTeam *team = &tn->teams[tm->team[side]];
+            team->rounds_won  += tm->rounds_won[side];
+            team->rounds_lost += tm->rounds_won[1 - side];
+            if (tn->format == TOURNAMENT_BRACKET)
+                team->stage_reached = tm->stage;
+            if (tm->winner < 0) {
+                team->ties++;
+                team->points += 1;
+            } else if (tm->winner == side) {
+                team->wins++;
+                team->points += 3;
+            } else {
+                team->losses++;
+            }
+        }
+    }
+    tn->folded += count;
+
+    // The table is current: show who leads every tenth of the way
+    if (count > 0 && tn->folded >= tn->next_report) {
+        const TournamentTeam *lead = &tn->teams[0];
+        for (int t = 1; t < tn->num_teams; t++) {
+            if (ahead(tn, &tn->teams[t], lead))
+                lead = &tn->teams[t];
+        }
+        printf("[%3d%%] %d/%d matches, leader Team %u (%u-%u-%u, ",
+               (int)(100L * tn->folded / tn->total_matches), tn->folded, tn->total_matches,
+               lead->team + 1, lead->wins, lead->losses, lead->ties);
+        if (tn->format == TOURNAMENT_BRACKET)
+            printf("in round %u)\n", lead->stage_reached + 1);
+        else
+            printf("%u pts)\n", lead->points);
+        fflush(stdout);
+        while (tn->next_report <= tn->folded)
+            tn->next_report += (tn->total_matches + 9) / 10;
+    }
+}
+
+// --------------------------------------------------------------------
+// Playing a match
+// --------------------------------------------------------------------
+
+// Feeds engine events into a tick trace
+static void trace_match(void *ctx, const Match *m, unsigned events) {
+    TickTrace *t = ctx;
+    if (events & ENGINE_EV_TICK)
+        tick_trace_record(t, m, (float)m->ticks / (float)TICKS_PER_SECOND);
+    if (events & ENGINE_EV_ALIGN)
+        tick_trace_event(t, TRACE_EV_ALIGN, -1);
+    if (events & ENGINE_EV_ROUND)
+        tick_trace_event(t, TRACE_EV_ROUND, m->round_winner);
+    if (events & ENGINE_EV_MATCH_END)
+        tick_trace_event(t, TRACE_EV_MATCH_END, m->winner);
+}
+
+static void play_game(Tournament *tn, Match *m, TournamentMatch *tm) {
+    int team_bias[NUM_TEAMS];
+    for (int side = 0; side < NUM_TEAMS; side++) {
+        team_bias[side] = tn->teams[tm->team[side]].energy_bias;
+    }
+    engine_reset_match_teams(m, tm->seed, team_bias);
+
+    int winner = -1, traced = 0;
+    if (tn->trace_dir) {
+        // A replayed match keeps the trace of the game that counted
+        TickTrace trace;
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/match_%u.towt", tn->trace_dir, tm->match_id);
+        uint64_t capacity = (uint64_t)m->cfg->game_duration * TICKS_PER_SECOND + 1;
+        if (tick_trace_open(&trace, path, m, capacity, tm->seed) == 0) {
+            trace.quiet = 1;
+            winner = engine_run_match_observed(m, trace_match, &trace);
+            tick_trace_close(&trace, m, (float)m->ticks / (float)TICKS_PER_SECOND);
+            traced = 1;
+        } else {
+            __atomic_add_fetch(&tn->traces_failed, 1, __ATOMIC_RELAXED);
+        }
+    }
+    if (!traced)
+        winner = engine_run_match(m);
+
+    tm->winner        = (int16_t)winner;
+    tm->rounds_won[0] = (uint16_t)m->team_round_wins[0];
+    tm->rounds_won[1] = (uint16_t)m->team_round_wins[1];
+    tm->duration      = (float)m->ticks / (float)TICKS_PER_SECOND;
+}
+
+// A bracket match must have a winner: a tie is played again
+static void play_match(Tournament *tn, Match *m, TournamentMatch *tm) {
+    tm->seed = batch_match_seed(tn->base_seed, tm->match_id);
+    tm->replays = 0;
+    play_game(tn, m, tm);
+    while (tn->format == TOURNAMENT_BRACKET && tm->winner < 0) {
+        if (tm->replays == TOURNAMENT_REPLAYS) {
+            tm->winner = 0;         // Still tied: the team higher in the draw
+            break;
+        }
+        tm->replays++;
+        tm->seed = batch_match_seed(tm->seed, tm->replays);
+        play_game(tn, m, tm);
+    }
+}
+
+// Worker thread: fold the last chunk in, claim the next, play it
+static void *tournament_worker(void *arg) {
+    Tournament *tn = arg;
+    Match m;
+
+    if (engine_init_match(&m, &tn->match_cfg, 0, 0) != 0)
+        return (void*)1;
+
+    int first = 0, count = 0;
+    for (;;) {
+        pthread_mutex_lock(&tn->lock);
+        fold_matches(tn, first, count);
+        first = tn->next_match;
+        count = tn->phase_count - tn->next_match;
+        if (count > tn->chunk)
+            count = tn->chunk;
+        tn->next_match += count;
+        pthread_mutex_unlock(&tn->lock);
+        if (count == 0)
+            break;
+
+        for (int i = first; i < first + count; i++) {
+            play_match(tn, &m, &tn->phase[i]);
+        }
+    }
+
+    engine_free_match(&m);
+    return NULL;
+}
+
+// Play every match of the current phase on the worker pool
+static int run_phase(Tournament *tn) {
+    tn->next_match = 0;
+    tn->chunk = tn->phase_count / (tn->num_workers * 8);
+    if (tn->chunk < 1)
+        tn->chunk = 1;
+    if (tn->chunk > TOURNAMENT_CHUNK)
+        tn->chunk = TOURNAMENT_CHUNK;
+
+    pthread_t workers[tn->num_workers];
+    int started = 0;
+    for (int i = 0; i < tn->num_workers; i++) {
+        if (pthread_create(&workers[i], NULL, tournament_worker, tn) != 0)
+            break;
+        started++;
+    }
+    if (started == 0) {
+        // Fall back to playing everything on this thread
+        tournament_worker(tn);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < started; i++) {
+        void *ret;
+        pthread_join(workers[i], &ret);
+        if (ret != NULL)
+            failed = 1;
+    }
+    if (failed || tn->next_match < tn->phase_count) {
+        fprintf(stderr, "Tournament workers failed to allocate their matches\n");
+        return -1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// Formats
+// --------------------------------------------------------------------
+
+// Circle method: team 0 stays put, the others rotate one place per
+// matchday; with an odd field the dummy team M - 1 means a day off
+static int round_robin(Tournament *tn, TournamentMatch *matches, uint32_t *stages) {
+    int n = tn->num_teams;
+    int slots = n + (n & 1);
+    int *circle = malloc(slots * sizeof(int));
+    if (!circle) {
+        perror("malloc failed");
+        return -1;
+    }
+    for (int i = 0; i < slots; i++) {
+        circle[i] = i;
+    }
+
+    int count = 0;
+    for (int day = 0; day < slots - 1; day++) {
+        for (int i = 0; i < slots / 2; i++) {
+            int a = circle[i], b = circle[slots - 1 - i];
+            if (a >= n || b >= n)
+                continue;
+            // Alternate the ends so nobody always pulls from the same side
+            if ((day + i) & 1) {
+                int swap = a; a = b; b = swap;
+            }
+            TournamentMatch *tm = &matches[count];
+            tm->match_id = (uint32_t)count;
+            tm->stage    = (uint16_t)(day + 1);
+            tm->team[0]  = (uint32_t)a;
+            tm->team[1]  = (uint32_t)b;
+            count++;
+        }
+        int last = circle[slots - 1];
+        memmove(&circle[2], &circle[1], (slots - 2) * sizeof(int));
+        circle[1] = last;
+    }
+    free(circle);
+    *stages = (uint32_t)(slots - 1);
+
+    tn->phase = matches;
+    tn->phase_count = count;
+    return run_phase(tn);
+}
+
+// Single elimination: byes in the first round bring the field to a
+// power of two, then winners meet in draw order
+static int bracket(Tournament *tn, TournamentMatch *matches, uint32_t *stages) {
+    int n = tn->num_teams;
+    int *alive = malloc(n * sizeof(int));
+    if (!alive) {
+        perror("malloc failed");
+        return -1;
+    }
+
+    // Seeded random draw
+    unsigned int draw_seed = tn->base_seed;
+    for (int i = 0; i < n; i++) {
+        alive[i] = i;
+    }
+    for (int i = n - 1; i > 0; i--) {
+        int j = rand_r(&draw_seed) % (i + 1);
+        int swap = alive[i]; alive[i] = alive[j]; alive[j] = swap;
+    }
+
+    int field = 1;
+    while (field < n)
+        field *= 2;
+    int byes = field - n;
+
+    int count = 0, stage = 1, num_alive = n, rc = 0;
+    while (num_alive > 1 && rc == 0) {
+        int skip = (stage == 1) ? byes : 0;
+        int first = count;
+        for (int i = skip; i + 1 < num_alive; i += 2) {
+            TournamentMatch *tm = &matches[count];
+            tm->match_id = (uint32_t)count;
+            tm->stage    = (uint16_t)stage;
+            tm->team[0]  = (uint32_t)alive[i];
+            tm->team[1]  = (uint32_t)alive[i + 1];
+            count++;
+        }
+        for (int i = 0; i < skip; i++) {
+            tn->teams[alive[i]].stage_reached = (uint16_t)stage;
+        }
+
+        tn->phase = matches + first;
+        tn->phase_count = count - first;
+        rc = run_phase(tn);
+
+        // Teams with a bye first, then the winners in match order
+        int next = skip;
+        for (int i = first; i < count; i++) {
+            alive[next++] = (int)matches[i].team[matches[i].winner];
+        }
+        num_alive = next;
+        stage++;
+    }
+    if (rc == 0)
+        tn->teams[alive[0]].stage_reached = (uint16_t)stage;
+    free(alive);
+    *stages = (uint32_t)(stage - 1);
+    return rc;
+}
+
+// --------------------------------------------------------------------
+// Results
+// --------------------------------------------------------------------
+static int write_results(const char *out_path, const TournamentFileHeader *hdr,
+                         const TournamentTeam *ranking, const TournamentMatch *matches) {
+    FILE *f = fopen(out_path, "wb");
+    if (!f) {
+        perror("Error opening tournament result file");
+        return -1;
+    }
+    int ok = fwrite(hdr, sizeof(*hdr), 1, f) == 1 &&
+             fwrite(ranking, sizeof(TournamentTeam), hdr->num_teams, f) == hdr->num_teams &&
+             fwrite(matches, sizeof(TournamentMatch), hdr->match_count, f) == hdr->match_count;
+    if (fclose(f) != 0)
+        ok = 0;
+    if (!ok) {
+        perror("Error writing tournament result file");
+        return -1;
+    }
+    return 0;
+}
+
+static void print_ranking(const Tournament *tn, const TournamentTeam *ranking, uint32_t stages) {
+    int shown = tn->num_teams < 10 ? tn->num_teams : 10;
+    printf("Rank  Team    Bias  W-L-T          Rounds        %s\n",
+           tn->format == TOURNAMENT_BRACKET ? "Reached" : "Points");
+    for (int i = 0; i < shown; i++) {
+        const TournamentTeam *t = &ranking[i];
+        char record[32], rounds[32];
+        snprintf(record, sizeof(record), "%u-%u-%u", t->wins, t->losses, t->ties);
+        snprintf(rounds, sizeof(rounds), "%u:%u", t->rounds_won, t->rounds_lost);
+        printf("%4u  %-6u  %4d  %-13s  %-12s  ", t->rank, t->team + 1, t->energy_bias,
+               record, rounds);
+        if (tn->format == TOURNAMENT_ROUND_ROBIN)
+            printf("%u\n", t->points);
+        else if (t->stage_reached > stages)
+            printf("champion\n");
+        else
+            printf("round %u of %u\n", t->stage_reached, stages);
+    }
+    if (shown < tn->num_teams)
+        printf("... %d more\n", tn->num_teams - shown);
+}
+
+int run_tournament(TournamentFormat format, const char *out_path, unsigned int base_seed,
+                   const char *trace_dir) {
+    int n = config.num_teams;
+    if (n < 2 || n > TOURNAMENT_MAX_TEAMS) {
+        fprintf(stderr, "A tournament needs 2 to %d teams (num_teams=%d)\n",
+                TOURNAMENT_MAX_TEAMS, n);
+        return -1;
+    }
+
+    Tournament tn;
+    memset(&tn, 0, sizeof(tn));
+    tn.match_cfg = config;
+    tn.match_cfg.num_teams = NUM_TEAMS;
+    tn.format    = format;
+    tn.num_teams = n;
+    tn.base_seed = base_seed;
+    tn.trace_dir = trace_dir;
+    tn.total_matches = (format == TOURNAMENT_BRACKET) ? n - 1 : (int)((long)n * (n - 1) / 2);
+    tn.next_report = (tn.total_matches + 9) / 10;
+
+    // One worker per online CPU
+    long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    tn.num_workers = num_workers < 1 ? 1 : (int)num_workers;
+
+    tn.teams = calloc(n, sizeof(TournamentTeam));
+    TournamentMatch *matches = calloc(tn.total_matches, sizeof(TournamentMatch));
+    if (!tn.teams || !matches) {
+        fprintf(stderr, "Not enough memory for %d matches\n", tn.total_matches);
+        free(tn.teams);
+        free(matches);
+        return -1;
+    }
+
+    // Every team's strength is fixed for the whole tournament
+    for (int t = 0; t < n; t++) {
+        tn.teams[t].team = (uint32_t)t;
+        tn.teams[t].energy_bias = (int32_t)(batch_match_seed(~base_seed, (uint32_t)t) % 20);
+    }
+    pthread_mutex_init(&tn.lock, NULL);
+
+    printf("=== TOURNAMENT: %d teams, %s, %d matches on %d thread(s) ===\n", n,
+           format == TOURNAMENT_BRACKET ? "bracket" : "round robin", tn.total_matches,
+           tn.num_workers);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t stages = 0;
+    int rc = (format == TOURNAMENT_BRACKET) ? bracket(&tn, matches, &stages)
+                                            : round_robin(&tn, matches, &stages);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pthread_mutex_destroy(&tn.lock);
+    if (rc != 0) {
+        free(tn.teams);
+        free(matches);
+        return -1;
+    }
+
+    // Final ranking
+    TournamentTeam *ranking = malloc(n * sizeof(TournamentTeam));
+    if (!ranking) {
+        perror("malloc failed");
+        free(tn.teams);
+        free(matches);
+        return -1;
+    }
+    memcpy(ranking, tn.teams, n * sizeof(TournamentTeam));
+    qsort(ranking, n, sizeof(TournamentTeam),
+          format == TOURNAMENT_BRACKET ? sort_bracket : sort_league);
+    for (int i = 0; i < n; i++) {
+        ranking[i].rank = (uint32_t)(i + 1);
+    }
+
+    double secs = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("=== TOURNAMENT COMPLETE ===\n");
+    printf("Matches: %d in %.3f s (%.0f matches/min)\n", tn.total_matches, secs,
+           secs > 0 ? tn.total_matches * 60.0 / secs : 0.0);
+    print_ranking(&tn, ranking, stages);
+    if (trace_dir) {
+        printf("Traces: %s/match_<id>.towt", trace_dir);
+        if (format == TOURNAMENT_BRACKET)
+            printf(", final in %s/match_%d.towt", trace_dir, tn.total_matches - 1);
+        printf("\n");
+        if (tn.traces_failed > 0)
+            fprintf(stderr, "%d matches could not be traced\n", tn.traces_failed);
+    }
+
+    TournamentFileHeader hdr;
+    memcpy(hdr.magic, TOURNAMENT_MAGIC, sizeof(hdr.magic));
+    hdr.version     = TOURNAMENT_VERSION;
+    hdr.format      = (uint32_t)format;
+    hdr.num_teams   = (uint32_t)n;
+    hdr.match_count = (uint32_t)tn.total_matches;
+    hdr.base_seed   = base_seed;
+    hdr.stages      = stages;
+    hdr.traced      = (trace_dir && tn.traces_failed == 0) ? 1 : 0;
+
+    rc = write_results(out_path, &hdr, ranking, matches);
+    if (rc == 0)
+        printf("Results written to %s\n", out_path);
+    free(ranking);
+    free(tn.teams);
+    free(matches);
+    return rc;
+}
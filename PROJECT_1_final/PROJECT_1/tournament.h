@@ -0,0 +1,93 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <stdint.h>
+
+// ----------------------------------------------------------
+// Tournament mode
+//  config.num_teams teams play two-team matches with the
+//  engine only, on a pool of threads (one per online CPU),
+//  like the batch runner. Every team has a fixed strength:
+//  the energy bias (0..19) its players start with, drawn from
+//  the base seed.
+//
+//  Round robin: every team meets every other team once; the
+//  pairings follow the circle method, one matchday after the
+//  other. A win is worth 3 points, a tie 1. Ranking: points,
+//  then round difference, then rounds won, then team number.
+//
+//  Bracket: single elimination over a seeded random draw. The
+//  first teams of the draw get a bye when the field is not a
+//  power of two. A tied match is replayed with a new seed
+//  (TOURNAMENT_REPLAYS times at most, then the team higher in
+//  the draw goes through). Ranking: how far a team got, then
+//  rounds won, then team number.
+//
+//  Finished matches are folded into the standings while the
+//  workers claim their next matches, so the table is current
+//  throughout; the leader is printed every tenth of the
+//  matches.
+//
+// Result file layout (little-endian, packed):
+//   TournamentFileHeader                  32 bytes
+//   TournamentTeam[num_teams]             32 bytes each, by rank
+//   TournamentMatch[match_count]          32 bytes each, by match_id
+//
+// A match is played again exactly by resetting a match to
+// its seed with the two teams' biases (engine_reset_match_teams).
+// With a trace directory every match also leaves a tick trace
+// in DIR/match_<match_id>.towt (see tick_trace.h), which
+// --replay plays back.
+// ----------------------------------------------------------
+
+#define TOURNAMENT_MAGIC   "TOWL"
+#define TOURNAMENT_VERSION 1
+#define TOURNAMENT_REPLAYS 3        // Replays of a tied bracket match
+
+typedef enum {
+    TOURNAMENT_ROUND_ROBIN = 0,
+    TOURNAMENT_BRACKET     = 1
+} TournamentFormat;
+
+typedef struct {
+    char     magic[4];       // "TOWL"
+    uint32_t version;        // TOURNAMENT_VERSION
+    uint32_t format;         // TournamentFormat
+    uint32_t num_teams;
+    uint32_t match_count;
+    uint32_t base_seed;
+    uint32_t stages;         // Matchdays, or bracket rounds
+    uint32_t traced;         // 1 if every match has a tick trace
+} TournamentFileHeader;
+
+typedef struct {
+    uint32_t team;           // 0-based team number
+    uint32_t rank;           // 1 = winner
+    int32_t  energy_bias;    // Strength of the team
+    uint16_t wins;
+    uint16_t losses;
+    uint16_t ties;
+    uint16_t stage_reached;  // Bracket: last round played (stages + 1 = champion)
+    uint32_t points;         // Round robin: 3 per win, 1 per tie
+    uint32_t rounds_won;
+    uint32_t rounds_lost;
+} TournamentTeam;
+
+typedef struct {
+    uint32_t match_id;       // Also names the trace, match_<match_id>.towt
+    uint16_t stage;          // Matchday or bracket round, from 1
+    uint16_t replays;        // Tied bracket games played before this one
+    uint32_t team[2];        // Team on each end of the rope
+    uint32_t seed;           // Seed of the game that counted
+    int16_t  winner;         // 0 or 1 (index into team), -1 for a tie
+    uint16_t rounds_won[2];
+    uint16_t reserved;
+    float    duration;       // Game seconds until the match was decided
+} TournamentMatch;
+
+// Play a tournament between config.num_teams teams and write the result
+// file; trace_dir may be NULL. Returns 0 on success, -1 on error.
+int run_tournament(TournamentFormat format, const char *out_path, unsigned int base_seed,
+                   const char *trace_dir);
+
+#endif /* TOURNAMENT_H */
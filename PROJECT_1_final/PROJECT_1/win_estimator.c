@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sched.h>
+#include <time.h>
+
+#include "win_estimator.h"
+
+// Linux scheduling class for work that only runs on an otherwise idle
+// CPU (sched.h only names it for _GNU_SOURCE)
+#ifndef SCHED_IDLE
+#define SCHED_IDLE 5
+#endif
+
+typedef struct {
+    WinEstimator *we;
+    int index;
+} WorkerArg;
+
+static double thread_cpu_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Chances from the rollouts so far; called with the lock held
+static void publish(WinEstimator *we) {
+    double n = we->rollouts;
+    double p = we->wins[0] / n;
+
+    // Wilson score interval, z = 1.96
+    double z2 = 1.96 * 1.96;
+    double centre = (p + z2 / (2 * n)) / (1 + z2 / n);
+    double half = 1.96 * sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+
+    WinEstimate est;
+    memset(&est, 0, sizeof(est));
+    est.rollouts = we->rollouts;
+    for (int t = 0; t < NUM_TEAMS; t++) {
+        est.p_win[t] = (float)(we->wins[t] / n);
+    }
+    est.p_tie   = (float)(we->ties / n);
+    est.ci_low  = (float)(centre - half);
+    est.ci_high = (float)(centre + half);
+    est.game_seconds = we->latest_seconds;
+    est.rollouts_per_core_sec = we->cpu_seconds > 0 ? (float)(we->total_rollouts / we->cpu_seconds) : 0.0f;
+    shared_state_write_estimate(we->ss, &est);
+}
+
+static void *estimator_worker(void *arg) {
+    WinEstimator *we = ((WorkerArg *)arg)->we;
+    unsigned int seed = 0x9e3779b9u * (unsigned int)(((WorkerArg *)arg)->index + 1);
+    free(arg);
+
+    // Rollouts only get the CPU time nobody else wants
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &sp);
+
+    Match base, roll;
+    if (engine_init_match(&base, we->latest.cfg, 0, 0) != 0)
+        return NULL;
+    if (engine_init_match(&roll, we->latest.cfg, 0, 0) != 0) {
+        engine_free_match(&base);
+        return NULL;
+    }
+
+    uint32_t have = 0;                      // Version base holds
+    pthread_mutex_lock(&we->lock);
+    for (;;) {
+        // Work: a newer state, or more rollouts wanted of this one
+        while (!we->closed &&
+               (we->version == 0 || (we->version == have && we->rollouts >= ESTIMATOR_ROLLOUTS))) {
+            we->idle++;
+            pthread_cond_wait(&we->wake, &we->lock);
+            we->idle--;
+        }
+        if (we->closed)
+            break;
+        if (we->version != have) {
+            engine_copy_state(&base, &we->latest);
+            have = we->version;
+        }
+        pthread_mutex_unlock(&we->lock);
+
+        uint32_t wins[NUM_TEAMS] = {0, 0}, ties = 0;
+        double cpu = thread_cpu_seconds();
+        for (int k = 0; k < ESTIMATOR_BATCH; k++) {
+            engine_fork_match(&roll, &base, rand_r(&seed));
+            int winner = engine_finish_match(&roll);
+            if (winner < 0)
+                ties++;
+            else
+                wins[winner]++;
+        }
+        cpu = thread_cpu_seconds() - cpu;
+
+        pthread_mutex_lock(&we->lock);
+        we->total_rollouts += ESTIMATOR_BATCH;
+        we->cpu_seconds += cpu;
+        if (have == we->version) {
+            for (int t = 0; t < NUM_TEAMS; t++) {
+                we->wins[t] += wins[t];
+            }
+            we->ties += ties;
+            we->rollouts += ESTIMATOR_BATCH;
+            if (we->rollouts >= ESTIMATOR_MIN_ROLLOUTS)
+                publish(we);
+        }
+    }
+    pthread_mutex_unlock(&we->lock);
+
+    engine_free_match(&base);
+    engine_free_match(&roll);
+    return NULL;
+}
+
+int win_estimator_start(WinEstimator *we, SharedState *ss, const GameConfig *cfg,
+                        int num_workers) {
+    memset(we, 0, sizeof(*we));
+    we->ss = ss;
+    if (engine_init_match(&we->latest, cfg, 0, 0) != 0) {
+        fprintf(stderr, "Win estimator: out of memory\n");
+        return -1;
+    }
+    we->workers = calloc(num_workers, sizeof(pthread_t));
+    if (!we->workers) {
+        engine_free_match(&we->latest);
+        return -1;
+    }
+    pthread_mutex_init(&we->lock, NULL);
+    pthread_cond_init(&we->wake, NULL);
+
+    for (int i = 0; i < num_workers; i++) {
+        WorkerArg *arg = malloc(sizeof(*arg));
+        if (!arg)
+            break;
+        arg->we = we;
+        arg->index = i;
+        if (pthread_create(&we->workers[i], NULL, estimator_worker, arg) != 0) {
+            free(arg);
+            break;
+        }
+        we->num_workers++;
+    }
+    if (we->num_workers == 0) {
+        fprintf(stderr, "Win estimator: no worker threads\n");
+        win_estimator_stop(we);
+        return -1;
+    }
+    return 0;
+}
+
+void win_estimator_post(WinEstimator *we, const Match *m, float game_seconds) {
+    if (!we->workers)
+        return;
+    if (pthread_mutex_trylock(&we->lock) != 0) {
+        we->posts_skipped++;
+        return;
+    }
+    engine_copy_state(&we->latest, m);
+    we->latest_seconds = game_seconds;
+    we->version++;
+    we->wins[0] = we->wins[1] = 0;
+    we->ties = 0;
+    we->rollouts = 0;
+    we->posts++;
+    if (we->idle > 0)
+        pthread_cond_broadcast(&we->wake);
+    pthread_mutex_unlock(&we->lock);
+}
+
+void win_estimator_stop(WinEstimator *we) {
+    if (!we->workers)
+        return;
+    pthread_mutex_lock(&we->lock);
+    we->closed = 1;
+    pthread_cond_broadcast(&we->wake);
+    pthread_mutex_unlock(&we->lock);
+    for (int i = 0; i < we->num_workers; i++) {
+        pthread_join(we->workers[i], NULL);
+    }
+
+    if (we->num_workers > 0) {
+        printf("\n=== WIN ESTIMATOR ===\n");
+        printf("Rollouts: %llu on %d thread(s), %.0f per second per core\n",
+               (unsigned long long)we->total_rollouts, we->num_workers,
+               we->cpu_seconds > 0 ? we->total_rollouts / we->cpu_seconds : 0.0);
+        printf("States posted: %llu, skipped while busy: %llu\n",
+               (unsigned long long)we->posts, (unsigned long long)we->posts_skipped);
+    }
+
+    pthread_mutex_destroy(&we->lock);
+    pthread_cond_destroy(&we->wake);
+    engine_free_match(&we->latest);
+    free(we->workers);
+    we->workers = NULL;
+}
@@ -0,0 +1,68 @@
+#ifndef WIN_ESTIMATOR_H
+#define WIN_ESTIMATOR_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "engine.h"
+#include "shared_state.h"
+
+// ----------------------------------------------------------
+// Live win-probability estimator
+//  Every few ticks the referee hands the state of the match
+//  (players, rope, score, clock) to the estimator: a copy of
+//  the roster under a trylock, skipped if a worker holds the
+//  lock. Worker threads, at SCHED_IDLE so they only run on
+//  time the referee and the players leave, play the rest of
+//  the match from that state up to ESTIMATOR_ROLLOUTS times
+//  with the engine, each rollout with its own random falls
+//  (engine_fork_match), and count who wins.
+//
+//  Once ESTIMATOR_MIN_ROLLOUTS of the latest state are in,
+//  the chances and a 95% Wilson interval for Team 1 go to
+//  SharedState.win_estimate after every batch; the viewer
+//  draws them. Rollouts of an older state are dropped.
+// ----------------------------------------------------------
+
+#define ESTIMATOR_POST_TICKS    2       // Ticks between states handed over
+#define ESTIMATOR_ROLLOUTS      4096    // Rollouts per state, at most
+#define ESTIMATOR_MIN_ROLLOUTS  256     // Before an estimate is published
+#define ESTIMATOR_BATCH         32      // Rollouts between lock takes
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;               // New state posted
+    SharedState *ss;
+    pthread_t   *workers;               // NULL when the estimator is off
+    int          num_workers;
+    int          idle;                  // Workers waiting for a state
+    int          closed;
+
+    // Latest state from the referee
+    Match    latest;
+    float    latest_seconds;
+    uint32_t version;                   // Bumped by every post, 0 = none yet
+
+    // Rollouts of that state so far
+    uint32_t wins[NUM_TEAMS];
+    uint32_t ties;
+    uint32_t rollouts;
+
+    // Throughput
+    uint64_t total_rollouts;
+    double   cpu_seconds;               // Worker thread CPU time spent rolling out
+    uint64_t posts;
+    uint64_t posts_skipped;             // Lock busy when the referee came by
+} WinEstimator;
+
+// Start num_workers rollout threads for matches played with cfg.
+// Returns 0 on success; an estimator that failed to start ignores posts.
+int  win_estimator_start(WinEstimator *we, SharedState *ss, const GameConfig *cfg,
+                         int num_workers);
+
+// Referee side: hand over the state at the start of tick m->ticks. Never blocks.
+void win_estimator_post(WinEstimator *we, const Match *m, float game_seconds);
+
+// Stop the workers and print the throughput
+void win_estimator_stop(WinEstimator *we);
+
+#endif /* WIN_ESTIMATOR_H */